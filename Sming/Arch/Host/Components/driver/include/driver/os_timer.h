@@ -24,13 +24,13 @@ typedef void os_timer_func_t(void* timer_arg);
 
 /**
  * @brief This is the structure used by the Espressif timer API
- * @note This is used as an element in a linked list
- * The Espressif implementation orders the list according to next expiry time.
+ * @note The Espressif implementation uses this as an element in a linked list,
+ * ordered according to next expiry time.
+ * The Host emulation instead queues armed timers in a binary heap.
  * os_timer_setfn and os_timer_disarm set timer_next to -1
- * When expired, timer_next is 0
  */
 struct os_timer_t {
-	/// If disarmed, set to -1, otherwise points to the next queued timer (or NULL if last in the list)
+	/// If disarmed, set to -1, otherwise NULL
 	struct os_timer_t* timer_next;
 	/// Set to the next Timer2 count value when the timer will expire
 	uint32_t timer_expire;
@@ -40,6 +40,8 @@ struct os_timer_t {
 	os_timer_func_t* timer_func;
 	/// Argument passed to the callback function
 	void* timer_arg;
+	/// Position in timer queue, valid only when armed
+	uint32_t timer_index;
 };
 
 void os_timer_arm_ticks(os_timer_t* ptimer, uint32_t ticks, bool repeat_flag);
@@ -3,31 +3,94 @@
 #include <driver/hw_timer.h>
 #include <muldiv.h>
 #include <cassert>
+#include <vector>
 
 namespace
 {
-os_timer_t* timer_list;
+/*
+ * Armed timers are kept in a binary min-heap ordered by expiry time,
+ * so arming and disarming are O(log n). Each timer records its heap position.
+ */
+std::vector<os_timer_t*> timer_heap;
 CMutex mutex;
 
-// Called with mutex locked
-void timer_insert(uint32_t expire, os_timer_t* ptimer)
+os_timer_t* const TIMER_DISARMED = reinterpret_cast<os_timer_t*>(-1);
+
+bool is_earlier(const os_timer_t* t1, const os_timer_t* t2)
+{
+	return int(t1->timer_expire - t2->timer_expire) < 0;
+}
+
+void heap_set(unsigned index, os_timer_t* ptimer)
 {
-	os_timer_t* t_prev = nullptr;
-	auto t = timer_list;
-	while(t != nullptr) {
-		if(int(t->timer_expire - expire) > 0) {
+	timer_heap[index] = ptimer;
+	ptimer->timer_index = index;
+}
+
+void sift_up(unsigned index)
+{
+	auto ptimer = timer_heap[index];
+	while(index > 0) {
+		auto parent = (index - 1) / 2;
+		if(!is_earlier(ptimer, timer_heap[parent])) {
 			break;
 		}
-		t_prev = t;
-		t = t->timer_next;
+		heap_set(index, timer_heap[parent]);
+		index = parent;
 	}
-	if(t_prev == nullptr) {
-		timer_list = ptimer;
-	} else {
-		t_prev->timer_next = ptimer;
+	heap_set(index, ptimer);
+}
+
+void sift_down(unsigned index)
+{
+	auto ptimer = timer_heap[index];
+	auto count = timer_heap.size();
+	for(;;) {
+		auto child = 2 * index + 1;
+		if(child >= count) {
+			break;
+		}
+		if(child + 1 < count && is_earlier(timer_heap[child + 1], timer_heap[child])) {
+			++child;
+		}
+		if(!is_earlier(timer_heap[child], ptimer)) {
+			break;
+		}
+		heap_set(index, timer_heap[child]);
+		index = child;
 	}
-	ptimer->timer_next = t;
+	heap_set(index, ptimer);
+}
+
+// Called with mutex locked
+void timer_insert(uint32_t expire, os_timer_t* ptimer)
+{
 	ptimer->timer_expire = expire;
+	ptimer->timer_next = nullptr;
+	timer_heap.push_back(ptimer);
+	sift_up(timer_heap.size() - 1);
+}
+
+// Called with mutex locked
+bool timer_remove(os_timer_t* ptimer)
+{
+	auto index = ptimer->timer_index;
+	// Timer structures may not have been initialised, so check it's actually queued
+	if(index >= timer_heap.size() || timer_heap[index] != ptimer) {
+		return false;
+	}
+
+	auto last = timer_heap.back();
+	timer_heap.pop_back();
+	if(last != ptimer) {
+		heap_set(index, last);
+		if(index > 0 && is_earlier(last, timer_heap[(index - 1) / 2])) {
+			sift_up(index);
+		} else {
+			sift_down(index);
+		}
+	}
+	return true;
 }
 
 } // namespace
@@ -37,14 +100,17 @@ void os_timer_arm_ticks(os_timer_t* ptimer, uint32_t ticks, bool repeat_flag)
 	assert(ptimer != nullptr);
 	//	assert(time <= MAX_OS_TIMER_INTERVAL_US);
 
-	os_timer_disarm(ptimer);
-	ptimer->timer_period = repeat_flag ? ticks : 0;
 	mutex.lock();
+	if(ptimer->timer_next != TIMER_DISARMED) {
+		timer_remove(ptimer);
+	}
+	ptimer->timer_period = repeat_flag ? ticks : 0;
 	timer_insert(hw_timer2_read() + ticks, ptimer);
+	bool isNext = (timer_heap[0] == ptimer);
 	mutex.unlock();
 
 	// Kick main thread (which services timers) if we're due next
-	if(timer_list == ptimer) {
+	if(isNext) {
 		host_thread_kick();
 	}
 }
@@ -67,27 +133,13 @@ void os_timer_disarm(struct os_timer_t* ptimer)
 {
 	assert(ptimer != nullptr);
 
-	if(intptr_t(ptimer->timer_next) == -1) {
+	if(ptimer->timer_next == TIMER_DISARMED) {
 		return;
 	}
 
 	mutex.lock();
-	if(timer_list != nullptr) {
-		// Remove timer from list
-		if(ptimer == timer_list) {
-			timer_list = ptimer->timer_next;
-		} else {
-			auto t = timer_list;
-			while(t->timer_next != nullptr) {
-				if(t->timer_next == ptimer) {
-					t->timer_next = ptimer->timer_next;
-					break;
-				}
-				t = t->timer_next;
-			}
-		}
-		ptimer->timer_next = reinterpret_cast<os_timer_t*>(-1);
-	}
+	timer_remove(ptimer);
+	ptimer->timer_next = TIMER_DISARMED;
 	mutex.unlock();
 }
 
@@ -108,23 +160,25 @@ void os_timer_done(struct os_timer_t* ptimer)
 
 int host_service_timers()
 {
-	if(timer_list == nullptr) {
+	mutex.lock();
+	if(timer_heap.empty()) {
+		mutex.unlock();
 		return -1;
 	}
 
 	auto ticks_now = hw_timer2_read();
-	auto t = timer_list;
+	auto t = timer_heap[0];
 	int ticks = t->timer_expire - ticks_now;
 	if(ticks > 0) {
+		mutex.unlock();
 		// Return milliseconds until timer due
 		using R = std::ratio<1000, HW_TIMER2_CLK>;
 		return muldiv<R::num, R::den>(unsigned(ticks));
 	}
 
-	mutex.lock();
 	// Pop timer from queue
-	timer_list = t->timer_next;
-	t->timer_next = reinterpret_cast<os_timer_t*>(-1);
+	timer_remove(t);
+	t->timer_next = TIMER_DISARMED;
 	// Repeating timer?
 	if(t->timer_period != 0) {
 		timer_insert(t->timer_expire + t->timer_period, t);
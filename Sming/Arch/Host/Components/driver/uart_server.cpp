@@ -173,7 +173,7 @@ void startup(const Config& config)
 		} else {
 			server = std::make_unique<CUartDevice>(i, devname, config.baud[i]);
 		}
-		server->execute();
+		server->start();
 	}
 
 	// Redirect port 0 to console if not otherwise enabled
@@ -204,9 +204,17 @@ CUart::CUart(unsigned uart_nr) : CThread("uart", 1), uart_nr(uart_nr)
 {
 }
 
+void CUart::start()
+{
+	execute();
+}
+
 void CUart::terminate()
 {
-	join();
+	// Thread isn't used if serviced by reactor
+	if(irqContext == this) {
+		join();
+	}
 	host_debug_i("UART%u server destroyed", uart_nr);
 }
 
@@ -224,7 +232,7 @@ void CUart::onNotify(smg_uart_t* uart, smg_uart_notify_code_t code)
 	case UART_NOTIFY_AFTER_WRITE: {
 		if(this->uart != nullptr) {
 			// Kick the thread to send now
-			txsem.post();
+			txPending();
 		} else {
 			// Not connected, discard data
 			uart->tx_buffer->clear();
@@ -249,7 +257,7 @@ int CUart::serviceRead()
 		return avail;
 	}
 
-	interrupt_begin();
+	irqContext->interrupt_begin();
 
 	int space = uart->rx_buffer->getFreeSpace();
 	if(space < avail) {
@@ -272,7 +280,7 @@ int CUart::serviceRead()
 		}
 	}
 
-	interrupt_end();
+	irqContext->interrupt_end();
 
 	return read;
 }
@@ -291,7 +299,7 @@ int CUart::serviceWrite()
 		return 0;
 	}
 
-	interrupt_begin();
+	irqContext->interrupt_begin();
 
 	do {
 		int sent = writeBytes(data, avail);
@@ -307,10 +315,10 @@ int CUart::serviceWrite()
 	if(txbuf->isEmpty()) {
 		uart->status |= UART_STATUS_TXFIFO_EMPTY;
 	} else {
-		txsem.post();
+		txPending();
 	}
 
-	interrupt_end();
+	irqContext->interrupt_end();
 
 	return result;
 }
@@ -321,12 +329,156 @@ CUartPort::CUartPort(unsigned uart_nr) : CUart(uart_nr)
 {
 }
 
+void CUartPort::start()
+{
+	auto reactor = CReactor::instance();
+	if(reactor == nullptr) {
+		CUart::start();
+		return;
+	}
+
+	irqContext = reactor;
+	if(!open()) {
+		return;
+	}
+
+	watch_connections([this](CSocket* skt) { onConnect(skt); });
+}
+
 void CUartPort::terminate()
 {
 	close();
+	socket = nullptr;
 	CUart::terminate();
 }
 
+bool CUartPort::open()
+{
+	auto port = portBase + uart_nr;
+	CSockAddr addr(nullptr, port);
+	if(!listen(addr, 1)) {
+		host_debug_e("Listen %s failed", addr.text().c_str());
+		return false;
+	}
+
+	host_debug_i("UART%u server listening on port %u", uart_nr, port);
+	return true;
+}
+
+void CUartPort::onNotify(smg_uart_t* uart, smg_uart_notify_code_t code)
+{
+	CUart::onNotify(uart, code);
+
+	if(irqContext == this) {
+		return;
+	}
+
+	switch(code) {
+	case UART_NOTIFY_AFTER_OPEN:
+	case UART_NOTIFY_BEFORE_CLOSE:
+		updateEvents();
+		break;
+
+	case UART_NOTIFY_BEFORE_READ:
+		// Application is reading so resume receive if it was paused
+		updateEvents(true);
+		break;
+
+	case UART_NOTIFY_AFTER_WRITE:
+	case UART_NOTIFY_WAIT_TX:
+		break;
+	}
+}
+
+void CUartPort::txPending()
+{
+	if(irqContext == this) {
+		CUart::txPending();
+	} else {
+		updateEvents();
+	}
+}
+
+/*
+ * Determine which socket events are of interest from UART state.
+ *
+ * Must be called with main thread either running (from a notification) or suspended (interrupt context)
+ * so that buffer state cannot change during the call.
+ */
+void CUartPort::updateEvents(bool reading)
+{
+	auto skt = socket;
+	if(skt == nullptr) {
+		return;
+	}
+
+	unsigned events{0};
+	if(uart != nullptr) {
+		// Stop receiving when buffer is full, otherwise we'd be continually notified
+		if(smg_uart_rx_enabled(uart) && (reading || uart->rx_buffer->getFreeSpace() != 0)) {
+			events |= REACTOR_EVENT_READ;
+		}
+		if(smg_uart_tx_enabled(uart) && !uart->tx_buffer->isEmpty()) {
+			events |= REACTOR_EVENT_WRITE;
+		}
+	}
+	skt->watch(events);
+}
+
+void CUartPort::onConnect(CSocket* skt)
+{
+	host_debug_i("Uart #%u socket open", uart_nr);
+
+	socket = skt;
+	skt->watch(REACTOR_EVENT_READ | REACTOR_EVENT_WRITE, [this](unsigned events) { onSocketEvent(events); });
+}
+
+void CUartPort::onSocketEvent(unsigned events)
+{
+	bool closed = (events & REACTOR_EVENT_CLOSED);
+	if((events & REACTOR_EVENT_READ) && socket->available() <= 0) {
+		// Readable with no data means client has gone
+		closed = true;
+	}
+
+	int res{0};
+	if(events & REACTOR_EVENT_WRITE) {
+		res = serviceWrite();
+	}
+	if(res >= 0 && (events & REACTOR_EVENT_READ)) {
+		res = serviceRead();
+	}
+
+	// Detach socket whilst main thread is suspended
+	auto skt = socket;
+
+	irqContext->interrupt_begin();
+
+	if(res < 0 || closed) {
+		socket = nullptr;
+	} else {
+		updateEvents();
+	}
+
+	if(uart != nullptr) {
+		auto status = uart->status;
+		uart->status = 0;
+		if(status != 0 && uart->callback != nullptr) {
+			uart->callback(uart, status);
+		}
+	}
+
+	irqContext->interrupt_end();
+
+	if(socket == nullptr) {
+		skt->close();
+		host_debug_i("Uart #%u socket closed", uart_nr);
+
+		// Accept another connection
+		resume_connections();
+	}
+}
+
 int CUartPort::available()
 {
 	return socket ? socket->available() : 0;
@@ -344,15 +496,10 @@ int CUartPort::writeBytes(const void* data, size_t size)
 
 void* CUartPort::thread_routine()
 {
-	auto port = portBase + uart_nr;
-	CSockAddr addr(nullptr, port);
-	if(!listen(addr, 1)) {
-		host_debug_e("Listen %s failed", addr.text().c_str());
+	if(!open()) {
 		return nullptr;
 	}
 
-	host_debug_i("UART%u server listening on port %u", uart_nr, port);
-
 	while(active()) {
 		socket = try_connect();
 		if(socket == nullptr) {
@@ -21,6 +21,7 @@
 
 #include <driver/uart.h>
 #include <hostlib/sockets.h>
+#include <hostlib/reactor.h>
 #include <hostlib/threads.h>
 #include <memory>
 
@@ -51,7 +52,7 @@ void shutdown();
 /*
  * Base class for a UART
  *
- * Each server allocates a thread to handle one device.
+ * Each server allocates a thread to handle one device, unless it can be serviced by the I/O reactor.
  * If no client (i.e. application `uart`) is connected any output is discarded.
  *
  */
@@ -60,6 +61,11 @@ class CUart : public CThread
 public:
 	CUart(unsigned uart_nr);
 
+	/**
+	 * @brief Start servicing the port
+	 */
+	virtual void start();
+
 	virtual void terminate();
 
 	virtual void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code);
@@ -73,32 +79,57 @@ protected:
 	int serviceRead();
 	int serviceWrite();
 
+	/**
+	 * @brief Called when there's data to be sent out
+	 */
+	virtual void txPending()
+	{
+		txsem.post();
+	}
+
 	CSemaphore txsem;			///< Signals when there's data to be sent out
 	unsigned uart_nr;			///< Which port we represent
 	smg_uart_t* uart = nullptr; ///< On set if port is open by application
+	CThread* irqContext{this};	///< Thread which raises interrupts, the reactor if not using our own
 };
 
 /*
  * UART implementation using TCP socket for communication, so we can use telnet as a terminal application.
+ *
+ * The listening and client sockets are serviced by the I/O reactor where available.
  */
 class CUartPort : public CUart, public CServerSocket
 {
 public:
 	CUartPort(unsigned uart_nr);
 
+	void start() override;
+
 	void terminate() override;
 
+	void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code) override;
+
 protected:
 	int available() override;
 	int readBytes(void* buffer, size_t size) override;
 	int writeBytes(const void* data, size_t size) override;
 	void* thread_routine() override;
+	void txPending() override;
+
+private:
+	bool open();
+	void onConnect(CSocket* skt);
+	void onSocketEvent(unsigned events);
+	void updateEvents(bool reading = false);
 
+protected:
 	CSocket* socket{nullptr}; ///< Connected client
 };
 
 /*
  * UART implementation using physical serial device on local machine
+ *
+ * Always uses a dedicated thread as the device handle is private to SerialLib.
  */
 class CUartDevice : public CUart
 {
@@ -36,6 +36,21 @@ typedef void (*host_task_callback_t)(os_param_t param);
 
 bool host_queue_callback(host_task_callback_t callback, os_param_t param);
 
+typedef struct {
+	uint16_t length;	 ///< Queue capacity
+	uint16_t count;		 ///< Number of events currently queued
+	uint16_t high_water; ///< Maximum number of events queued at any one time
+	uint32_t dropped;	 ///< Number of events which could not be posted because queue was full
+} host_task_queue_stats_t;
+
+/**
+ * @brief Get usage statistics for a task queue
+ * @param prio Queue priority, USER_TASK_PRIO_MAX for the internal host queue
+ * @param stats On success, contains statistics
+ * @retval bool false if queue not initialised
+ */
+bool host_get_task_queue_stats(uint8_t prio, host_task_queue_stats_t* stats);
+
 #ifdef __cplusplus
 }
 #endif
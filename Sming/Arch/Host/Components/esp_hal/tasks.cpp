@@ -2,52 +2,120 @@
 #include <hostlib/hostmsg.h>
 #include <stringutil.h>
 #include <hostlib/threads.h>
+#include <atomic>
 
 namespace
 {
+/*
+ * Bounded multi-producer, single-consumer queue.
+ *
+ * Events may be posted from any thread (e.g. interrupt emulation) without locking.
+ * Each slot carries a sequence number which tells producers and the consumer
+ * whether it is free or holds a published event.
+ */
 class TaskQueue
 {
 public:
-	TaskQueue(os_task_t callback, os_event_t* events, uint8_t length)
-		: callback(callback), events(events), length(length)
+	TaskQueue(os_task_t callback, uint8_t length) : callback(callback)
 	{
+		// Use power-of-2 capacity so positions remain consistent on wrap
+		capacity = 1;
+		while(capacity < length) {
+			capacity <<= 1;
+		}
+		slots = new Slot[capacity];
+		for(unsigned i = 0; i < capacity; ++i) {
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~TaskQueue()
+	{
+		delete[] slots;
 	}
 
 	bool post(os_signal_t sig, os_param_t par)
 	{
-		mutex.lock();
-		bool full = (count == length);
-		if(!full) {
-			events[(read + count) % length] = os_event_t{sig, par};
-			++count;
+		auto pos = tail.load(std::memory_order_relaxed);
+		for(;;) {
+			auto& slot = slots[pos & (capacity - 1)];
+			auto seq = slot.seq.load(std::memory_order_acquire);
+			int diff = int(seq - pos);
+			if(diff == 0) {
+				if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					slot.event = os_event_t{sig, par};
+					slot.seq.store(pos + 1, std::memory_order_release);
+					break;
+				}
+			} else if(diff < 0) {
+				++stats.dropped;
+				return false;
+			} else {
+				pos = tail.load(std::memory_order_relaxed);
+			}
 		}
-		mutex.unlock();
-		return !full;
+
+		// Approximate as consumer may be running
+		unsigned count = pos + 1 - head.load(std::memory_order_relaxed);
+		auto highWater = stats.high_water.load(std::memory_order_relaxed);
+		while(count > highWater && !stats.high_water.compare_exchange_weak(highWater, count)) {
+		}
+		return true;
 	}
 
 	void process()
 	{
 		// Don't service any newly queued events
-		for(unsigned n = count; n != 0; --n) {
-			mutex.lock();
-			auto evt = events[read];
-			read = (read + 1) % length;
-			--count;
-			mutex.unlock();
-			callback(&evt);
+		auto end = tail.load(std::memory_order_acquire);
+		auto pos = head.load(std::memory_order_relaxed);
+		while(pos != end) {
+			// Drain a batch to free up slots before invoking callbacks
+			os_event_t batch[16];
+			unsigned n = 0;
+			while(pos != end && n < ARRAY_SIZE(batch)) {
+				auto& slot = slots[pos & (capacity - 1)];
+				if(slot.seq.load(std::memory_order_acquire) != pos + 1) {
+					// Producer hasn't finished writing yet
+					end = pos;
+					break;
+				}
+				batch[n++] = slot.event;
+				slot.seq.store(pos + capacity, std::memory_order_release);
+				++pos;
+			}
+			head.store(pos, std::memory_order_release);
+
+			for(unsigned i = 0; i < n; ++i) {
+				callback(&batch[i]);
+			}
 		}
 	}
 
+	void getStats(host_task_queue_stats_t& info) const
+	{
+		info.length = capacity;
+		info.count = tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+		info.high_water = stats.high_water;
+		info.dropped = stats.dropped;
+	}
+
 private:
-	static CMutex mutex;
+	struct Slot {
+		std::atomic<uint32_t> seq;
+		os_event_t event;
+	};
+
 	os_task_t callback;
-	os_event_t* events;
-	uint8_t read{0};
-	uint8_t count{0};
-	uint8_t length;
+	Slot* slots;
+	unsigned capacity;
+	std::atomic<uint32_t> tail{0}; ///< Next position to be written by producers
+	std::atomic<uint32_t> head{0}; ///< Next position to be read by consumer
+	struct {
+		std::atomic<unsigned> high_water{0};
+		std::atomic<unsigned> dropped{0};
+	} stats;
 };
 
-CMutex TaskQueue::mutex;
 TaskQueue* task_queues[USER_TASK_PRIO_MAX + 1];
 
 const uint8_t HOST_TASK_PRIO = USER_TASK_PRIO_MAX;
@@ -66,7 +134,9 @@ bool system_os_task(os_task_t callback, uint8_t prio, os_event_t* events, uint8_
 		return false;
 	}
 
-	queue = new TaskQueue(callback, events, qlen);
+	// Events are stored internally
+	(void)events;
+	queue = new TaskQueue(callback, qlen);
 	return queue != nullptr;
 }
 
@@ -92,8 +162,6 @@ bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par)
 
 void host_init_tasks()
 {
-	static os_event_t events[32];
-
 	auto hostTaskCallback = [](os_event_t* event) {
 		auto callback = host_task_callback_t(event->sig);
 		if(callback != nullptr) {
@@ -101,7 +169,7 @@ void host_init_tasks()
 		}
 	};
 
-	task_queues[HOST_TASK_PRIO] = new TaskQueue(hostTaskCallback, events, ARRAY_SIZE(events));
+	task_queues[HOST_TASK_PRIO] = new TaskQueue(hostTaskCallback, 32);
 }
 
 void host_service_tasks()
@@ -118,3 +186,16 @@ bool host_queue_callback(host_task_callback_t callback, os_param_t param)
 {
 	return task_queues[HOST_TASK_PRIO]->post(os_signal_t(callback), param);
 }
+
+bool host_get_task_queue_stats(uint8_t prio, host_task_queue_stats_t* stats)
+{
+	if(prio > HOST_TASK_PRIO || stats == nullptr) {
+		return false;
+	}
+	auto queue = task_queues[prio];
+	if(queue == nullptr) {
+		return false;
+	}
+	queue->getStats(*stats);
+	return true;
+}
@@ -0,0 +1,262 @@
+/**
+ * reactor.cpp
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "reactor.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+CReactor* CReactor::reactor;
+
+namespace
+{
+#ifdef __linux__
+constexpr unsigned maxEvents{32};
+
+uint32_t getEpollEvents(unsigned events)
+{
+	uint32_t res{0};
+	if(events & REACTOR_EVENT_READ) {
+		res |= EPOLLIN | EPOLLRDHUP;
+	}
+	if(events & REACTOR_EVENT_WRITE) {
+		res |= EPOLLOUT;
+	}
+	if(events & REACTOR_EVENT_ONESHOT) {
+		res |= EPOLLONESHOT;
+	}
+	return res;
+}
+
+unsigned getReactorEvents(uint32_t events)
+{
+	unsigned res{0};
+	if(events & EPOLLIN) {
+		res |= REACTOR_EVENT_READ;
+	}
+	if(events & EPOLLOUT) {
+		res |= REACTOR_EVENT_WRITE;
+	}
+	if(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+		res |= REACTOR_EVENT_CLOSED;
+	}
+	return res;
+}
+#endif
+
+} // namespace
+
+bool CReactor::startup()
+{
+	if(reactor != nullptr) {
+		return true;
+	}
+
+	auto r = new CReactor;
+	if(!r->create() || !r->execute()) {
+		delete r;
+		return false;
+	}
+
+	reactor = r;
+	host_debug_i("I/O reactor started");
+	return true;
+}
+
+void CReactor::shutdown()
+{
+	auto r = reactor;
+	if(r == nullptr) {
+		return;
+	}
+
+	reactor = nullptr;
+	r->done = true;
+#ifdef __linux__
+	eventfd_write(r->wakefd, 1);
+#endif
+	r->join();
+	delete r;
+}
+
+bool CReactor::create()
+{
+#ifdef __linux__
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if(epfd < 0) {
+		host_debug_e("epoll_create1: %s", strerror(errno));
+		return false;
+	}
+
+	wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(wakefd < 0) {
+		host_debug_e("eventfd: %s", strerror(errno));
+		return false;
+	}
+
+	return control(EPOLL_CTL_ADD, wakefd, REACTOR_EVENT_READ);
+#else
+	return false;
+#endif
+}
+
+CReactor::~CReactor()
+{
+#ifdef __linux__
+	if(wakefd >= 0) {
+		::close(wakefd);
+	}
+	if(epfd >= 0) {
+		::close(epfd);
+	}
+#endif
+}
+
+bool CReactor::control([[maybe_unused]] int op, [[maybe_unused]] int fd, [[maybe_unused]] unsigned events)
+{
+#ifdef __linux__
+	struct epoll_event ev {
+	};
+	ev.events = getEpollEvents(events);
+	ev.data.fd = fd;
+	if(epoll_ctl(epfd, op, fd, &ev) == 0) {
+		return true;
+	}
+	host_debug_w("epoll_ctl(%d, %d): %s", op, fd, strerror(errno));
+#endif
+	return false;
+}
+
+bool CReactor::add(int fd, unsigned events, Callback callback)
+{
+	if(fd < 0 || !callback) {
+		return false;
+	}
+
+	mutex.lock();
+	bool res{false};
+	if(entries.find(fd) == entries.end()) {
+#ifdef __linux__
+		res = control(EPOLL_CTL_ADD, fd, events);
+#endif
+		if(res) {
+			entries[fd] = Entry{events, std::make_shared<Callback>(std::move(callback))};
+		}
+	}
+	mutex.unlock();
+
+	return res;
+}
+
+bool CReactor::modify(int fd, unsigned events)
+{
+	mutex.lock();
+	bool res{false};
+	auto it = entries.find(fd);
+	if(it != entries.end()) {
+#ifdef __linux__
+		res = control(EPOLL_CTL_MOD, fd, events);
+#endif
+		if(res) {
+			it->second.events = events;
+		}
+	}
+	mutex.unlock();
+
+	return res;
+}
+
+void CReactor::remove(int fd)
+{
+	mutex.lock();
+	auto it = entries.find(fd);
+	if(it != entries.end()) {
+#ifdef __linux__
+		control(EPOLL_CTL_DEL, fd, 0);
+#endif
+		entries.erase(it);
+	}
+	mutex.unlock();
+
+	// Wait for any callback in progress to complete
+	if(!isCurrent()) {
+		dispatchMutex.lock();
+		dispatchMutex.unlock();
+	}
+}
+
+unsigned CReactor::count()
+{
+	mutex.lock();
+	unsigned n = entries.size();
+	mutex.unlock();
+	return n;
+}
+
+void CReactor::dispatch(int fd, unsigned events)
+{
+	dispatchMutex.lock();
+
+	// Callback may have been removed since the event was reported
+	std::shared_ptr<Callback> callback;
+	mutex.lock();
+	auto it = entries.find(fd);
+	if(it != entries.end()) {
+		callback = it->second.callback;
+	}
+	mutex.unlock();
+
+	if(callback) {
+		(*callback)(events);
+	}
+
+	dispatchMutex.unlock();
+}
+
+void* CReactor::thread_routine()
+{
+#ifdef __linux__
+	struct epoll_event events[maxEvents];
+	while(!done) {
+		int n = epoll_wait(epfd, events, maxEvents, -1);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			host_debug_e("epoll_wait: %s", strerror(errno));
+			break;
+		}
+
+		for(int i = 0; i < n && !done; ++i) {
+			int fd = events[i].data.fd;
+			if(fd == wakefd) {
+				eventfd_t value;
+				eventfd_read(wakefd, &value);
+				continue;
+			}
+			dispatch(fd, getReactorEvents(events[i].events));
+		}
+	}
+#endif
+
+	return nullptr;
+}
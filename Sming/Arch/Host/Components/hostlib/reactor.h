@@ -0,0 +1,129 @@
+/**
+ * reactor.h - Single-threaded I/O event dispatcher for the Host Emulator
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "threads.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <map>
+
+// CReactor event flags
+#define REACTOR_EVENT_READ 0x01	   ///< Data available, or connection pending on a listening socket
+#define REACTOR_EVENT_WRITE 0x02   ///< Ready for writing
+#define REACTOR_EVENT_CLOSED 0x04  ///< Reported only: peer closed connection, or an error occurred
+#define REACTOR_EVENT_ONESHOT 0x08 ///< Disable after reporting; re-enable using `modify()`
+
+/**
+ * @brief Services all registered file descriptors from a single thread
+ *
+ * Callbacks run in the context of the reactor thread and are never invoked concurrently.
+ * They may use `interrupt_begin()` and `interrupt_end()` to run code in interrupt context,
+ * typically to post a task which wakes the main thread.
+ * The main thread is only woken if a callback has work for it to do.
+ *
+ * Requires epoll, so only available on Linux.
+ * Elsewhere `instance()` returns nullptr and callers must fall back to polling.
+ */
+class CReactor : public CThread
+{
+public:
+	/**
+	 * @brief Callback invoked when a registered file descriptor becomes ready
+	 * @param events Combination of REACTOR_EVENT_xxx flags
+	 */
+	using Callback = std::function<void(unsigned events)>;
+
+	/**
+	 * @brief Create the reactor thread
+	 * @retval bool false if not supported on this platform
+	 */
+	static bool startup();
+
+	/**
+	 * @brief Stop the reactor thread
+	 * @note Registered file descriptors are not closed
+	 */
+	static void shutdown();
+
+	/**
+	 * @brief Get the running reactor instance
+	 * @retval CReactor* nullptr if not available
+	 */
+	static CReactor* instance()
+	{
+		return reactor;
+	}
+
+	/**
+	 * @brief Register a file descriptor
+	 * @param fd
+	 * @param events Combination of REACTOR_EVENT_xxx flags
+	 * @param callback Invoked from the reactor thread
+	 * @retval bool
+	 */
+	bool add(int fd, unsigned events, Callback callback);
+
+	/**
+	 * @brief Change the events of interest for a file descriptor
+	 * @param fd
+	 * @param events New set of flags, 0 to disable
+	 * @retval bool false if fd not registered
+	 */
+	bool modify(int fd, unsigned events);
+
+	/**
+	 * @brief De-register a file descriptor
+	 * @param fd
+	 * @note On return the callback is guaranteed not to be running, unless called from the callback itself.
+	 * Must be called before closing the file descriptor.
+	 */
+	void remove(int fd);
+
+	/**
+	 * @brief Get number of registered file descriptors
+	 */
+	unsigned count();
+
+protected:
+	void* thread_routine() override;
+
+private:
+	struct Entry {
+		unsigned events;
+		std::shared_ptr<Callback> callback;
+	};
+
+	CReactor() : CThread("reactor", 1)
+	{
+	}
+
+	~CReactor();
+
+	bool create();
+	bool control(int op, int fd, unsigned events);
+	void dispatch(int fd, unsigned events);
+
+	static CReactor* reactor;
+	std::map<int, Entry> entries;  ///< Registered file descriptors
+	CMutex mutex;				   ///< Protects entries
+	CBasicMutex dispatchMutex;	   ///< Held whilst a callback is running
+	int epfd{-1};				   ///< epoll instance
+	int wakefd{-1};				   ///< eventfd used to stop thread
+	std::atomic<bool> done{false}; ///< Set to stop thread
+};
@@ -229,6 +229,7 @@ void CSocket::close()
 
 	host_debug_i("%s", addr().text().c_str());
 
+	unwatch();
 	socket_close(m_fd);
 	m_fd = 0;
 }
@@ -317,6 +318,39 @@ int CSocket::recv(void* buf, size_t n, int flags)
 	return ::recv(m_fd, (char*)buf, n, flags);
 }
 
+bool CSocket::watch(unsigned events, CReactor::Callback callback)
+{
+	auto reactor = CReactor::instance();
+	if(reactor == nullptr || m_fd <= 0) {
+		return false;
+	}
+
+	if(m_watched) {
+		reactor->remove(m_fd);
+	}
+	m_watched = reactor->add(m_fd, events, callback);
+	return m_watched;
+}
+
+bool CSocket::watch(unsigned events)
+{
+	auto reactor = CReactor::instance();
+	return m_watched && reactor != nullptr && reactor->modify(m_fd, events);
+}
+
+void CSocket::unwatch()
+{
+	if(!m_watched) {
+		return;
+	}
+
+	auto reactor = CReactor::instance();
+	if(reactor != nullptr) {
+		reactor->remove(m_fd);
+	}
+	m_watched = false;
+}
+
 /*
  * CSocketList
  */
@@ -370,7 +404,28 @@ void CSocketList::send(const void* data, size_t n, int flags)
 CSocket* CSocketList::recv(void* buf, size_t& n)
 {
 	lock();
+
+#ifndef __WIN32
+	// Check readiness of all sockets with one call, then only read from those with data
+	std::vector<struct pollfd> fds;
+	fds.reserve(size());
 	for(auto& skt : *this) {
+		fds.push_back({skt->active() ? skt->m_fd : -1, POLLIN, 0});
+	}
+	if(poll(fds.data(), fds.size(), 0) <= 0) {
+		unlock();
+		return nullptr;
+	}
+	unsigned index{0};
+#endif
+
+	for(auto& skt : *this) {
+#ifndef __WIN32
+		if(fds[index++].revents == 0) {
+			continue;
+		}
+#endif
+
 		if(!skt->active()) {
 			continue;
 		}
@@ -472,3 +527,20 @@ CSocket* CServerSocket::try_connect()
 	socket_close(fd);
 	return nullptr;
 }
+
+bool CServerSocket::watch_connections(ConnectCallback callback)
+{
+	return watch(REACTOR_EVENT_READ, [this, callback](unsigned) {
+		auto skt = try_connect();
+		if(skt == nullptr) {
+			return;
+		}
+
+		// Stop notifications until there's room for another client
+		if(m_clients.active() >= m_max_connections) {
+			watch(0);
+		}
+
+		callback(skt);
+	});
+}
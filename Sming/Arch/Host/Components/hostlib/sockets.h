@@ -20,7 +20,7 @@
 #pragma once
 
 #include "include/hostlib/hostlib.h"
-#include "threads.h"
+#include "reactor.h"
 #include <vector>
 #include <string>
 
@@ -162,6 +162,30 @@ public:
 	bool wait(unsigned timeout_ms, unsigned flags = SOCKET_WAIT_READ);
 	int recv(void* buf, size_t n, int flags = 0);
 
+	/**
+	 * @brief Service this socket from the I/O reactor instead of polling
+	 * @param events Combination of REACTOR_EVENT_xxx flags
+	 * @param callback Invoked from the reactor thread when socket is ready
+	 * @retval bool false if reactor is unavailable, caller must poll instead
+	 */
+	bool watch(unsigned events, CReactor::Callback callback);
+
+	/**
+	 * @brief Change the events of interest for a watched socket
+	 */
+	bool watch(unsigned events);
+
+	/**
+	 * @brief Stop servicing socket from the I/O reactor
+	 * @note Called automatically when socket is closed
+	 */
+	void unwatch();
+
+	bool watched() const
+	{
+		return m_watched;
+	}
+
 	// If we take a copy of this socket this ensures it doesn't get closed
 	void release()
 	{
@@ -169,6 +193,8 @@ public:
 	}
 
 protected:
+	friend class CSocketList;
+
 	bool create();
 
 protected:
@@ -179,6 +205,8 @@ protected:
 	//
 	int m_fd;
 	CSockAddr m_addr;
+	// Registered with reactor
+	bool m_watched{false};
 };
 
 class CSocketList : public std::vector<CSocket*>
@@ -213,6 +241,8 @@ private:
 class CServerSocket : public CSocket
 {
 public:
+	using ConnectCallback = std::function<void(CSocket* client)>;
+
 	CServerSocket(int type = SOCK_STREAM) : CSocket(type)
 	{
 	}
@@ -232,6 +262,21 @@ public:
 
 	CSocket* try_connect();
 
+	/**
+	 * @brief Accept connections from the I/O reactor instead of polling `try_connect()`
+	 * @param callback Invoked from the reactor thread for each new client
+	 * @retval bool false if reactor is unavailable, caller must poll instead
+	 *
+	 * Listening is paused once `max_connections` clients are active.
+	 * Call `resume_connections()` after closing a client to accept further connections.
+	 */
+	bool watch_connections(ConnectCallback callback);
+
+	void resume_connections()
+	{
+		watch(REACTOR_EVENT_READ);
+	}
+
 protected:
 	// Inherited classes override this - return false to reject connection
 	virtual CSocket* new_connection(int& fd, const CSockAddr& addr)
@@ -58,6 +58,7 @@ void cleanup()
 #ifndef DISABLE_NETWORK
 	host_lwip_shutdown();
 #endif
+	CReactor::shutdown();
 	host_debug_i("Goodbye!");
 }
 
@@ -221,6 +222,10 @@ int main(int argc, char* argv[])
 			config.flash.createSize = parse_flash_size(arg);
 			break;
 
+		case opt_flashfileio:
+			config.flash.fileIo = true;
+			break;
+
 		case opt_initonly:
 			config.initonly = true;
 			break;
@@ -274,6 +279,7 @@ int main(int argc, char* argv[])
 		host_init_tasks();
 
 		sockets_initialise();
+		CReactor::startup();
 		UartServer::startup(config.uart);
 
 #ifndef DISABLE_NETWORK
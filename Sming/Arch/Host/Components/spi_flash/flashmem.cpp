@@ -24,17 +24,58 @@
 #include <IFS/File.h>
 #include <hostlib/hostmsg.h>
 
+#ifndef __WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
 namespace
 {
 IFS::File flashFile(&IFS::Host::getFileSystem());
 size_t flashFileSize{0x400000U};
 char flashFileName[256];
 const char defaultFlashFileName[]{"flash.bin"};
+uint8_t* flashMap; ///< Mapped backing file, nullptr if using file I/O
 
 // Top bit of flash address is set to indicate it's actually program memory
 constexpr flash_addr_t FLASHMEM_REAL_BIT{1UL << (sizeof(flash_addr_t) * 8 - 1)};
 constexpr flash_addr_t FLASHMEM_REAL_MASK{~FLASHMEM_REAL_BIT};
 
+bool mapFlashFile()
+{
+#ifdef __WIN32
+	host_debug_w("Memory-mapped flash not supported, using file I/O");
+	return false;
+#else
+	int fd = ::open(flashFileName, O_RDWR);
+	if(fd < 0) {
+		host_debug_w("Error opening \"%s\" for mapping: %s", flashFileName, strerror(errno));
+		return false;
+	}
+	auto mem = mmap(nullptr, flashFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// Mapping remains valid after descriptor is closed
+	::close(fd);
+	if(mem == MAP_FAILED) {
+		host_debug_w("Error mapping \"%s\": %s", flashFileName, strerror(errno));
+		return false;
+	}
+	flashMap = static_cast<uint8_t*>(mem);
+	return true;
+#endif
+}
+
+void unmapFlashFile()
+{
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		munmap(flashMap, flashFileSize);
+		flashMap = nullptr;
+	}
+#endif
+}
+
 } // namespace
 
 #define CHECK_ALIGNMENT(_x) assert((uintptr_t(_x) & 0x00000003) == 0)
@@ -89,17 +130,40 @@ bool host_flashmem_init(FlashmemConfig& config)
 	flashFileSize = res;
 	config.createSize = flashFileSize;
 
+	// Backing file remains open in case mapping fails
+	if(!config.fileIo) {
+		config.fileIo = !mapFlashFile();
+	}
+
+	return true;
+}
+
+bool host_flashmem_sync()
+{
+#ifndef __WIN32
+	if(flashMap != nullptr && msync(flashMap, flashFileSize, MS_SYNC) != 0) {
+		host_debug_e("Error syncing \"%s\": %s", flashFileName, strerror(errno));
+		return false;
+	}
+#endif
+	// File I/O is unbuffered
 	return true;
 }
 
 void host_flashmem_cleanup()
 {
+	host_flashmem_sync();
+	unmapFlashFile();
 	flashFile.close();
 	host_debug_i("Closed \"%s\"", flashFileName);
 }
 
 static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 {
+	if(flashMap != nullptr) {
+		memcpy(buffer, &flashMap[offset], count);
+		return count;
+	}
 	if(!flashFile) {
 		return -1;
 	}
@@ -115,6 +179,10 @@ static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 
 static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 {
+	if(flashMap != nullptr) {
+		memcpy(&flashMap[offset], data, count);
+		return count;
+	}
 	if(!flashFile) {
 		return -1;
 	}
@@ -208,6 +276,10 @@ bool flashmem_erase_sector(uint32_t sector_id)
 {
 	uint32_t addr = sector_id * INTERNAL_FLASH_SECTOR_SIZE;
 	CHECK_RANGE(addr, INTERNAL_FLASH_SECTOR_SIZE);
+	if(flashMap != nullptr) {
+		memset(&flashMap[addr], 0xFF, INTERNAL_FLASH_SECTOR_SIZE);
+		return true;
+	}
 	uint8_t tmp[INTERNAL_FLASH_SECTOR_SIZE];
 	memset(tmp, 0xFF, sizeof(tmp));
 	return writeFlashFile(addr, tmp, sizeof(tmp)) == sizeof(tmp);
@@ -23,7 +23,8 @@
 
 struct FlashmemConfig {
 	const char* filename; ///< Path to flash backing file
-	size_t createSize;	///< If file doesn't exist, created with this size
+	size_t createSize;	  ///< If file doesn't exist, created with this size
+	bool fileIo;		  ///< Use file I/O instead of memory-mapping the backing file
 };
 
 /**
@@ -37,4 +38,10 @@ struct FlashmemConfig {
  */
 bool host_flashmem_init(FlashmemConfig& config);
 
+/**
+ * @brief Flush any pending writes to the backing file
+ * @retval bool false on error
+ */
+bool host_flashmem_sync();
+
 void host_flashmem_cleanup();
@@ -20,23 +20,27 @@ extern Hosted::Client* hostedClient;
 
 void pinMode(uint16_t pin, uint8_t mode)
 {
-	hostedClient->send(__func__, pin, mode);
+	static Hosted::Command command(__func__);
+	hostedClient->send(command, pin, mode);
 }
 
 void digitalWrite(uint16_t pin, uint8_t val)
 {
-	hostedClient->send(__func__, pin, val);
+	static Hosted::Command command(__func__);
+	hostedClient->send(command, pin, val);
 }
 
 uint8_t digitalRead(uint16_t pin)
 {
-	hostedClient->send(__func__, pin);
+	static Hosted::Command command(__func__);
+	hostedClient->send(command, pin);
 	return hostedClient->wait<uint8_t>();
 }
 
 unsigned long pulseIn(uint16_t pin, uint8_t state, unsigned long timeout)
 {
-	hostedClient->send(__func__, pin, state, timeout);
+	static Hosted::Command command(__func__);
+	hostedClient->send(command, pin, state, timeout);
 	return hostedClient->wait<unsigned long>();
 }
 
@@ -21,90 +21,106 @@ extern Hosted::Client* hostedClient;
 
 void TwoWire::begin(uint8_t sda, uint8_t scl)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, sda, scl);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, sda, scl);
 }
 
 void TwoWire::pins(uint8_t sda, uint8_t scl)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, sda, scl);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, sda, scl);
 }
 
 void TwoWire::begin()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 }
 
 void TwoWire::end()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 }
 
 TwoWire::Status TwoWire::status()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 	return hostedClient->wait<TwoWire::Status>();
 }
 
 void TwoWire::setClock(uint32_t freq)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, freq);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, freq);
 }
 
 void TwoWire::setClockStretchLimit(uint32_t limit)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, limit);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, limit);
 }
 
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size, bool sendStop)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, address, size, sendStop);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, address, size, sendStop);
 	return hostedClient->wait<uint8_t>();
 }
 
 void TwoWire::beginTransmission(uint8_t address)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, address);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, address);
 }
 
 TwoWire::Error TwoWire::endTransmission(bool sendStop)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, sendStop);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, sendStop);
 	return hostedClient->wait<TwoWire::Error>();
 }
 
 size_t TwoWire::write(uint8_t data)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, data);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, data);
 	return hostedClient->wait<size_t>();
 }
 
 size_t TwoWire::write(const uint8_t* data, size_t quantity)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, data, quantity);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command, data, quantity);
 	return hostedClient->wait<size_t>();
 }
 
 int TwoWire::available()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 	return hostedClient->wait<int>();
 }
 
 int TwoWire::read()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 	return hostedClient->wait<int>();
 }
 
 int TwoWire::peek()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 	return hostedClient->wait<int>();
 }
 
 void TwoWire::flush()
 {
-	hostedClient->send(__PRETTY_FUNCTION__);
+	static Hosted::Command command(__PRETTY_FUNCTION__);
+	hostedClient->send(command);
 }
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_TWOWIRE)
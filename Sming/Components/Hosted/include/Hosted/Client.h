@@ -25,15 +25,127 @@
 #include <hostlib/emu.h>
 #include <hostlib/hostmsg.h>
 #include "Util.h"
+#include <deque>
+#include <memory>
 
 namespace Hosted
 {
 constexpr int COMMAND_NOT_FOUND = -1;
 
+class Client;
+
+/**
+ * @brief Remote command whose ID is resolved on first use and then cached
+ *
+ * Declare instances static so the name is looked up once rather than on every call:
+ *
+ * 		void digitalWrite(uint16_t pin, uint8_t val)
+ * 		{
+ * 			static Hosted::Command command(__func__);
+ * 			hostedClient->send(command, pin, val);
+ * 		}
+ *
+ * The cached ID is refreshed if the client fetches the remote command list again.
+ */
+class Command
+{
+public:
+	/**
+	 * @param name As for `Client::send()`. Must remain valid for the lifetime of this object.
+	 */
+	explicit Command(const char* name) : name(name)
+	{
+	}
+
+	const char* getName() const
+	{
+		return name;
+	}
+
+private:
+	friend class Client;
+
+	const char* name;
+	mutable const Client* client{nullptr}; ///< Client which resolved the ID
+	mutable int id{COMMAND_NOT_FOUND};
+	mutable uint16_t generation{0}; ///< Matches Client::generation when ID is current
+};
+
+/**
+ * @brief Result of an asynchronous call
+ *
+ * Results are returned by the server in the order calls are made, so many calls may be
+ * issued before waiting for any of them.
+ */
+template <typename R> class Future
+{
+public:
+	Future() = default;
+
+	/**
+	 * @brief Determine if the call was sent
+	 */
+	bool isValid() const
+	{
+		return state != nullptr;
+	}
+
+	/**
+	 * @brief Determine if the result has been received, without blocking
+	 */
+	bool isReady() const;
+
+	/**
+	 * @brief Get the result, blocking until it has been received
+	 */
+	R get();
+
+private:
+	friend class Client;
+
+	struct State;
+
+	Future(Client& client, std::shared_ptr<State> state) : client(&client), state(state)
+	{
+	}
+
+	Client* client{nullptr};
+	std::shared_ptr<State> state;
+};
+
 class Client : private simpleRPC::ParserCallbacks
 {
 public:
-	using RemoteCommands = HashMap<String, uint8_t>;
+	using RemoteCommands = HashMap<String, uint8_t, HashMapHash<String>>;
+
+	/**
+	 * @brief Storage for a result not yet received
+	 */
+	struct PendingResult {
+		void* data;
+		size_t size;
+		bool ready{false};
+	};
+
+	/**
+	 * @brief Queue calls within a scope, sending them together when it ends
+	 */
+	class Batch
+	{
+	public:
+		Batch(Client& client) : client(client)
+		{
+			client.beginBatch();
+		}
+
+		~Batch()
+		{
+			client.endBatch();
+		}
+
+	private:
+		Client& client;
+	};
 
 	Client(Stream& stream, char methodEndsWith = ':') : stream(stream), methodEndsWith(methodEndsWith)
 	{
@@ -54,36 +166,107 @@ public:
 	 * @param variable arguments
 	 *
 	 * @retval true on success, false if the command is not available
+	 *
+	 * @note Resolving the name on every call is relatively expensive: use a `Command` for frequent calls.
 	 */
 	template <typename... Args> bool send(const String& functionName, Args... args)
 	{
-		int functionId = getFunctionId(functionName);
-		if(functionId == COMMAND_NOT_FOUND) {
-			return false;
+		return sendId(getFunctionId(functionName), args...);
+	}
+
+	/**
+	 * @brief Send a command using its cached ID
+	 */
+	template <typename... Args> bool send(const Command& command, Args... args)
+	{
+		return sendId(getFunctionId(command), args...);
+	}
+
+	/**
+	 * @brief Send a command without waiting for its result
+	 * @retval Future<R> Invalid if the command is not available
+	 */
+	template <typename R, typename Cmd, typename... Args> Future<R> call(const Cmd& command, Args... args)
+	{
+		if(!send(command, args...)) {
+			return Future<R>();
 		}
+		return expect<R>();
+	}
 
-		simpleRPC::rpcPrint(stream, uint8_t(functionId), args...);
-		stream.flush();
+	/**
+	 * @brief Start queuing commands
+	 *
+	 * Commands are written to the stream but not flushed until the matching `endBatch()` call.
+	 * Batches may be nested. Waiting for a result flushes the stream.
+	 */
+	void beginBatch()
+	{
+		++batchLevel;
+	}
 
-		return true;
+	/**
+	 * @brief Send all queued commands
+	 */
+	void endBatch()
+	{
+		if(batchLevel != 0 && --batchLevel == 0) {
+			stream.flush();
+		}
+	}
+
+	bool isBatching() const
+	{
+		return batchLevel != 0;
 	}
 
 	/**
 	 * @brief This method will block the execution until a message is detected
 	 * @retval HostedCommand
+	 * @note Results for any outstanding calls are received first
 	 */
 	template <typename R> R wait()
 	{
-		size_t neededBytes = sizeof(R);
+		return expect<R>().get();
+	}
 
-		while(stream.available() < int(neededBytes)) {
-			stream.flush();
+	/**
+	 * @brief Block until a pending result is received
+	 */
+	void await(const PendingResult& result)
+	{
+		stream.flush();
+		while(!result.ready) {
+			receiveResults();
+			if(result.ready) {
+				break;
+			}
 			host_main_loop();
 		}
+	}
+
+	/**
+	 * @brief Read any results which have arrived, without blocking
+	 */
+	void receiveResults()
+	{
+		while(!pendingResults.empty()) {
+			auto& result = *pendingResults.front();
+			if(stream.available() < int(result.size)) {
+				break;
+			}
+			stream.readBytes(static_cast<char*>(result.data), result.size);
+			result.ready = true;
+			pendingResults.pop_front();
+		}
+	}
 
-		R result{};
-		stream.readBytes(reinterpret_cast<char*>(&result), sizeof(result));
-		return result;
+	/**
+	 * @brief Get number of calls whose results have not yet been received
+	 */
+	size_t getPendingCount() const
+	{
+		return pendingResults.size();
 	}
 
 	/**
@@ -102,12 +285,31 @@ public:
 			name = convertFQN(name);
 		}
 
-		int id = commands.indexOf(name);
-		if(id < 0) {
+		int i = commands.indexOf(name);
+		if(i < 0) {
 			return COMMAND_NOT_FOUND;
 		}
 
-		return commands[name];
+		return commands.valueAt(i);
+	}
+
+	/**
+	 * @brief Get the id of a command, resolving it only if not already cached
+	 * @retval -1 if not found. Otherwise the id of the function
+	 */
+	int getFunctionId(const Command& command)
+	{
+		if(fetchCommands) {
+			getRemoteCommands();
+		}
+
+		if(command.client != this || command.generation != generation) {
+			command.id = getFunctionId(command.name);
+			command.client = this;
+			command.generation = generation;
+		}
+
+		return command.id;
 	}
 
 	/**
@@ -157,9 +359,33 @@ public:
 	}
 
 private:
+	template <typename... Args> bool sendId(int functionId, Args... args)
+	{
+		if(functionId == COMMAND_NOT_FOUND) {
+			return false;
+		}
+
+		simpleRPC::rpcPrint(stream, uint8_t(functionId), args...);
+		if(batchLevel == 0) {
+			stream.flush();
+		}
+
+		return true;
+	}
+
+	template <typename R> Future<R> expect()
+	{
+		auto state = std::make_shared<typename Future<R>::State>();
+		pendingResults.push_back(state);
+		return Future<R>(*this, state);
+	}
+
 	Stream& stream;
 	bool fetchCommands{true};
 	RemoteCommands commands;
+	std::deque<std::shared_ptr<PendingResult>> pendingResults;
+	uint16_t generation{0}; ///< Incremented each time the command list is fetched
+	uint16_t batchLevel{0};
 	uint8_t methodPosition = 0;
 	String name;
 	String signature;
@@ -198,7 +424,38 @@ private:
 	void endMethods() override
 	{
 		fetchCommands = false;
+		if(++generation == 0) {
+			generation = 1;
+		}
 	}
 };
 
+template <typename R> struct Future<R>::State : public Client::PendingResult {
+	State() : PendingResult{&value, sizeof(R)}
+	{
+	}
+
+	R value{};
+};
+
+template <typename R> bool Future<R>::isReady() const
+{
+	if(state == nullptr) {
+		return false;
+	}
+	if(!state->ready) {
+		client->receiveResults();
+	}
+	return state->ready;
+}
+
+template <typename R> R Future<R>::get()
+{
+	if(state == nullptr) {
+		return R{};
+	}
+	client->await(*state);
+	return state->value;
+}
+
 } // namespace Hosted
@@ -31,6 +31,32 @@ public:
 	}
 
 protected:
+	/**
+	 * @brief Pass received data to the handler
+	 *
+	 * A client may send several commands together, so the handler is called
+	 * until all data is consumed or it stops making progress.
+	 */
+	bool dispatch(Stream& stream)
+	{
+		if(!handler) {
+			return false;
+		}
+
+		int available;
+		while((available = stream.available()) > 0) {
+			if(!handler(stream)) {
+				return false;
+			}
+			if(stream.available() >= available) {
+				// Incomplete command, wait for more data
+				break;
+			}
+		}
+
+		return true;
+	}
+
 	DataHandler handler;
 };
 
@@ -29,7 +29,7 @@ public:
 private:
 	void process(Stream& source, char, uint16_t)
 	{
-		handler(source);
+		dispatch(source);
 	}
 };
 
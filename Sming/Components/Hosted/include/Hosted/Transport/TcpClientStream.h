@@ -59,7 +59,7 @@ public:
 
 	size_t write(uint8_t c) override
 	{
-		return cBuffer.write(c);
+		return write(&c, 1);
 	}
 
 	int available() override
@@ -31,11 +31,11 @@ public:
 protected:
 	bool process(TcpClient& client, char* data, int size) override
 	{
-		if(!stream.push(data, size)) {
+		if(!stream->push(reinterpret_cast<const uint8_t*>(data), size)) {
 			return false;
 		}
 
-		return handler(*stream);
+		return dispatch(*stream);
 	}
 
 private:
@@ -43,7 +43,7 @@ protected:
 			return false;
 		}
 
-		return handler(*stream);
+		return dispatch(*stream);
 	}
 
 private:
@@ -50,6 +50,31 @@ COMPONENT_VARS			+= HTTP_SERVER_EXPOSE_VERSION
 HTTP_SERVER_EXPOSE_VERSION ?= 0
 GLOBAL_CFLAGS			+= -DHTTP_SERVER_EXPOSE_VERSION=$(HTTP_SERVER_EXPOSE_VERSION)
 
+COMPONENT_VARS			+= HTTP_FORM_BUFFER_SIZE
+HTTP_FORM_BUFFER_SIZE	?= 1024
+GLOBAL_CFLAGS			+= -DHTTP_FORM_BUFFER_SIZE=$(HTTP_FORM_BUFFER_SIZE)
+
+COMPONENT_VARS			+= HTTP_BODY_RESERVE_SIZE
+HTTP_BODY_RESERVE_SIZE	?= 1024
+GLOBAL_CFLAGS			+= -DHTTP_BODY_RESERVE_SIZE=$(HTTP_BODY_RESERVE_SIZE)
+
+COMPONENT_VARS			+= HTTP_SERVER_MAX_RANGES
+HTTP_SERVER_MAX_RANGES	?= 8
+GLOBAL_CFLAGS			+= -DHTTP_SERVER_MAX_RANGES=$(HTTP_SERVER_MAX_RANGES)
+
+COMPONENT_VARS			+= HTTP_SERVER_ETAG_CACHE_SIZE
+HTTP_SERVER_ETAG_CACHE_SIZE ?= 8
+GLOBAL_CFLAGS			+= -DHTTP_SERVER_ETAG_CACHE_SIZE=$(HTTP_SERVER_ETAG_CACHE_SIZE)
+
+# => TCP
+COMPONENT_VARS			+= TCP_RETAINED_CONNECTION_TIMEOUT
+TCP_RETAINED_CONNECTION_TIMEOUT ?= 20
+GLOBAL_CFLAGS			+= -DTCP_RETAINED_CONNECTION_TIMEOUT=$(TCP_RETAINED_CONNECTION_TIMEOUT)
+
+COMPONENT_VARS			+= TCP_MAX_RETAINED_STREAMS
+TCP_MAX_RETAINED_STREAMS ?= 8
+GLOBAL_CFLAGS			+= -DTCP_MAX_RETAINED_STREAMS=$(TCP_MAX_RETAINED_STREAMS)
+
 # => LWIP
 COMPONENT_VARS			+= ENABLE_CUSTOM_LWIP
 ifeq ($(SMING_ARCH),Esp8266)
@@ -0,0 +1,148 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ByteRangeStream.cpp
+ *
+ ****/
+
+#include "ByteRangeStream.h"
+#include <stringutil.h>
+#include <esp_system.h>
+#include <debug_progmem.h>
+
+ByteRangeStream::ByteRangeStream(IDataSourceStream* source, const HttpRangeList& ranges, size_t contentLength,
+								 const String& contentType, size_t sourceOffset)
+	: source(source), ranges(ranges), contentType(contentType), contentLength(contentLength),
+	  sourceOffset(sourceOffset)
+{
+	remaining = ranges.totalLength();
+	if(!isMultipart()) {
+		return;
+	}
+
+	for(unsigned i = 0; i < sizeof(boundary) - 1; ++i) {
+		boundary[i] = hexchar(os_random() % 16);
+	}
+	for(unsigned i = 0; i < ranges.count(); ++i) {
+		remaining += getPartHeader(i).length();
+	}
+	remaining += getFooter().length();
+
+	header = getPartHeader(0);
+	inHeader = true;
+}
+
+String ByteRangeStream::getContentType() const
+{
+	if(!isMultipart()) {
+		return contentType;
+	}
+
+	String s = F("multipart/byteranges; boundary=");
+	s += boundary;
+	return s;
+}
+
+String ByteRangeStream::getPartHeader(unsigned index) const
+{
+	String s = F("\r\n--");
+	s += boundary;
+	if(contentType) {
+		s += F("\r\nContent-Type: ");
+		s += contentType;
+	}
+	s += F("\r\nContent-Range: ");
+	s += HttpRangeList::contentRange(ranges[index], contentLength);
+	s += F("\r\n\r\n");
+	return s;
+}
+
+String ByteRangeStream::getFooter() const
+{
+	String s = F("\r\n--");
+	s += boundary;
+	s += F("--\r\n");
+	return s;
+}
+
+void ByteRangeStream::nextSection()
+{
+	sectionPos = 0;
+	if(inHeader) {
+		inHeader = false;
+		return;
+	}
+
+	++partIndex;
+	if(!isMultipart()) {
+		return;
+	}
+
+	header = (partIndex < ranges.count()) ? getPartHeader(partIndex) : getFooter();
+	inHeader = true;
+}
+
+uint16_t ByteRangeStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0 || remaining == 0) {
+		return 0;
+	}
+
+	if(inHeader) {
+		auto len = std::min(header.length() - sectionPos, size_t(bufSize));
+		memcpy(data, header.c_str() + sectionPos, len);
+		return len;
+	}
+
+	auto& range = ranges[partIndex];
+	size_t offset = sourceOffset + range.first + sectionPos;
+	if(!sourceValid || sourcePos != offset) {
+		if(source->seekFrom(offset, SeekOrigin::Start) != int(offset)) {
+			debug_e("[RANGE] Source seek to %u failed", offset);
+			// Output will be truncated, which the client detects from Content-Length
+			remaining = 0;
+			return 0;
+		}
+		sourcePos = offset;
+		sourceValid = true;
+	}
+
+	auto len = std::min(range.length() - sectionPos, size_t(bufSize));
+	return source->readMemoryBlock(data, len);
+}
+
+int ByteRangeStream::seekFrom(int offset, SeekOrigin origin)
+{
+	if(origin != SeekOrigin::Current || offset < 0) {
+		return -1;
+	}
+
+	size_t len = offset;
+	while(len != 0 && remaining != 0) {
+		size_t sectionLength = inHeader ? header.length() : ranges[partIndex].length();
+		auto n = std::min(len, sectionLength - sectionPos);
+		if(!inHeader && sourceValid && sourcePos == sourceOffset + ranges[partIndex].first + sectionPos) {
+			if(source->seek(n)) {
+				sourcePos += n;
+			} else {
+				sourceValid = false;
+			}
+		}
+		sectionPos += n;
+		remaining -= n;
+		streamPos += n;
+		len -= n;
+		if(sectionPos == sectionLength) {
+			nextSection();
+		}
+	}
+
+	if(len != 0) {
+		return -1;
+	}
+
+	return streamPos;
+}
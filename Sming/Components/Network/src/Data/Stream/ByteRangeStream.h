@@ -0,0 +1,105 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ByteRangeStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/Stream/DataSourceStream.h>
+#include <Network/Http/HttpRange.h>
+#include <memory>
+
+/**
+ * @brief Read-only stream which outputs selected byte ranges of a source stream
+ *
+ * Used to generate `206 Partial Content` responses. A single range is output as-is.
+ * Multiple ranges are output as `multipart/byteranges` content, each part having its own
+ * `Content-Type` and `Content-Range` headers.
+ *
+ * The source is positioned using `seekFrom()` so content outside the ranges is never read.
+ * The total output length is known in advance so no chunked encoding is required.
+ *
+ * @ingroup stream data
+ */
+class ByteRangeStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @brief Create a range stream
+	 * @param source Stream containing the complete resource, must support `seekFrom()`.
+	 * The stream is owned by this object and will be destroyed with it.
+	 * @param ranges Satisfiable ranges, as obtained from `HttpRangeList::parse()`
+	 * @param contentLength Size of the complete resource
+	 * @param contentType MIME type of the resource, used for multipart headers
+	 * @param sourceOffset Position in source at which the resource starts
+	 */
+	ByteRangeStream(IDataSourceStream* source, const HttpRangeList& ranges, size_t contentLength,
+					const String& contentType, size_t sourceOffset = 0);
+
+	StreamType getStreamType() const override
+	{
+		return source ? eSST_Wrapper : eSST_Invalid;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	/**
+	 * @brief Only forward seeks from the current position are supported
+	 */
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override
+	{
+		return remaining == 0;
+	}
+
+	int available() override
+	{
+		return remaining;
+	}
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+	/**
+	 * @brief Determine if output is multipart content
+	 */
+	bool isMultipart() const
+	{
+		return ranges.count() > 1;
+	}
+
+	/**
+	 * @brief Get value for the response `Content-Type` header
+	 *
+	 * For a single range this is the type of the resource.
+	 */
+	String getContentType() const;
+
+private:
+	String getPartHeader(unsigned index) const;
+	String getFooter() const;
+	void nextSection();
+
+	std::unique_ptr<IDataSourceStream> source;
+	HttpRangeList ranges;
+	String contentType;
+	size_t contentLength;
+	size_t sourceOffset;	  ///< Source position corresponding to start of resource
+	String header;			  ///< Multipart header or footer
+	unsigned partIndex{0};	  ///< Current range, equal to range count for footer
+	bool inHeader{false};	  ///< Outputting header rather than range content
+	size_t sectionPos{0};	  ///< Position within current header or range
+	size_t sourcePos{0};	  ///< Current position in source
+	bool sourceValid{false};  ///< sourcePos is known
+	size_t remaining{0};	  ///< Bytes remaining in output
+	size_t streamPos{0};	  ///< Output position
+	char boundary[17]{};
+};
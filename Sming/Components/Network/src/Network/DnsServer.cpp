@@ -77,8 +77,9 @@ void DnsServer::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
 	debug_d("DNS REQ from %s:%d", remoteIP.toString().c_str(), remotePort);
 
-	// Allocated buffer with additional room for answer
-	char* buffer = new char[buf->tot_len + MAX_ANSWER_LENGTH];
+	// Response is built in-place from the request, with additional room for answer
+	UdpPacketBuilder packet(buf->tot_len + MAX_ANSWER_LENGTH);
+	char* buffer = packet.getBuffer();
 	if(buffer == nullptr) {
 		return;
 	}
@@ -90,10 +91,9 @@ void DnsServer::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 	auto responseLen = processQuestion(buffer, requestLen);
 	if(responseLen != 0) {
 		debug_hex(DBG, "> DNS", buffer, responseLen);
-		sendTo(remoteIP, remotePort, buffer, responseLen);
+		packet.setLength(responseLen);
+		sendPacketTo(remoteIP, remotePort, packet);
 	}
-
-	delete[] buffer;
 }
 
 size_t DnsServer::processQuestion(char* buffer, size_t requestLen)
@@ -0,0 +1,176 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpAcceptEncoding.cpp
+ *
+ ****/
+
+#include "HttpAcceptEncoding.h"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+#define XX(name, token, ext) DEFINE_FSTR_LOCAL(token_##name, token)
+HTTP_CONTENT_CODING_MAP(XX)
+#undef XX
+
+#define XX(name, token, ext) DEFINE_FSTR_LOCAL(ext_##name, ext)
+HTTP_CONTENT_CODING_MAP(XX)
+#undef XX
+
+// Tie-break order when client preference is equal
+constexpr HttpContentCoding preferenceOrder[]{
+	HttpContentCoding::br,
+	HttpContentCoding::gzip,
+	HttpContentCoding::deflate,
+	HttpContentCoding::identity,
+};
+
+bool isDelimiter(char c)
+{
+	return c == '\0' || c == ',' || c == ';' || c == ' ' || c == '\t';
+}
+
+const char* skipSpace(const char* p)
+{
+	while(*p == ' ' || *p == '\t') {
+		++p;
+	}
+	return p;
+}
+
+int parseQuality(const char*& p)
+{
+	if(!isdigit(*p)) {
+		return -1;
+	}
+	int q = (*p++ - '0') * 1000;
+	if(*p == '.') {
+		++p;
+		for(int scale = 100; isdigit(*p); scale /= 10, ++p) {
+			q += (*p - '0') * scale;
+		}
+	}
+	return std::min(q, 1000);
+}
+
+int findCoding(const char* token, size_t length)
+{
+	// Obsolete alias
+	if(length == 6 && strncasecmp(token, "x-gzip", 6) == 0) {
+		return int(HttpContentCoding::gzip);
+	}
+	for(auto coding : preferenceOrder) {
+		String s = toString(coding);
+		if(s.length() == length && strncasecmp(token, s.c_str(), length) == 0) {
+			return int(coding);
+		}
+	}
+	return -1;
+}
+
+} // namespace
+
+String toString(HttpContentCoding coding)
+{
+	switch(coding) {
+#define XX(name, token, ext)                                                                                           \
+	case HttpContentCoding::name:                                                                                      \
+		return token_##name;
+		HTTP_CONTENT_CODING_MAP(XX)
+#undef XX
+	default:
+		return nullptr;
+	}
+}
+
+String getFileExtension(HttpContentCoding coding)
+{
+	switch(coding) {
+#define XX(name, token, ext)                                                                                           \
+	case HttpContentCoding::name:                                                                                      \
+		return ext_##name;
+		HTTP_CONTENT_CODING_MAP(XX)
+#undef XX
+	default:
+		return nullptr;
+	}
+}
+
+void HttpAcceptEncoding::parse(const String& value)
+{
+	int listed[codingCount];
+	std::fill_n(listed, codingCount, -1);
+	int wildcard{-1};
+
+	auto p = value.c_str();
+	for(;;) {
+		while(*p == ',' || *p == ' ' || *p == '\t') {
+			++p;
+		}
+		if(*p == '\0') {
+			break;
+		}
+
+		auto token = p;
+		while(!isDelimiter(*p)) {
+			++p;
+		}
+		size_t tokenLength = p - token;
+
+		int q{maxQuality};
+		for(p = skipSpace(p); *p == ';'; p = skipSpace(p)) {
+			p = skipSpace(p + 1);
+			if((*p == 'q' || *p == 'Q') && p[1] == '=') {
+				p += 2;
+				auto n = parseQuality(p);
+				if(n >= 0) {
+					q = n;
+				}
+			}
+			while(*p != '\0' && *p != ',' && *p != ';') {
+				++p;
+			}
+		}
+
+		if(tokenLength == 1 && *token == '*') {
+			wildcard = q;
+		} else {
+			int i = findCoding(token, tokenLength);
+			if(i >= 0) {
+				listed[i] = q;
+			}
+		}
+
+		while(*p != '\0' && *p != ',') {
+			++p;
+		}
+	}
+
+	for(unsigned i = 0; i < codingCount; ++i) {
+		if(listed[i] >= 0) {
+			qvalues[i] = listed[i];
+		} else if(wildcard >= 0) {
+			qvalues[i] = wildcard;
+		} else {
+			// Identity is acceptable unless specifically excluded
+			qvalues[i] = (HttpContentCoding(i) == HttpContentCoding::identity) ? maxQuality : 0;
+		}
+	}
+}
+
+bool HttpAcceptEncoding::select(unsigned available, HttpContentCoding& coding) const
+{
+	unsigned bestQuality{0};
+	for(auto c : preferenceOrder) {
+		if((available & mask(c)) && quality(c) > bestQuality) {
+			bestQuality = quality(c);
+			coding = c;
+		}
+	}
+	return bestQuality != 0;
+}
@@ -0,0 +1,94 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpAcceptEncoding.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+/**
+ * @brief Content codings known to the HTTP server
+ *
+ * Name, token and file extension for pre-compressed variants
+ */
+#define HTTP_CONTENT_CODING_MAP(XX)                                                                                    \
+	XX(identity, "identity", "")                                                                                       \
+	XX(gzip, "gzip", ".gz")                                                                                            \
+	XX(deflate, "deflate", "")                                                                                         \
+	XX(br, "br", ".br")
+
+/**
+ * @ingroup http
+ */
+enum class HttpContentCoding {
+#define XX(name, token, ext) name,
+	HTTP_CONTENT_CODING_MAP(XX)
+#undef XX
+};
+
+/**
+ * @brief Get the token used in `Accept-Encoding` and `Content-Encoding` headers
+ */
+String toString(HttpContentCoding coding);
+
+/**
+ * @brief Get file extension used to store a pre-compressed variant, empty if not applicable
+ */
+String getFileExtension(HttpContentCoding coding);
+
+/**
+ * @brief Content codings acceptable to a client, as given in an `Accept-Encoding` request header
+ *
+ * See RFC 7231 5.3.4. Without a header all codings are acceptable.
+ *
+ * @ingroup http
+ */
+class HttpAcceptEncoding
+{
+public:
+	/**
+	 * @brief Parse an `Accept-Encoding` header value, e.g. "gzip, deflate;q=0.5, *;q=0"
+	 */
+	void parse(const String& value);
+
+	/**
+	 * @brief Get client preference for a content coding
+	 * @retval unsigned Quality value scaled to 0 - 1000, 0 if not acceptable
+	 */
+	unsigned quality(HttpContentCoding coding) const
+	{
+		return qvalues[unsigned(coding)];
+	}
+
+	bool accepts(HttpContentCoding coding) const
+	{
+		return quality(coding) != 0;
+	}
+
+	/**
+	 * @brief Select the preferred coding from those a resource is available in
+	 * @param available Bitmask of available codings, e.g. `mask(HttpContentCoding::gzip)`
+	 * @param coding On success, the selected coding
+	 * @retval bool false if none are acceptable
+	 *
+	 * Where client preference is equal the coding with the smallest output is chosen.
+	 */
+	bool select(unsigned available, HttpContentCoding& coding) const;
+
+	static constexpr unsigned mask(HttpContentCoding coding)
+	{
+		return 1U << unsigned(coding);
+	}
+
+private:
+	static constexpr unsigned codingCount{unsigned(HttpContentCoding::br) + 1};
+	static constexpr uint16_t maxQuality{1000};
+
+	uint16_t qvalues[codingCount]{maxQuality, maxQuality, maxQuality, maxQuality};
+};
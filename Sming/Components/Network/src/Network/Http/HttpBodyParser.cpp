@@ -15,91 +15,234 @@
  ****/
 
 #include "HttpBodyParser.h"
-#include <Data/WebHelpers/escape.h>
 #include <Data/Stream/MemoryDataStream.h>
+#include <stringutil.h>
 
-/*
- * Content is received in chunks which we need to reassemble into name=value pairs.
- * This structure stores the temporary values during parsing.
- */
-struct FormUrlParserState {
-	char searchChar{'='};
-	String postName;
-	String postValue;
-};
+namespace
+{
+size_t getContentLength(HttpRequest& request)
+{
+	auto& headers = static_cast<const HttpHeaders&>(request.headers);
+	return headers[HTTP_HEADER_CONTENT_LENGTH].toInt();
+}
 
 /*
- * The incoming URL is parsed
+ * Content is received in chunks which we need to reassemble into name=value pairs.
+ *
+ * Characters are decoded as they arrive into a buffer allocated together with this object,
+ * so each field requires no further allocation. The buffer holds the current name and value,
+ * each followed by a NUL terminator.
  */
-size_t formUrlParser(HttpRequest& request, const char* at, int length)
+class FormUrlParser
 {
-	auto state = static_cast<FormUrlParserState*>(request.args);
+public:
+	static FormUrlParser* create(size_t contentLength)
+	{
+		// Allow for NUL terminators
+		size_t capacity = HTTP_FORM_BUFFER_SIZE;
+		if(contentLength != 0) {
+			capacity = std::min(contentLength + 2, capacity);
+		}
+		auto mem = malloc(sizeof(FormUrlParser) + capacity);
+		return mem ? new(mem) FormUrlParser(capacity) : nullptr;
+	}
 
-	if(length == PARSE_DATASTART) {
-		delete state;
-		request.args = new FormUrlParserState;
-		return 0;
+	static void destroy(FormUrlParser* parser)
+	{
+		if(parser != nullptr) {
+			parser->~FormUrlParser();
+			free(parser);
+		}
 	}
 
-	auto& params = request.postParams;
+	size_t parse(HttpRequest& request, const char* at, size_t count, const HttpFormFieldDelegate& callback);
+	bool finish(HttpRequest& request, const HttpFormFieldDelegate& callback);
 
-	if(length == PARSE_DATAEND) {
-		if(state == nullptr) {
-			return 0;
-		}
+private:
+	FormUrlParser(size_t capacity) : capacity(capacity)
+	{
+	}
 
-		// Store last parameter, if there is one
-		if(state->postName.length() != 0) {
-			uri_unescape_inplace(state->postValue);
-			params[state->postName] = state->postValue;
+	char* buffer()
+	{
+		return reinterpret_cast<char*>(this + 1);
+	}
+
+	bool put(char c)
+	{
+		if(length >= capacity) {
+			debug_w("[HTTP] Form field exceeds %u bytes", capacity);
+			return false;
 		}
+		buffer()[length++] = c;
+		return true;
+	}
 
-		delete state;
-		request.args = nullptr;
+	bool flushEscape();
+	bool endField(HttpRequest& request, const HttpFormFieldDelegate& callback);
 
-		return 0;
+	size_t capacity;
+	size_t length{0};		 ///< Decoded characters in buffer
+	int nameLength{-1};		 ///< Set when '=' is found
+	char escape[2];			 ///< Hex digits following '%'
+	int8_t escapeLength{-1}; ///< Number of hex digits received, -1 if not in an escape sequence
+	bool error{false};
+};
+
+// Invalid escape sequences are passed through unchanged
+bool FormUrlParser::flushEscape()
+{
+	if(escapeLength < 0) {
+		return true;
 	}
+	bool ok = put('%');
+	for(int i = 0; ok && i < escapeLength; ++i) {
+		ok = put(escape[i]);
+	}
+	escapeLength = -1;
+	return ok;
+}
 
-	if(state == nullptr) {
-		debug_e("Invalid request argument");
+bool FormUrlParser::endField(HttpRequest& request, const HttpFormFieldDelegate& callback)
+{
+	if(!flushEscape()) {
+		return false;
+	}
+	if(nameLength < 0) {
+		// No value
+		nameLength = length;
+		if(!put('\0')) {
+			return false;
+		}
+	}
+	if(!put('\0')) {
+		return false;
+	}
+
+	auto name = buffer();
+	auto value = name + nameLength + 1;
+	size_t valueLength = length - nameLength - 2;
+	bool ok{true};
+	if(nameLength != 0) {
+		if(callback) {
+			ok = callback(request, name, nameLength, value, valueLength);
+		} else {
+			request.postParams[String(name, nameLength)] = String(value, valueLength);
+		}
+	}
+
+	length = 0;
+	nameLength = -1;
+	return ok;
+}
+
+size_t FormUrlParser::parse(HttpRequest& request, const char* at, size_t count,
+							const HttpFormFieldDelegate& callback)
+{
+	if(error) {
 		return 0;
 	}
 
-	size_t consumed = length;
-	while(length > 0) {
-		// Look for search character ('=' or '&') in received text
-		auto found = static_cast<const char*>(memchr(at, state->searchChar, length));
-		unsigned foundLength = (found == nullptr) ? length : (found - at);
+	for(size_t i = 0; i < count; ++i) {
+		char c = at[i];
+		if(escapeLength >= 0) {
+			if(isxdigit(c)) {
+				escape[escapeLength++] = c;
+				if(escapeLength == 2) {
+					escapeLength = -1;
+					if(!put((unhex(escape[0]) << 4) | unhex(escape[1]))) {
+						error = true;
+						return i;
+					}
+				}
+				continue;
+			}
+			if(!flushEscape()) {
+				error = true;
+				return i;
+			}
+		}
 
-		if(foundLength != 0) {
-			if(state->searchChar == '=') {
-				state->postName.concat(at, foundLength);
+		bool ok{true};
+		switch(c) {
+		case '&':
+			ok = endField(request, callback);
+			break;
+		case '=':
+			if(nameLength < 0) {
+				nameLength = length;
+				ok = put('\0');
 			} else {
-				state->postValue.concat(at, foundLength);
+				ok = put(c);
 			}
+			break;
+		case '+':
+			ok = put(' ');
+			break;
+		case '%':
+			escapeLength = 0;
+			break;
+		default:
+			ok = put(c);
 		}
 
-		if(found == nullptr) {
-			break;
+		if(!ok) {
+			error = true;
+			return i;
 		}
+	}
 
-		if(state->searchChar == '=') {
-			uri_unescape_inplace(state->postName);
-			state->searchChar = '&';
-		} else {
-			uri_unescape_inplace(state->postValue);
-			params[state->postName] = state->postValue;
-			state->searchChar = '=';
-			// Keep String memory allocated, but clear content
-			state->postName.setLength(0);
-			state->postValue.setLength(0);
+	return count;
+}
+
+bool FormUrlParser::finish(HttpRequest& request, const HttpFormFieldDelegate& callback)
+{
+	if(error) {
+		return false;
+	}
+	// Store last parameter, if there is one
+	if(length == 0 && escapeLength < 0) {
+		return true;
+	}
+	return endField(request, callback);
+}
+
+} // namespace
+
+size_t formUrlParser(HttpRequest& request, const char* at, int length)
+{
+	return formUrlFieldParser(request, at, length, nullptr);
+}
+
+size_t formUrlFieldParser(HttpRequest& request, const char* at, int length, const HttpFormFieldDelegate& callback)
+{
+	auto parser = static_cast<FormUrlParser*>(request.args);
+
+	if(length == PARSE_DATASTART) {
+		FormUrlParser::destroy(parser);
+		request.args = FormUrlParser::create(getContentLength(request));
+		return 0;
+	}
+
+	if(parser == nullptr) {
+		if(length != PARSE_DATAEND) {
+			debug_e("Invalid request argument");
 		}
-		++foundLength; // Skip the '=' or '&'
-		at += foundLength;
-		length -= foundLength;
+		return 0;
+	}
+
+	if(length == PARSE_DATAEND) {
+		parser->finish(request, callback);
+		FormUrlParser::destroy(parser);
+		request.args = nullptr;
+		return 0;
+	}
+
+	if(length < 0) {
+		return 0;
 	}
 
-	return consumed;
+	return parser->parse(request, at, length, callback);
 }
 
 size_t bodyToStringParser(HttpRequest& request, const char* at, int length)
@@ -108,8 +251,13 @@ size_t bodyToStringParser(HttpRequest& request, const char* at, int length)
 
 	if(length == PARSE_DATASTART) {
 		delete data;
-		data = new MemoryDataStream();
-		request.args = data;
+		auto stream = new MemoryDataStream();
+		// Content-Length is supplied by the client so don't trust it with more than a modest reservation
+		auto contentLength = std::min(getContentLength(request), size_t(HTTP_BODY_RESERVE_SIZE));
+		if(contentLength != 0) {
+			stream->ensureCapacity(contentLength);
+		}
+		request.args = stream;
 		return 0;
 	}
 
@@ -124,5 +272,13 @@ size_t bodyToStringParser(HttpRequest& request, const char* at, int length)
 		return 0;
 	}
 
+	// Stream only adds a little each time it expands, so grow in larger steps
+	auto stream = static_cast<MemoryDataStream*>(data);
+	size_t required = stream->getSize() + length;
+	if(required > stream->getCapacity()) {
+		auto capacity = std::min(stream->getCapacity() * 2, getContentLength(request));
+		stream->ensureCapacity(std::max(required, capacity));
+	}
+
 	return data->write(at, length);
 }
@@ -20,6 +20,20 @@
  * {
  */
 
+/**
+ * @brief Maximum size of buffer used to decode form fields
+ */
+#ifndef HTTP_FORM_BUFFER_SIZE
+#define HTTP_FORM_BUFFER_SIZE 1024
+#endif
+
+/**
+ * @brief Maximum storage reserved from Content-Length before any body content has arrived
+ */
+#ifndef HTTP_BODY_RESERVE_SIZE
+#define HTTP_BODY_RESERVE_SIZE 1024
+#endif
+
 /** @brief special length values passed to parse functions */
 const int PARSE_DATASTART = -1; ///< Start of incoming data
 const int PARSE_DATAEND = -2;   ///< End of incoming data
@@ -41,15 +55,48 @@ using HttpBodyParserDelegate = Delegate<size_t(HttpRequest& request, const char*
 using BodyParsers = HashMap<String, HttpBodyParserDelegate>;
 
 /**
- * @brief Parses application/x-www-form-urlencoded body data
+ * @brief Receives a decoded application/x-www-form-urlencoded field
+ * @param request
+ * @param name Decoded name, NUL-terminated
+ * @param nameLength
+ * @param value Decoded value, NUL-terminated
+ * @param valueLength
+ * @retval bool Return false to abort parsing
+ * @note Name and value refer to the parser's buffer so are only valid during the callback
+ */
+using HttpFormFieldDelegate = Delegate<bool(HttpRequest& request, const char* name, size_t nameLength,
+											const char* value, size_t valueLength)>;
+
+/**
+ * @brief Parses application/x-www-form-urlencoded body data into `HttpRequest::postParams`
  * @see `HttpBodyParserDelegate`
+ *
+ * Fields are decoded in a single pass into a buffer sized from the Content-Length header,
+ * limited by `HTTP_FORM_BUFFER_SIZE`. Each name/value pair must fit within this buffer.
  */
 size_t formUrlParser(HttpRequest& request, const char* at, int length);
 
+/**
+ * @brief Parses application/x-www-form-urlencoded body data and passes each field to a callback
+ * @param callback Invoked for each field. If empty, fields are stored in `HttpRequest::postParams`.
+ *
+ * Avoids creating a String for every name and value. Call from a body parser, for example:
+ *
+ * ```
+ * server.setBodyParser(MIME_FORM_URL_ENCODED, [](HttpRequest& request, const char* at, int length) {
+ *     return formUrlFieldParser(request, at, length, onFormField);
+ * });
+ * ```
+ */
+size_t formUrlFieldParser(HttpRequest& request, const char* at, int length, const HttpFormFieldDelegate& callback);
+
 /**
  * @brief Stores the complete body into memory
  * @see `HttpBodyParserDelegate`
  * @note The content later can be retrieved by calling request.getBody()
+ *
+ * Storage is reserved up-front from the Content-Length header, if present, up to `HTTP_BODY_RESERVE_SIZE`.
+ * Beyond that it grows as content arrives.
  */
 size_t bodyToStringParser(HttpRequest& request, const char* at, int length);
 
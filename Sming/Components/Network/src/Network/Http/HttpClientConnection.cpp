@@ -296,8 +296,7 @@ REENTER:
 			}
 
 			state = eHCS_Ready;
-			delete stream;
-			stream = nullptr;
+			freeStreams();
 			goto REENTER;
 		}
 		[[fallthrough]];
@@ -386,7 +385,7 @@ bool HttpClientConnection::sendRequestBody(HttpRequest* request)
 			return true;
 		}
 
-		delete stream;
+		freeStreams();
 		if(request->headers[HTTP_HEADER_TRANSFER_ENCODING] == _F("chunked")) {
 			stream = new ChunkedStream(request->bodyStream);
 		} else {
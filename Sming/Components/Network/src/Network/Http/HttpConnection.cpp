@@ -12,6 +12,7 @@
 
 #include "HttpConnection.h"
 #include <Network/NetUtils.h>
+#include <MallocTag.h>
 
 /** @brief http_parser function table
  *  @note stored in flash memory; as it is word-aligned it can be accessed directly
@@ -171,6 +172,7 @@ bool HttpConnection::onHttpError(HttpError error)
 
 bool HttpConnection::onTcpReceive(TcpClient&, char* data, int size)
 {
+	MALLOC_TAG_SCOPE(http);
 	if(HTTP_PARSER_ERRNO(&parser) != HPE_OK) {
 		// if the parser is in error state then just ignore the incoming data.
 		return true;
@@ -0,0 +1,143 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpEtagCache.cpp
+ *
+ ****/
+
+#include "HttpEtagCache.h"
+#include <DateTime.h>
+
+namespace
+{
+// Strip any weakness indicator, leaving the quoted opaque tag
+const char* opaqueTag(const char* tag)
+{
+	return (tag[0] == 'W' && tag[1] == '/') ? tag + 2 : tag;
+}
+
+} // namespace
+
+const HttpEtagCache::Entry* HttpEtagCache::find(const String& path, const String& acceptEncoding)
+{
+	if(HTTP_SERVER_ETAG_CACHE_SIZE == 0) {
+		return nullptr;
+	}
+
+	for(auto& e : entries) {
+		if(e.lastUsed != 0 && e.path == path && e.acceptEncoding == acceptEncoding) {
+			e.lastUsed = ++useCount;
+			return &e;
+		}
+	}
+
+	return nullptr;
+}
+
+void HttpEtagCache::update(const String& path, const String& etag, time_t lastModified,
+						   const String& acceptEncoding)
+{
+	if(HTTP_SERVER_ETAG_CACHE_SIZE == 0) {
+		return;
+	}
+
+	Entry* entry{nullptr};
+	for(auto& e : entries) {
+		if(e.lastUsed != 0 && e.path == path && e.acceptEncoding == acceptEncoding) {
+			entry = &e;
+			break;
+		}
+		if(entry == nullptr || e.lastUsed < entry->lastUsed) {
+			entry = &e;
+		}
+	}
+
+	entry->path = path;
+	entry->acceptEncoding = acceptEncoding;
+	entry->etag = etag;
+	entry->lastModified = lastModified;
+	entry->lastUsed = ++useCount;
+}
+
+bool HttpEtagCache::invalidate(const String& path)
+{
+	bool removed{false};
+	for(auto& e : entries) {
+		if(e.lastUsed != 0 && e.path == path) {
+			e = Entry{};
+			removed = true;
+		}
+	}
+
+	return removed;
+}
+
+void HttpEtagCache::clear()
+{
+	for(auto& e : entries) {
+		e = Entry{};
+	}
+	useCount = 0;
+}
+
+unsigned HttpEtagCache::count() const
+{
+	unsigned n{0};
+	for(auto& e : entries) {
+		if(e.lastUsed != 0) {
+			++n;
+		}
+	}
+	return n;
+}
+
+bool HttpEtagCache::etagListContains(const String& list, const String& etag, bool matchAny)
+{
+	auto tag = opaqueTag(etag.c_str());
+	auto tagLength = strlen(tag);
+
+	auto p = list.c_str();
+	for(;;) {
+		while(*p == ' ' || *p == '\t' || *p == ',') {
+			++p;
+		}
+		if(*p == '\0') {
+			return false;
+		}
+		if(*p == '*') {
+			return matchAny;
+		}
+
+		auto item = opaqueTag(p);
+		auto end = strchr(item, ',');
+		size_t length = end ? end - item : strlen(item);
+		while(length != 0 && (item[length - 1] == ' ' || item[length - 1] == '\t')) {
+			--length;
+		}
+		if(tagLength != 0 && length == tagLength && memcmp(item, tag, length) == 0) {
+			return true;
+		}
+		if(end == nullptr) {
+			return false;
+		}
+		p = end;
+	}
+}
+
+bool HttpEtagCache::isNotModified(const HttpHeaders& requestHeaders, const String& etag, time_t lastModified,
+								  bool matchAny)
+{
+	if(requestHeaders.contains(HTTP_HEADER_IF_NONE_MATCH)) {
+		return etagListContains(requestHeaders[HTTP_HEADER_IF_NONE_MATCH], etag, matchAny);
+	}
+
+	if(lastModified != 0 && requestHeaders.contains(HTTP_HEADER_IF_MODIFIED_SINCE)) {
+		time_t since;
+		return DateTime::fromHttpDate(requestHeaders[HTTP_HEADER_IF_MODIFIED_SINCE], since) && lastModified <= since;
+	}
+
+	return false;
+}
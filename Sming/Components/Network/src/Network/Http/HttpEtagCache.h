@@ -0,0 +1,107 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpEtagCache.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpHeaders.h"
+#include <ctime>
+
+/**
+ * @brief Number of file validators retained by the HTTP server
+ *
+ * Set to 0 to disable the cache. Conditional requests are still evaluated,
+ * but the resource must be opened to obtain its validators.
+ */
+#ifndef HTTP_SERVER_ETAG_CACHE_SIZE
+#define HTTP_SERVER_ETAG_CACHE_SIZE 8
+#endif
+
+/**
+ * @brief Small LRU cache mapping requests to the validators of the file last sent for them
+ *
+ * Allows the server to answer a conditional GET with `304 Not Modified` without invoking the resource
+ * handler, so the file is not opened at all. Resources must opt in via `HttpResource::useEtagCache`.
+ *
+ * Only responses consisting of a plain file are cached, keyed by path and `Accept-Encoding` request header
+ * since that may select a pre-compressed variant.
+ * If files are modified at runtime the application must call `invalidate()` or `clear()`
+ * otherwise clients may be told their stale copy is current.
+ *
+ * @ingroup httpserver
+ */
+class HttpEtagCache
+{
+public:
+	struct Entry {
+		String path;			///< Request path including any query
+		String acceptEncoding;	///< Request `Accept-Encoding` header, which may select the file variant
+		String etag;			///< Quoted entity tag, as sent in the `ETag` header
+		time_t lastModified{0}; ///< Modification time, 0 if unknown
+		uint32_t lastUsed{0};	///< For LRU replacement
+	};
+
+	/**
+	 * @brief Find validators for a path
+	 * @param path
+	 * @param acceptEncoding Value of request header
+	 * @retval const Entry* nullptr if path is not cached
+	 */
+	const Entry* find(const String& path, const String& acceptEncoding = nullptr);
+
+	/**
+	 * @brief Add or replace validators for a path, evicting the least recently used entry if necessary
+	 */
+	void update(const String& path, const String& etag, time_t lastModified, const String& acceptEncoding = nullptr);
+
+	/**
+	 * @brief Remove all entries for the given path
+	 * @retval bool true if an entry was removed
+	 */
+	bool invalidate(const String& path);
+
+	/**
+	 * @brief Remove all entries
+	 */
+	void clear();
+
+	/**
+	 * @brief Get number of cached entries
+	 */
+	unsigned count() const;
+
+	/**
+	 * @brief Determine if an entity tag appears in an `If-None-Match` list
+	 * @param list Header value, e.g. `"abc", W/"def"` or `*`
+	 * @param etag Quoted entity tag of the current representation
+	 * @param matchAny true if `*` matches, i.e. the representation is known to exist
+	 *
+	 * Uses the weak comparison function of RFC 7232 2.3.2, so `W/` prefixes are ignored.
+	 */
+	static bool etagListContains(const String& list, const String& etag, bool matchAny = true);
+
+	/**
+	 * @brief Evaluate `If-None-Match` and `If-Modified-Since` request headers, as per RFC 7232 section 6
+	 * @param requestHeaders
+	 * @param etag Quoted entity tag of the current representation, empty if none
+	 * @param lastModified Modification time of the current representation, 0 if unknown
+	 * @param matchAny true if `If-None-Match: *` matches, see `etagListContains()`
+	 * @retval bool true if the client's copy is current and a `304 Not Modified` response should be sent
+	 *
+	 * `If-Modified-Since` is ignored when `If-None-Match` is present.
+	 */
+	static bool isNotModified(const HttpHeaders& requestHeaders, const String& etag, time_t lastModified,
+							  bool matchAny = true);
+
+private:
+	static constexpr unsigned maxEntries{HTTP_SERVER_ETAG_CACHE_SIZE > 0 ? HTTP_SERVER_ETAG_CACHE_SIZE : 1};
+
+	Entry entries[maxEntries];
+	uint32_t useCount{0};
+};
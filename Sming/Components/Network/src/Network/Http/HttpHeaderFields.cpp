@@ -80,6 +80,58 @@ String HttpHeaderFields::toString(const String& name, const String& value)
 	return s;
 }
 
+size_t HttpHeaderFields::serialize(char* buffer, HttpHeaderFieldName name, const String& value) const
+{
+	const FlashString* fieldName{nullptr};
+	const char* customName{nullptr};
+	size_t nameLength{0};
+	if(name == HTTP_HEADER_UNKNOWN) {
+		// Empty name
+	} else if(name < HTTP_HEADER_CUSTOM) {
+		fieldName = &fieldNameStrings[unsigned(name) - 1];
+		nameLength = fieldName->length();
+	} else {
+		customName = customFieldNames[unsigned(name) - unsigned(HTTP_HEADER_CUSTOM)];
+		nameLength = customName ? strlen(customName) : 0;
+	}
+
+	auto writeLine = [&](const char* str, size_t length) -> size_t {
+		size_t lineLength = nameLength + 2 + length + 2;
+		if(buffer == nullptr) {
+			return lineLength;
+		}
+		if(fieldName != nullptr) {
+			fieldName->read(0, buffer, nameLength);
+		} else {
+			memcpy(buffer, customName, nameLength);
+		}
+		auto p = buffer + nameLength;
+		*p++ = ':';
+		*p++ = ' ';
+		memcpy(p, str, length);
+		p += length;
+		*p++ = '\r';
+		*p++ = '\n';
+		buffer = p;
+		return lineLength;
+	};
+
+	if(!getFlags(name)[Flag::Multi]) {
+		return writeLine(value.c_str(), value.length());
+	}
+
+	// Multiple values are separated by NUL characters, output each on a separate line
+	size_t n{0};
+	auto str = value.c_str();
+	size_t pos{0};
+	while(pos < value.length()) {
+		auto length = strlen(&str[pos]);
+		n += writeLine(&str[pos], length);
+		pos += length + 1;
+	}
+	return n;
+}
+
 HttpHeaderFieldName HttpHeaderFields::fromString(const String& name) const
 {
 	auto index = fieldNameStrings.indexOf(name);
@@ -59,7 +59,17 @@ bool HttpHeaders::append(const HttpHeaderFieldName& name, const String& value)
 
 void HttpHeaders::setMultiple(const HttpHeaders& headers)
 {
+	allocate(count() + headers.count());
 	for(auto hdr : headers) {
 		operator[](hdr.getFieldName()) = hdr.value();
 	}
 }
+
+size_t HttpHeaders::serialize(char* buffer) const
+{
+	size_t n{0};
+	for(unsigned i = 0; i < count(); ++i) {
+		n += serialize(buffer ? &buffer[n] : nullptr, keyAt(i), valueAt(i));
+	}
+	return n;
+}
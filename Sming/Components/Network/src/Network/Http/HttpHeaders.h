@@ -123,6 +123,16 @@ public:
 		return toString(elem.key(), elem.value());
 	}
 
+	using HttpHeaderFields::serialize;
+
+	/**
+	 * @brief Serialize all header fields for output in the HTTP header
+	 * @param buffer Output buffer, or nullptr to obtain the required length
+	 * @retval size_t Number of characters written (or required)
+	 * @note Does not include the blank line which terminates the header
+	 */
+	size_t serialize(char* buffer) const;
+
 	using HashMap::contains;
 
 	/**
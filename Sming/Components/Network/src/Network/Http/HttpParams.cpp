@@ -43,7 +43,7 @@ void HttpParams::parseQuery(char* query)
 	for(int i = 0; i < paramCount; ++i) {
 		String key = uri_unescape_inplace(params[i].key);
 		String value = uri_unescape_inplace(params[i].val);
-		operator[](key) = value;
+		set(std::move(key), std::move(value));
 	}
 }
 
@@ -0,0 +1,111 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpPathParameters.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+/**
+ * @brief Maximum number of parameters which may be captured from a request path
+ */
+#ifndef HTTP_MAX_PATH_PARAMETERS
+#define HTTP_MAX_PATH_PARAMETERS 4
+#endif
+
+/**
+ * @brief Parameters captured from a request path when matching a resource
+ * @ingroup http
+ *
+ * For example, a resource registered as `/api/device/:id/state` matching the request
+ * path `/api/device/12/state` captures one parameter named `id`.
+ *
+ * Values are stored as a position within the path so no memory is allocated during matching.
+ * Names refer to the resource tree and remain valid until it is modified.
+ */
+class HttpPathParameters
+{
+public:
+	struct Param {
+		const char* name; ///< Parameter name, without leading ':' or '*'
+		uint16_t offset;  ///< Position of value within the path
+		uint16_t length;  ///< Length of value
+	};
+
+	void clear()
+	{
+		paramCount = 0;
+	}
+
+	/**
+	 * @brief Add a parameter
+	 * @retval bool false if there is no room
+	 */
+	bool add(const char* name, uint16_t offset, uint16_t length)
+	{
+		if(paramCount >= HTTP_MAX_PATH_PARAMETERS) {
+			return false;
+		}
+		params[paramCount++] = Param{name, offset, length};
+		return true;
+	}
+
+	/**
+	 * @brief Remove the most recently added parameter
+	 */
+	void removeLast()
+	{
+		if(paramCount != 0) {
+			--paramCount;
+		}
+	}
+
+	unsigned count() const
+	{
+		return paramCount;
+	}
+
+	const Param& operator[](unsigned index) const
+	{
+		return params[index];
+	}
+
+	/**
+	 * @brief Find a parameter by name
+	 * @retval int Index of parameter, -1 if not found
+	 */
+	int indexOf(const char* name) const
+	{
+		for(unsigned i = 0; i < paramCount; ++i) {
+			if(strcmp(params[i].name, name) == 0) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Get the value of a parameter
+	 * @param path The path the parameters were captured from
+	 * @param index
+	 * @retval String
+	 */
+	String getValue(const String& path, unsigned index) const
+	{
+		if(index >= paramCount) {
+			return nullptr;
+		}
+		auto& param = params[index];
+		return String(path.c_str() + param.offset, param.length);
+	}
+
+private:
+	Param params[HTTP_MAX_PATH_PARAMETERS];
+	uint8_t paramCount{0};
+};
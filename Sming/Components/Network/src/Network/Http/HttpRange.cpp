@@ -0,0 +1,132 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRange.cpp
+ *
+ ****/
+
+#include "HttpRange.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+namespace
+{
+const char* skipSpace(const char* p)
+{
+	while(*p == ' ' || *p == '\t') {
+		++p;
+	}
+	return p;
+}
+
+bool parseNumber(const char*& p, size_t& value)
+{
+	if(!isdigit(*p)) {
+		return false;
+	}
+	// Values too large to represent saturate, so are treated as unsatisfiable rather than malformed
+	char* end;
+	value = strtoul(p, &end, 10);
+	p = end;
+	return true;
+}
+
+} // namespace
+
+HttpRangeList::Result HttpRangeList::parse(const char* value, size_t contentLength)
+{
+	rangeCount = 0;
+
+	if(value == nullptr || strncasecmp(value, _F("bytes="), 6) != 0) {
+		return Result::ignore;
+	}
+
+	unsigned specCount{0};
+	auto p = value + 6;
+	for(;;) {
+		p = skipSpace(p);
+		if(*p == ',') {
+			// Empty list elements are permitted
+			++p;
+			continue;
+		}
+		if(*p == '\0') {
+			break;
+		}
+
+		size_t first;
+		size_t last{SIZE_MAX};
+		if(*p == '-') {
+			// Suffix range: final N bytes
+			++p;
+			size_t suffixLength;
+			if(!parseNumber(p, suffixLength)) {
+				return Result::ignore;
+			}
+			if(suffixLength == 0) {
+				first = SIZE_MAX;
+			} else {
+				first = (suffixLength < contentLength) ? contentLength - suffixLength : 0;
+			}
+		} else {
+			if(!parseNumber(p, first) || *p++ != '-') {
+				return Result::ignore;
+			}
+			if(parseNumber(p, last) && last < first) {
+				return Result::ignore;
+			}
+		}
+
+		p = skipSpace(p);
+		if(*p != ',' && *p != '\0') {
+			return Result::ignore;
+		}
+
+		++specCount;
+		if(first >= contentLength) {
+			continue;
+		}
+		if(rangeCount == HTTP_SERVER_MAX_RANGES) {
+			rangeCount = 0;
+			return Result::ignore;
+		}
+		ranges[rangeCount++] = HttpRange{first, std::min(last, contentLength - 1)};
+	}
+
+	if(rangeCount != 0) {
+		return Result::satisfiable;
+	}
+
+	return (specCount == 0) ? Result::ignore : Result::unsatisfiable;
+}
+
+size_t HttpRangeList::totalLength() const
+{
+	size_t length{0};
+	for(unsigned i = 0; i < rangeCount; ++i) {
+		length += ranges[i].length();
+	}
+	return length;
+}
+
+String HttpRangeList::contentRange(const HttpRange& range, size_t contentLength)
+{
+	String s = F("bytes ");
+	s += range.first;
+	s += '-';
+	s += range.last;
+	s += '/';
+	s += contentLength;
+	return s;
+}
+
+String HttpRangeList::contentRange(size_t contentLength)
+{
+	String s = F("bytes */");
+	s += contentLength;
+	return s;
+}
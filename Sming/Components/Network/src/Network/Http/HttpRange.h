@@ -0,0 +1,100 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRange.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+/**
+ * @brief Maximum number of ranges accepted in a `Range` request header
+ *
+ * Requests for more ranges are answered with the complete resource.
+ * Set to 0 to disable range support in the HTTP server.
+ */
+#ifndef HTTP_SERVER_MAX_RANGES
+#define HTTP_SERVER_MAX_RANGES 8
+#endif
+
+/**
+ * @brief A span of bytes within a resource
+ * @ingroup http
+ */
+struct HttpRange {
+	size_t first; ///< Offset of first byte
+	size_t last;  ///< Offset of last byte, inclusive
+
+	size_t length() const
+	{
+		return last + 1 - first;
+	}
+};
+
+/**
+ * @brief Byte ranges requested via a `Range` header, as described in RFC 7233
+ * @ingroup http
+ */
+class HttpRangeList
+{
+public:
+	enum class Result {
+		ignore,		   ///< Header is malformed, uses another unit or has too many ranges: send complete resource
+		satisfiable,   ///< At least one range overlaps the resource
+		unsatisfiable, ///< No range overlaps the resource
+	};
+
+	/**
+	 * @brief Parse a `Range` header value
+	 * @param value For example, "bytes=0-499,1000-"
+	 * @param contentLength Size of the complete resource
+	 * @retval Result
+	 *
+	 * Ranges are clipped to the resource size. Those which lie entirely outside it are discarded.
+	 */
+	Result parse(const char* value, size_t contentLength);
+
+	/**
+	 * @brief Get number of satisfiable ranges
+	 */
+	unsigned count() const
+	{
+		return rangeCount;
+	}
+
+	const HttpRange& operator[](unsigned index) const
+	{
+		return ranges[index];
+	}
+
+	/**
+	 * @brief Get total number of bytes in all ranges
+	 */
+	size_t totalLength() const;
+
+	/**
+	 * @brief Get the `Content-Range` header value for a range
+	 * @param range
+	 * @param contentLength Size of the complete resource
+	 * @retval String For example, "bytes 0-499/1234"
+	 */
+	static String contentRange(const HttpRange& range, size_t contentLength);
+
+	/**
+	 * @brief Get the `Content-Range` header value sent with a `416 Range Not Satisfiable` response
+	 * @param contentLength Size of the complete resource
+	 * @retval String For example, "bytes * /1234" (without the space)
+	 */
+	static String contentRange(size_t contentLength);
+
+private:
+	static constexpr unsigned maxRanges{HTTP_SERVER_MAX_RANGES > 0 ? HTTP_SERVER_MAX_RANGES : 1};
+
+	HttpRange ranges[maxRanges];
+	unsigned rangeCount{0};
+};
@@ -65,6 +65,7 @@ void HttpRequest::reset()
 	postParams.clear();
 	files.clear();
 	headers.clear();
+	pathParams.clear();
 }
 
 String HttpRequest::toString() const
@@ -20,6 +20,7 @@
 #include "Data/Stream/DataSourceStream.h"
 #include "HttpHeaders.h"
 #include "HttpParams.h"
+#include "HttpPathParameters.h"
 #include "Data/ObjectMap.h"
 
 class HttpConnection;
@@ -156,6 +157,18 @@ public:
 		return uri.getQueryParameter(name, defaultValue);
 	}
 
+	/**
+	 * @brief Get parameter captured from the path when matching a resource
+	 * @param name Name of parameter, e.g. "id" for a resource registered as "/api/device/:id/state"
+	 * @param defaultValue Optional default value to use if requested parameter not present
+	 * @see HttpResourceTree
+	 */
+	String getPathParameter(const char* name, const String& defaultValue = nullptr) const
+	{
+		int i = pathParams.indexOf(name);
+		return (i < 0) ? defaultValue : pathParams.getValue(uri.Path, i);
+	}
+
 	/**
 	 * @brief Moves content from the body stream into a String.
 	 * @retval String
@@ -279,11 +292,12 @@ public:
 	}
 
 public:
-	Url uri;					  ///< Request URL
-	HttpMethod method = HTTP_GET; ///< Request method
-	HttpHeaders headers;		  ///< Request headers
-	HttpParams postParams;		  ///< POST parameters
-	HttpFiles files;			  ///< Attached files
+	Url uri;					   ///< Request URL
+	HttpMethod method = HTTP_GET;  ///< Request method
+	HttpHeaders headers;		   ///< Request headers
+	HttpParams postParams;		   ///< POST parameters
+	HttpFiles files;			   ///< Attached files
+	HttpPathParameters pathParams; ///< Parameters captured from path by server resource tree
 
 	int retries = 0; ///< how many times the request should be send again...
 
@@ -65,6 +65,13 @@ int HttpResource::handleRequest(HttpServerConnection& connection, HttpRequest& r
 	FUNCTION_TEMPLATE(onRequestComplete, requestComplete, response)
 }
 
+int HttpResource::handleNotModified(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response)
+{
+	// Response already set from cached validators, so only plugins need to see it
+	HttpResourceDelegate noHandler;
+	FUNCTION_TEMPLATE(noHandler, requestComplete, response)
+}
+
 void HttpResource::addPlugin(HttpResourcePlugin* plugin)
 {
 	if(plugin == nullptr) {
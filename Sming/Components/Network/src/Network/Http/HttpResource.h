@@ -67,6 +67,24 @@ public:
 	HttpResourceDelegate onRequestComplete = nullptr;		 ///< request is complete OR upgraded
 	HttpServerConnectionUpgradeDelegate onUpgrade = nullptr; ///< request is upgraded and raw data is passed to it
 
+	/**
+	 * @brief Value for the `Cache-Control` header of successful responses, e.g. "max-age=3600"
+	 *
+	 * Applied to `200 OK` and `304 Not Modified` responses unless the handler sets the header itself.
+	 */
+	String cacheControl;
+
+	/**
+	 * @brief Allow conditional requests to be answered from the server's `etagCache`
+	 *
+	 * When set, a conditional GET whose validators match those cached for the request path
+	 * gets `304 Not Modified` without calling `onRequestComplete`. Plugins are still invoked.
+	 *
+	 * Only enable this where the response depends solely on the path and `Accept-Encoding` header,
+	 * as with static files. Leave it clear if the handler selects content per request, e.g. by session.
+	 */
+	bool useEtagCache{false};
+
 	void addPlugin(HttpResourcePlugin* plugin);
 
 	template <class... Tail> void addPlugin(HttpResourcePlugin* plugin, Tail... plugins)
@@ -85,4 +103,5 @@ private:
 	int handleUpgrade(HttpServerConnection& connection, HttpRequest& request, char* data, size_t length);
 	int handleBody(HttpServerConnection& connection, HttpRequest& request, char*& data, size_t& length);
 	int handleRequest(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
+	int handleNotModified(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
 };
@@ -31,8 +31,194 @@ private:
 	HttpPathDelegate callback;
 };
 
+/*
+ * Radix tree node. Literal children are distinguished by their first character.
+ */
+struct HttpResourceTree::Node {
+	String label;					///< Literal text matched by this node
+	String name;					///< Parameter name for parameter and wildcard nodes
+	std::unique_ptr<Node> child;	///< First literal child
+	std::unique_ptr<Node> next;		///< Next sibling
+	std::unique_ptr<Node> param;	///< Matches a single path segment
+	std::unique_ptr<Node> wildcard; ///< Matches remainder of path
+	int index{-1};					///< Resource index, -1 if none
+
+	Node* addLiteral(const char* text, size_t length);
+	Node* addCapture(std::unique_ptr<Node>& slot, const char* text, size_t length);
+	void add(const String& path, int resourceIndex);
+	int match(const char* path, const char* pos, const char* end, HttpPathParameters& params) const;
+};
+
+HttpResourceTree::Node* HttpResourceTree::Node::addLiteral(const char* text, size_t length)
+{
+	auto node = this;
+	auto slot = &child;
+	while(length != 0) {
+		while(*slot && (*slot)->label[0] != *text) {
+			slot = &(*slot)->next;
+		}
+		if(!*slot) {
+			slot->reset(new Node);
+			(*slot)->label.setString(text, length);
+			return slot->get();
+		}
+
+		auto& existing = **slot;
+		size_t common{1};
+		while(common < length && common < existing.label.length() && existing.label[common] == text[common]) {
+			++common;
+		}
+		if(common < existing.label.length()) {
+			// Split existing node at end of common prefix
+			std::unique_ptr<Node> prefix(new Node);
+			prefix->label.setString(existing.label.c_str(), common);
+			existing.label.remove(0, common);
+			prefix->next = std::move(existing.next);
+			prefix->child = std::move(*slot);
+			*slot = std::move(prefix);
+		}
+
+		node = slot->get();
+		slot = &node->child;
+		text += common;
+		length -= common;
+	}
+	return node;
+}
+
+HttpResourceTree::Node* HttpResourceTree::Node::addCapture(std::unique_ptr<Node>& slot, const char* text,
+														   size_t length)
+{
+	if(!slot) {
+		slot.reset(new Node);
+		slot->name.setString(text, length);
+	} else if(!slot->name.equals(text, length)) {
+		debug_w("[HTTP] Parameter '%s' already registered as '%s'", String(text, length).c_str(),
+				slot->name.c_str());
+	}
+	return slot.get();
+}
+
+void HttpResourceTree::Node::add(const String& path, int resourceIndex)
+{
+	auto node = this;
+	auto start = path.c_str();
+	auto end = start + path.length();
+	auto isCapture = [&](const char* p) { return (*p == ':' || *p == '*') && (p == start || p[-1] == '/'); };
+
+	auto p = start;
+	while(p < end) {
+		auto text = p;
+		if(isCapture(p)) {
+			bool isWildcard = (*p == '*');
+			++text;
+			do {
+				++p;
+			} while(p < end && *p != '/');
+			node = addCapture(isWildcard ? node->wildcard : node->param, text, p - text);
+			if(isWildcard) {
+				if(p < end) {
+					debug_w("[HTTP] '%s': wildcard must be final segment", path.c_str());
+				}
+				break;
+			}
+			continue;
+		}
+
+		do {
+			++p;
+		} while(p < end && !isCapture(p));
+		node = node->addLiteral(text, p - text);
+	}
+
+	if(node->index >= 0) {
+		debug_w("[HTTP] '%s' hidden by another path", path.c_str());
+		return;
+	}
+	node->index = resourceIndex;
+}
+
+int HttpResourceTree::Node::match(const char* path, const char* pos, const char* end, HttpPathParameters& params) const
+{
+	if(pos == end && index >= 0) {
+		return index;
+	}
+
+	if(pos < end) {
+		// Only one literal child can start with this character
+		for(auto node = child.get(); node != nullptr; node = node->next.get()) {
+			if(node->label[0] != *pos) {
+				continue;
+			}
+			auto len = node->label.length();
+			if(size_t(end - pos) >= len && memcmp(node->label.c_str(), pos, len) == 0) {
+				int i = node->match(path, pos + len, end, params);
+				if(i >= 0) {
+					return i;
+				}
+			}
+			break;
+		}
+
+		if(param && *pos != '/') {
+			auto segmentEnd = pos;
+			while(segmentEnd < end && *segmentEnd != '/') {
+				++segmentEnd;
+			}
+			if(params.add(param->name.c_str(), pos - path, segmentEnd - pos)) {
+				int i = param->match(path, segmentEnd, end, params);
+				if(i >= 0) {
+					return i;
+				}
+				params.removeLast();
+			}
+		}
+	}
+
+	if(wildcard && wildcard->index >= 0 && params.add(wildcard->name.c_str(), pos - path, end - pos)) {
+		return wildcard->index;
+	}
+
+	return -1;
+}
+
 /* HttpResourceTree */
 
+HttpResourceTree::HttpResourceTree() = default;
+
+HttpResourceTree::~HttpResourceTree() = default;
+
+void HttpResourceTree::compile()
+{
+	root.reset(new Node);
+	for(unsigned i = 0; i < count(); ++i) {
+		auto& path = static_cast<const HttpResourceTree&>(*this).keyAt(i);
+		if(path != RESOURCE_PATH_DEFAULT) {
+			root->add(path, i);
+		}
+	}
+	compiledRevision = getRevision();
+}
+
+HttpResource* HttpResourceTree::match(const String& path, HttpPathParameters& params)
+{
+	params.clear();
+
+	// Paths may also be changed via ObjectMap::Value, so check revision rather than tracking calls
+	if(!root || compiledRevision != getRevision()) {
+		compile();
+	}
+
+	auto start = path.c_str();
+	int i = root->match(start, start, start + path.length(), params);
+	if(i < 0) {
+		params.clear();
+		return nullptr;
+	}
+
+	return entries[i].value.get();
+}
+
 HttpResource* HttpResourceTree::set(const String& path, const HttpResourceDelegate& onRequestComplete)
 {
 	auto resource = new HttpResource;
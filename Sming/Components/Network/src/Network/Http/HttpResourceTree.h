@@ -13,6 +13,8 @@
 #pragma once
 
 #include "HttpResource.h"
+#include "HttpPathParameters.h"
+#include <memory>
 
 using HttpPathDelegate = Delegate<void(HttpRequest& request, HttpResponse& response)>;
 
@@ -22,10 +24,23 @@ using HttpPathDelegate = Delegate<void(HttpRequest& request, HttpResponse& respo
 /**
  * @brief Class to map URL paths to classes which handle them
  * @ingroup httpserver
+ *
+ * Paths may contain parameter segments, such as `/api/device/:id/state`,
+ * which match any single path segment. A final wildcard segment, prefixed with `*` as in `*path`,
+ * matches the remainder of the path. Captured values are available to handlers via
+ * `HttpRequest::getPathParameter()`. Where several paths could match,
+ * literal segments take precedence over parameters and wildcards.
+ *
+ * Paths are compiled into a radix tree on first use so matching time depends only
+ * on the length of the request path, not the number of resources.
+ * The tree is rebuilt after resources are added or removed.
  */
 class HttpResourceTree : public ObjectMap<String, HttpResource>
 {
 public:
+	HttpResourceTree();
+	~HttpResourceTree();
+
 	/** @brief Set the default resource handler
 	 *  @param resource The default resource handler
 	 */
@@ -57,6 +72,14 @@ public:
 		return find(RESOURCE_PATH_DEFAULT);
 	}
 
+	/**
+	 * @brief Find the resource to handle a request path
+	 * @param path The request path
+	 * @param params Receives any parameters captured from the path
+	 * @retval HttpResource* The matching resource, nullptr if none. The default resource is not considered.
+	 */
+	HttpResource* match(const String& path, HttpPathParameters& params);
+
 	using ObjectMap::set;
 
 	template <class... Tail>
@@ -125,6 +148,10 @@ public:
 	}
 
 private:
+	struct Node;
+
+	void compile();
+
 	void registerPlugin(HttpResourcePlugin* plugin)
 	{
 		loadedPlugins.add(plugin);
@@ -137,4 +164,6 @@ private:
 	}
 
 	HttpResourcePlugin::OwnedList loadedPlugins;
+	std::unique_ptr<Node> root; ///< Compiled paths
+	unsigned compiledRevision{0}; ///< ObjectMap revision when tree was compiled
 };
@@ -40,6 +40,13 @@ HttpResponse* HttpResponse::setCache(int maxAgeSeconds, bool isPublic)
 	return this;
 }
 
+void HttpResponse::setLastModified(time_t mtime)
+{
+	if(mtime != 0 && !headers.contains(HTTP_HEADER_LAST_MODIFIED)) {
+		headers[HTTP_HEADER_LAST_MODIFIED] = DateTime(mtime).toHTTPDate();
+	}
+}
+
 bool HttpResponse::sendString(const String& text)
 {
 	auto memoryStream = new MemoryDataStream();
@@ -67,11 +74,31 @@ bool HttpResponse::sendFile(const String& fileName, bool allowGzipFileCheck)
 	auto fs = new FileStream;
 
 	if(allowGzipFileCheck) {
-		String fnCompressed = fileName + _F(".gz");
-		if(fs->open(fnCompressed)) {
-			debug_d("found %s", fnCompressed.c_str());
-			headers[HTTP_HEADER_CONTENT_ENCODING] = F("gzip");
-			return sendDataStream(fs, ContentType::fromFullFileName(fileName));
+		// Response depends on the request Accept-Encoding header
+		headers[HTTP_HEADER_VARY] = headers.toString(HTTP_HEADER_ACCEPT_ENCODING);
+
+		// Try variants in order of client preference
+		constexpr unsigned variants{HttpAcceptEncoding::mask(HttpContentCoding::br) |
+									HttpAcceptEncoding::mask(HttpContentCoding::gzip) |
+									HttpAcceptEncoding::mask(HttpContentCoding::identity)};
+		HttpContentCoding coding;
+		for(unsigned available = variants; acceptEncoding.select(available, coding);
+			available &= ~HttpAcceptEncoding::mask(coding)) {
+			if(coding == HttpContentCoding::identity) {
+				if(fileExist(fileName)) {
+					break;
+				}
+				continue;
+			}
+			String fnCompressed = fileName + getFileExtension(coding);
+			if(fs->open(fnCompressed)) {
+				debug_d("found %s", fnCompressed.c_str());
+				headers[HTTP_HEADER_CONTENT_ENCODING] = ::toString(coding);
+				FileStat stat;
+				fs->stat(stat);
+				setLastModified(stat.mtime);
+				return sendDataStream(fs, ContentType::fromFullFileName(fileName));
+			}
 		}
 	}
 
@@ -79,6 +106,7 @@ bool HttpResponse::sendFile(const String& fileName, bool allowGzipFileCheck)
 		debug_d("found %s", fileName.c_str());
 		FileStat stat;
 		fs->stat(stat);
+		setLastModified(stat.mtime);
 		if(stat.compression.type == IFS::Compression::Type::GZip) {
 			headers[HTTP_HEADER_CONTENT_ENCODING] = F("gzip");
 		} else if(stat.compression.type != IFS::Compression::Type::None) {
@@ -126,6 +154,7 @@ void HttpResponse::reset()
 {
 	code = HTTP_STATUS_OK;
 	headers.clear();
+	acceptEncoding = HttpAcceptEncoding{};
 	freeStreams();
 }
 
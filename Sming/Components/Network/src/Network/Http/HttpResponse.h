@@ -15,6 +15,7 @@
 #include "HttpCommon.h"
 #include "Data/Stream/ReadWriteStream.h"
 #include "HttpHeaders.h"
+#include "HttpAcceptEncoding.h"
 #include "FileSystem.h"
 
 /**
@@ -65,7 +66,9 @@ public:
 	/**
 	 * @brief Send file by name
 	 * @param fileName
-	 * @param allowGzipFileCheck If true, check file extension to see if content compressed
+	 * @param allowGzipFileCheck If true, look for pre-compressed variants of the file,
+	 * such as `fileName.br` or `fileName.gz`, and send the one preferred by `acceptEncoding`.
+	 * The plain file is sent if no acceptable variant exists.
 	 * @retval bool
 	 */
 	bool sendFile(const String& fileName, bool allowGzipFileCheck = true);
@@ -144,12 +147,20 @@ public:
 
 private:
 	void setStream(IDataSourceStream* stream);
+	void setLastModified(time_t mtime);
 
 public:
 	HttpStatus code = HTTP_STATUS_OK;	///< The HTTP status response code
 	HttpHeaders headers;				 ///< Response headers
 	ReadWriteStream* buffer = nullptr;   ///< Internal stream for storing strings and receiving responses
 	IDataSourceStream* stream = nullptr; ///< The body stream
+	/**
+	 * @brief Content codings acceptable to the client, set by the server from the request `Accept-Encoding` header
+	 *
+	 * Used by `sendFile()` to select a pre-compressed variant.
+	 * Applications can check this before compressing dynamic content.
+	 */
+	HttpAcceptEncoding acceptEncoding;
 };
 
 inline String toString(const HttpResponse& res)
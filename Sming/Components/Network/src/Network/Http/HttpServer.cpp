@@ -33,6 +33,9 @@ TcpConnection* HttpServer::createClient(tcp_pcb* clientTcp)
 	con->setResourceTree(&paths);
 	con->setBodyParsers(&bodyParsers);
 	con->setCloseOnContentError(settings.closeOnContentError);
+#if HTTP_SERVER_ETAG_CACHE_SIZE > 0
+	con->setEtagCache(&etagCache);
+#endif
 
 	return con;
 }
@@ -80,6 +80,14 @@ public:
 	/** @brief Maps paths to resources which deal with incoming requests */
 	HttpResourceTree paths;
 
+#if HTTP_SERVER_ETAG_CACHE_SIZE > 0
+	/**
+	 * @brief Validators of files recently sent, used to answer conditional requests
+	 * @note Call `etagCache.invalidate()` or `etagCache.clear()` if files are modified at runtime
+	 */
+	HttpEtagCache etagCache;
+#endif
+
 protected:
 	TcpConnection* createClient(tcp_pcb* clientTcp) override;
 
@@ -16,12 +16,48 @@
 #include "Network/TcpServer.h"
 #include <Data/WebConstants.h>
 #include "Data/Stream/ChunkedStream.h"
+#include "Data/Stream/ByteRangeStream.h"
+#include <Data/Stream/MemoryDataStream.h>
+#include <stringconversion.h>
 #include <SystemClock.h>
 
 #if HTTP_SERVER_EXPOSE_VERSION == 1
 #include <SmingVersion.h>
 #endif
 
+namespace
+{
+/*
+ * If-Range contains either an entity tag or a date, which must exactly match the current resource.
+ * Weak entity tags never match.
+ */
+bool ifRangeMatches(const String& ifRange, const HttpHeaders& responseHeaders)
+{
+	if(ifRange.startsWith("W/")) {
+		return false;
+	}
+	auto field = (ifRange[0] == '"') ? HTTP_HEADER_ETAG : HTTP_HEADER_LAST_MODIFIED;
+	return responseHeaders.contains(field) && ifRange == responseHeaders[field];
+}
+
+bool isConditionalGet(const HttpRequest& request)
+{
+	return (request.method == HTTP_GET || request.method == HTTP_HEAD) &&
+		   (request.headers.contains(HTTP_HEADER_IF_NONE_MATCH) ||
+			request.headers.contains(HTTP_HEADER_IF_MODIFIED_SINCE));
+}
+
+time_t getLastModified(const HttpHeaders& headers)
+{
+	if(!headers.contains(HTTP_HEADER_LAST_MODIFIED)) {
+		return 0;
+	}
+	DateTime dt = headers.getLastModifiedDate();
+	return dt.isNull() ? 0 : time_t(dt);
+}
+
+} // namespace
+
 int HttpServerConnection::onMessageBegin(http_parser* parser)
 {
 	// Reset Response ...
@@ -49,7 +85,7 @@ int HttpServerConnection::onPath(const Url& uri)
 
 	request.setURL(uri);
 
-	resource = resourceTree->find(request.uri.Path);
+	resource = resourceTree->match(request.uri.Path, request.pathParams);
 	if(resource == nullptr) {
 		resource = resourceTree->getDefault();
 	}
@@ -71,7 +107,15 @@ int HttpServerConnection::onMessageComplete(http_parser*)
 	}
 
 	if(resource != nullptr) {
-		hasError = resource->handleRequest(*this, request, response);
+		if(resource->useEtagCache && respondFromEtagCache()) {
+			hasError = resource->handleNotModified(*this, request, response);
+		} else {
+			hasError = resource->handleRequest(*this, request, response);
+		}
+		if(resource->cacheControl && !response.headers.contains(HTTP_HEADER_CACHE_CONTROL) &&
+		   (response.code == HTTP_STATUS_OK || response.code == HTTP_STATUS_NOT_MODIFIED)) {
+			response.headers[HTTP_HEADER_CACHE_CONTROL] = resource->cacheControl;
+		}
 	}
 
 	if(request.responseStream != nullptr) {
@@ -104,6 +148,9 @@ int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 	 */
 	int error = 0;
 	request.setHeaders(headers);
+	if(request.headers.contains(HTTP_HEADER_ACCEPT_ENCODING)) {
+		response.acceptEncoding.parse(request.headers[HTTP_HEADER_ACCEPT_ENCODING]);
+	}
 
 	if(resource != nullptr) {
 		error = resource->handleHeaders(*this, request, response);
@@ -228,8 +275,7 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 			break;
 		}
 
-		delete stream;
-		stream = nullptr;
+		freeStreams();
 		state = eHCS_Sent;
 		[[fallthrough]];
 	}
@@ -254,6 +300,36 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 	TcpClient::onReadyToSendData(sourceEvent);
 }
 
+bool HttpServerConnection::respondFromEtagCache()
+{
+	if(etagCache == nullptr || response.code != HTTP_STATUS_OK || !isConditionalGet(request)) {
+		return false;
+	}
+
+	// Cached validators don't show the resource still exists, so `If-None-Match: *` is left to the handler
+	auto entry = etagCache->find(request.uri.getPathWithQuery(), request.headers[HTTP_HEADER_ACCEPT_ENCODING]);
+	if(entry == nullptr || !HttpEtagCache::isNotModified(request.headers, entry->etag, entry->lastModified, false)) {
+		return false;
+	}
+
+	debug_d("[HTTP] '%s' not modified (cached)", entry->path.c_str());
+	response.code = HTTP_STATUS_NOT_MODIFIED;
+	response.headers[HTTP_HEADER_ETAG] = entry->etag;
+	if(entry->lastModified != 0) {
+		response.headers[HTTP_HEADER_LAST_MODIFIED] = DateTime(entry->lastModified).toHTTPDate();
+	}
+	return true;
+}
+
+bool HttpServerConnection::isEtagCacheable(const HttpResponse& response)
+{
+	// Only Accept-Encoding is recorded with cached validators
+	if(!response.headers.contains(HTTP_HEADER_VARY)) {
+		return true;
+	}
+	return response.headers[HTTP_HEADER_VARY].equalsIgnoreCase(response.headers.toString(HTTP_HEADER_ACCEPT_ENCODING));
+}
+
 void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 {
 #ifndef DISABLE_HTTPSRV_ETAG
@@ -267,28 +343,37 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 			response->headers[HTTP_HEADER_ETAG] = s;
 		}
 	}
+#endif /* DISABLE_HTTPSRV_ETAG */
+
+	if(response->code == HTTP_STATUS_OK) {
+		String etag = response->headers.contains(HTTP_HEADER_ETAG) ? response->headers[HTTP_HEADER_ETAG] : nullptr;
+		time_t lastModified = getLastModified(response->headers);
 
-	if(request.headers.contains(HTTP_HEADER_IF_MATCH) && response->headers.contains(HTTP_HEADER_ETAG) &&
-	   request.headers[HTTP_HEADER_IF_MATCH] == response->headers[HTTP_HEADER_ETAG]) {
-		if(request.method == HTTP_GET || request.method == HTTP_HEAD) {
+		// Remember validators for plain files so the next conditional request needn't open them
+		if(etagCache != nullptr && resource != nullptr && resource->useEtagCache && etag &&
+		   response->stream != nullptr && response->stream->getStreamType() == eSST_File && isEtagCacheable(*response)) {
+			etagCache->update(request.uri.getPathWithQuery(), etag, lastModified,
+							  request.headers[HTTP_HEADER_ACCEPT_ENCODING]);
+		}
+
+		if(isConditionalGet(request) && HttpEtagCache::isNotModified(request.headers, etag, lastModified)) {
 			response->code = HTTP_STATUS_NOT_MODIFIED;
-			response->headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
+			response->headers.remove(HTTP_HEADER_CONTENT_LENGTH);
 			delete response->stream;
 			response->stream = nullptr;
 		}
 	}
-#endif /* DISABLE_HTTPSRV_ETAG */
 
-	String statusLine = F("HTTP/1.1 ");
-	statusLine += unsigned(response->code);
-	statusLine += ' ';
-	statusLine += toString(response->code);
-	statusLine += "\r\n";
-	sendString(statusLine);
+#if HTTP_SERVER_MAX_RANGES > 0
+	applyRange(response);
+#endif
+
 	if(response->stream != nullptr && response->stream->available() >= 0) {
 		response->headers[HTTP_HEADER_CONTENT_LENGTH] = String(response->stream->available());
 	}
-	if(!response->headers.contains(HTTP_HEADER_CONTENT_LENGTH) && response->stream == nullptr) {
+	// A 304 response carries no content, and a Content-Length would describe the cached representation
+	if(!response->headers.contains(HTTP_HEADER_CONTENT_LENGTH) && response->stream == nullptr &&
+	   response->code != HTTP_STATUS_NOT_MODIFIED) {
 		response->headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
 	}
 
@@ -315,12 +400,120 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 		response->headers[HTTP_HEADER_DATE] = DateTime(SystemClock.now(eTZ_UTC)).toHTTPDate();
 	}
 
-	for(auto hdr : response->headers) {
-		sendString(hdr);
+	// Serialize status line and headers into a single buffer
+	char code[8];
+	ultoa(unsigned(response->code), code, 10);
+	auto codeLength = strlen(code);
+	auto reason = toString(response->code);
+	const char version[]{"HTTP/1.1 "};
+	size_t statusLength = sizeof(version) - 1 + codeLength + 1 + reason.length() + 2;
+	size_t headerLength = response->headers.serialize(nullptr);
+	String buffer;
+	if(!buffer.setLength(statusLength + headerLength + 2)) {
+		debug_e("[HTTP] Unable to allocate %u bytes for response header", statusLength + headerLength + 2);
+		return;
 	}
-	sendString("\r\n");
+
+	auto p = buffer.begin();
+	auto append = [&p](const char* str, size_t length) {
+		memcpy(p, str, length);
+		p += length;
+	};
+	append(version, sizeof(version) - 1);
+	append(code, codeLength);
+	append(" ", 1);
+	append(reason.c_str(), reason.length());
+	append("\r\n", 2);
+	p += response->headers.serialize(p);
+	append("\r\n", 2);
+
+	// Buffer is sent in one piece without further copying
+	send(new MemoryDataStream(std::move(buffer)));
 }
 
+#if HTTP_SERVER_MAX_RANGES > 0
+void HttpServerConnection::applyRange(HttpResponse* response)
+{
+	auto source = response->stream;
+	if(response->code != HTTP_STATUS_OK || source == nullptr ||
+	   response->headers.contains(HTTP_HEADER_TRANSFER_ENCODING)) {
+		return;
+	}
+	if(request.method != HTTP_GET && request.method != HTTP_HEAD) {
+		return;
+	}
+
+	if(!request.headers.contains(HTTP_HEADER_RANGE)) {
+		return;
+	}
+
+	// Ranges require content of known length which supports random access.
+	// The handler may have positioned the stream, so content starts at the current position.
+	int contentLength = source->available();
+	if(contentLength < 0) {
+		return;
+	}
+	int base = source->seekFrom(0, SeekOrigin::Current);
+	if(base < 0 || source->seekFrom(base, SeekOrigin::Start) != base) {
+		return;
+	}
+
+	response->headers[HTTP_HEADER_ACCEPT_RANGES] = F("bytes");
+
+	if(request.headers.contains(HTTP_HEADER_IF_RANGE) &&
+	   !ifRangeMatches(request.headers[HTTP_HEADER_IF_RANGE], response->headers)) {
+		return;
+	}
+
+	HttpRangeList ranges;
+	switch(ranges.parse(request.headers[HTTP_HEADER_RANGE].c_str(), contentLength)) {
+	case HttpRangeList::Result::ignore:
+		return;
+
+	case HttpRangeList::Result::unsatisfiable:
+		debug_d("[HTTP] Range '%s' not satisfiable", request.headers[HTTP_HEADER_RANGE].c_str());
+		response->code = HTTP_STATUS_RANGE_NOT_SATISFIABLE;
+		response->headers[HTTP_HEADER_CONTENT_RANGE] = HttpRangeList::contentRange(contentLength);
+		response->headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
+		delete response->stream;
+		response->stream = nullptr;
+		return;
+
+	case HttpRangeList::Result::satisfiable:
+		break;
+	}
+
+	// Make sure every range can actually be reached, finishing at the first one
+	bool canSeek{true};
+	for(unsigned i = 0; canSeek && i <= ranges.count(); ++i) {
+		int offset = base + ranges[i % ranges.count()].first;
+		canSeek = (source->seekFrom(offset, SeekOrigin::Start) == offset);
+	}
+	if(!canSeek) {
+		debug_w("[HTTP] Source cannot seek, ignoring Range");
+		// Send the whole content instead, provided the source can be rewound
+		if(source->seekFrom(base, SeekOrigin::Start) != base) {
+			response->code = HTTP_STATUS_INTERNAL_SERVER_ERROR;
+			response->headers.remove(HTTP_HEADER_ACCEPT_RANGES);
+			response->headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
+			delete response->stream;
+			response->stream = nullptr;
+		}
+		return;
+	}
+
+	auto rangeStream =
+		new ByteRangeStream(source, ranges, contentLength, response->headers[HTTP_HEADER_CONTENT_TYPE], base);
+	response->stream = rangeStream;
+	response->code = HTTP_STATUS_PARTIAL_CONTENT;
+	if(rangeStream->isMultipart()) {
+		response->headers[HTTP_HEADER_CONTENT_TYPE] = rangeStream->getContentType();
+	} else {
+		response->headers[HTTP_HEADER_CONTENT_RANGE] = HttpRangeList::contentRange(ranges[0], contentLength);
+	}
+}
+#endif
+
 bool HttpServerConnection::sendResponseBody(HttpResponse* response)
 {
 	if(state == eHCS_StartBody) {
@@ -337,7 +530,7 @@ bool HttpServerConnection::sendResponseBody(HttpResponse* response)
 			return true;
 		}
 
-		delete stream;
+		freeStreams();
 		if(response->headers[HTTP_HEADER_TRANSFER_ENCODING] == F("chunked")) {
 			stream = new ChunkedStream(response->stream);
 		} else {
@@ -15,6 +15,8 @@
 #include "HttpConnection.h"
 #include "HttpResource.h"
 #include "HttpBodyParser.h"
+#include "HttpRange.h"
+#include "HttpEtagCache.h"
 
 #include <functional>
 
@@ -58,6 +60,15 @@ public:
 		this->bodyParsers = bodyParsers;
 	}
 
+	/**
+	 * @brief Set cache used to answer conditional requests without invoking the resource
+	 * @param etagCache Owned by the server, may be null
+	 */
+	void setEtagCache(HttpEtagCache* etagCache)
+	{
+		this->etagCache = etagCache;
+	}
+
 	void send()
 	{
 		if(state == eHCS_Ready) {
@@ -115,7 +126,12 @@ protected:
 	virtual void sendError(const String& message = nullptr, HttpStatus code = HTTP_STATUS_BAD_REQUEST);
 
 private:
+	bool respondFromEtagCache();
+	static bool isEtagCacheable(const HttpResponse& response);
 	void sendResponseHeaders(HttpResponse* response);
+#if HTTP_SERVER_MAX_RANGES > 0
+	void applyRange(HttpResponse* response);
+#endif
 	bool sendResponseBody(HttpResponse* response);
 
 public:
@@ -124,6 +140,7 @@ public:
 private:
 	HttpResourceTree* resourceTree = nullptr; ///< A reference to the current resource tree - we don't own it
 	HttpResource* resource = nullptr;		  ///< Resource for currently executing path
+	HttpEtagCache* etagCache = nullptr;		  ///< Validators of recently sent files - we don't own it
 
 	HttpRequest request;
 
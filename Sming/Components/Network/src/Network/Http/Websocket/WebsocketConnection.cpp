@@ -20,6 +20,8 @@ DEFINE_FSTR(WSSTR_WEBSOCKET, "websocket")
 DEFINE_FSTR(WSSTR_SECRET, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11")
 
 WebsocketList WebsocketConnection::websocketList;
+size_t WebsocketConnection::broadcastBacklogLimit{WEBSOCKET_BROADCAST_BACKLOG};
+uint32_t WebsocketConnection::skippedBroadcasts;
 
 /** @brief ws_parser function table
  * 	@note stored in flash memory; as it is word-aligned it can be accessed directly
@@ -215,16 +217,33 @@ bool WebsocketConnection::send(const char* message, size_t length, ws_frame_type
 	return send(stream, type, isClientConnection);
 }
 
-bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type, bool useMask, bool isFin)
+size_t WebsocketConnection::encodeHeader(uint8_t* packet, size_t length, ws_frame_type_t type, bool useMask,
+										 bool isFin)
 {
-	// Ensure source gets destroyed if we return prematurely
-	std::unique_ptr<IDataSourceStream> sourceRef(source);
-
-	if(source == nullptr) {
-		debug_w("WS: No source");
-		return false;
+	unsigned len = 0;
+	packet[len++] = (isFin ? _BV(7) : 0) | type; // Fin, opcode
+	uint8_t maskFlag = useMask ? _BV(7) : 0;
+	// length
+	if(length <= 125) {
+		packet[len++] = maskFlag | length;
+	} else if(length <= 0xffff) {
+		packet[len++] = maskFlag | 126;
+		packet[len++] = length >> 8;
+		packet[len++] = length;
+	} else {
+		packet[len++] = maskFlag | 127;
+		memset(&packet[len], 0, 4);
+		len += 4;
+		packet[len++] = length >> 24;
+		packet[len++] = length >> 16;
+		packet[len++] = length >> 8;
+		packet[len++] = length;
 	}
+	return len;
+}
 
+bool WebsocketConnection::canSend() const
+{
 	if(connection == nullptr) {
 		debug_w("WS: No connection");
 		return false;
@@ -235,6 +254,23 @@ bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type,
 		return false;
 	}
 
+	return true;
+}
+
+bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type, bool useMask, bool isFin)
+{
+	// Ensure source gets destroyed if we return prematurely
+	std::unique_ptr<IDataSourceStream> sourceRef(source);
+
+	if(source == nullptr) {
+		debug_w("WS: No source");
+		return false;
+	}
+
+	if(!canSend()) {
+		return false;
+	}
+
 	int available = source->available();
 	if(available < 0) {
 		debug_e("WS: Unknown stream size");
@@ -244,30 +280,8 @@ bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type,
 	debug_d("WS: Sending %d bytes, type %d", available, type);
 
 	// Construct packet
-	uint8_t packet[16]{};
-	unsigned len = 0;
-	if(isFin) {
-		packet[len] |= _BV(7); // set Fin
-	}
-	packet[len++] |= type; // set opcode
-	if(useMask) {
-		packet[len] |= _BV(7); // set mask
-	}
-	// length
-	if(available <= 125) {
-		packet[len++] |= available;
-	} else if(available <= 0xffff) {
-		packet[len++] |= 126;
-		packet[len++] = available >> 8;
-		packet[len++] = available;
-	} else {
-		packet[len++] |= 127;
-		len += 4; // All 0
-		packet[len++] = available >> 24;
-		packet[len++] = available >> 16;
-		packet[len++] = available >> 8;
-		packet[len++] = available;
-	}
+	uint8_t packet[maxHeaderLength + 4];
+	unsigned len = encodeHeader(packet, available, type, useMask, isFin);
 	if(useMask) {
 		uint8_t maskKey[4];
 		os_get_random(maskKey, sizeof(maskKey));
@@ -295,18 +309,54 @@ bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type,
 	return true;
 }
 
-void WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
+unsigned WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
 {
-	std::shared_ptr<char[]> data(new char[length]);
-	if(!data) {
-		return;
+	// Encode frame once: header and payload are shared by all server connections
+	uint8_t header[maxHeaderLength];
+	auto headerLength = encodeHeader(header, length, type, false, true);
+	size_t frameLength = headerLength + length;
+	std::shared_ptr<const char[]> frame;
+	{
+		auto buffer = new char[frameLength];
+		if(buffer == nullptr) {
+			return 0;
+		}
+		memcpy(buffer, header, headerLength);
+		memcpy(buffer + headerLength, message, length);
+		frame.reset(buffer);
 	}
-	memcpy(data.get(), message, length);
 
+	unsigned count = 0;
 	for(auto skt : websocketList) {
-		auto stream = new SharedMemoryStream<const char[]>(data, length);
-		skt->send(stream, type);
+		if(!skt->canSend()) {
+			continue;
+		}
+
+		if(broadcastBacklogLimit != 0 && skt->connection->getPendingBytes() > broadcastBacklogLimit) {
+			debug_d("WS: Skipping broadcast to %p, %u bytes pending", skt, skt->connection->getPendingBytes());
+			++skippedBroadcasts;
+			continue;
+		}
+
+		if(skt->isClientConnection) {
+			// Client frames must be individually masked
+			if(skt->send(message, length, type)) {
+				++count;
+			}
+			continue;
+		}
+
+		auto stream = new SharedMemoryStream<const char[]>(frame, frameLength);
+		if(stream == nullptr) {
+			break;
+		}
+		if(skt->connection->send(stream)) {
+			skt->connection->commit();
+			++count;
+		}
 	}
+
+	return count;
 }
 
 void WebsocketConnection::close()
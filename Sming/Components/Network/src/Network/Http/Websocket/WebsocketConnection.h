@@ -25,6 +25,13 @@ extern "C" {
 
 #define WEBSOCKET_VERSION 13 // 1.3
 
+/**
+ * @brief Default value for WebsocketConnection::setBroadcastBacklogLimit()
+ */
+#ifndef WEBSOCKET_BROADCAST_BACKLOG
+#define WEBSOCKET_BROADCAST_BACKLOG 0
+#endif
+
 DECLARE_FSTR(WSSTR_UPGRADE)
 DECLARE_FSTR(WSSTR_WEBSOCKET)
 DECLARE_FSTR(WSSTR_SECRET)
@@ -110,17 +117,40 @@ public:
 	 * @param message
 	 * @param length
 	 * @param type
+	 * @retval unsigned Number of connections the message was queued for
+	 * @note The frame is encoded once into a single buffer which is shared by all server connections.
+	 * Connections with more than the backlog limit of data waiting to be sent are skipped.
 	 */
-	static void broadcast(const char* message, size_t length, ws_frame_type_t type = WS_FRAME_TEXT);
+	static unsigned broadcast(const char* message, size_t length, ws_frame_type_t type = WS_FRAME_TEXT);
 
 	/**
 	 * @brief Broadcasts a message to all active websocket connections
 	 * @param message
 	 * @param type
+	 * @retval unsigned Number of connections the message was queued for
+	 */
+	static unsigned broadcast(const String& message, ws_frame_type_t type = WS_FRAME_TEXT)
+	{
+		return broadcast(message.c_str(), message.length(), type);
+	}
+
+	/**
+	 * @brief Set limit for data pending on a connection, above which broadcasts are not sent to it
+	 * @param bytes 0 to always send
+	 * @note Use this to prevent slow clients from consuming excessive memory.
+	 * Such clients miss messages but are otherwise unaffected.
+	 */
+	static void setBroadcastBacklogLimit(size_t bytes)
+	{
+		broadcastBacklogLimit = bytes;
+	}
+
+	/**
+	 * @brief Get number of times a broadcast was not sent to a connection because of the backlog limit
 	 */
-	static void broadcast(const String& message, ws_frame_type_t type = WS_FRAME_TEXT)
+	static uint32_t getSkippedBroadcastCount()
 	{
-		broadcast(message.c_str(), message.length(), type);
+		return skippedBroadcasts;
 	}
 
 	/**
@@ -285,6 +315,16 @@ protected:
 	 */
 	bool processFrame(TcpClient& client, char* at, int size);
 
+private:
+	static constexpr size_t maxHeaderLength{10}; ///< Excluding mask key
+
+	/** @brief Encode frame header, excluding any mask key
+	 *  @retval size_t Number of bytes written to packet
+	 */
+	static size_t encodeHeader(uint8_t* packet, size_t length, ws_frame_type_t type, bool useMask, bool isFin);
+
+	bool canSend() const;
+
 protected:
 	WebsocketDelegate wsConnect;
 	WebsocketMessageDelegate wsMessage;
@@ -304,6 +344,8 @@ private:
 	static const ws_parser_callbacks_t parserSettings;
 
 	static WebsocketList websocketList;
+	static size_t broadcastBacklogLimit;
+	static uint32_t skippedBroadcasts;
 
 	HttpConnection* connection = nullptr;
 	bool isClientConnection;
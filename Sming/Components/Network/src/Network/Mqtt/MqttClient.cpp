@@ -10,6 +10,9 @@
 
 #include "MqttClient.h"
 #include <Data/Stream/DataSourceStream.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <Data/Stream/SharedMemoryStream.h>
+#include <MallocTag.h>
 
 const mqtt_parser_callbacks_t MqttClient::callbacks PROGMEM = {
 	.on_message_begin = staticOnMessageBegin,
@@ -26,6 +29,64 @@ constexpr unsigned MQTT_PUBLISH_STREAM{0};
 
 constexpr uint8_t MQTT_CONNECT_PROTOCOL{4}; // version 3.1.1
 
+// Larger payloads are passed to the TCP client as a stream, avoiding a copy
+constexpr size_t MQTT_PUBLISH_COPY_MAX{256};
+
+// Maximum value for the 'remaining length' field of the fixed header
+constexpr size_t MQTT_MAX_REMAINING_LENGTH{268435455};
+
+/*
+ * PUBLISH message which owns its topic and content.
+ * The message topic buffer is left empty to identify it.
+ */
+struct PublishRequest {
+	PublishRequest(uint8_t flags)
+	{
+		mqtt_message_init(&message);
+		message.common.type = MQTT_TYPE_PUBLISH;
+		message.common.retain = static_cast<mqtt_retain_t>((flags >> 0) & 0x01);
+		message.common.qos = static_cast<mqtt_qos_t>((flags >> 1) & 0x03);
+		message.common.dup = static_cast<mqtt_dup_t>((flags >> 3) & 0x01);
+	}
+
+	mqtt_message_t message; ///< Must be first
+	String topic;
+	const FlashString* flashTopic{nullptr}; ///< Used instead of topic if set
+	String content;
+};
+
+PublishRequest& getPublishRequest(mqtt_message_t& message)
+{
+	return *reinterpret_cast<PublishRequest*>(&message);
+}
+
+bool isPublishRequest(const mqtt_message_t* message)
+{
+	return message != nullptr && message->common.type == MQTT_TYPE_PUBLISH &&
+		   message->publish.topic_name.data == nullptr;
+}
+
+/*
+ * Check serialised size of a PUBLISH request is within protocol limits
+ */
+bool checkPublishSize(mqtt_message_t& message)
+{
+	auto& request = getPublishRequest(message);
+	size_t topicLength = request.flashTopic ? request.flashTopic->length() : request.topic.length();
+	bool hasMessageId = (message.common.qos != MQTT_QOS_AT_MOST_ONCE);
+	size_t remainingLength = 2 + topicLength + (hasMessageId ? 2 : 0) + request.content.length();
+	if(topicLength > 0xffff || remainingLength > MQTT_MAX_REMAINING_LENGTH) {
+		debug_e("[MQTT] Publish message too large");
+		return false;
+	}
+	return true;
+}
+
+uint8_t getPublishFlags(const mqtt_message_t& message)
+{
+	return MqttClient::getFlags(message.common.qos, message.common.retain, message.common.dup);
+}
+
 #define GET_CLIENT()                                                                                                   \
 	auto client = static_cast<MqttClient*>(userData);                                                                  \
 	if(client == nullptr) {                                                                                            \
@@ -44,6 +105,10 @@ mqtt_message_t* createMessage(mqtt_type_t messageType)
 
 void deleteMessage(mqtt_message_t* message)
 {
+	if(isPublishRequest(message)) {
+		delete &getPublishRequest(*message);
+		return;
+	}
 	mqtt_message_clear(message, 0);
 	delete message;
 }
@@ -68,6 +133,18 @@ bool copyString(mqtt_buffer_t& destBuffer, const String& sourceString)
 
 } // namespace
 
+/*
+ * QoS 1/2 message awaiting acknowledgement.
+ * Content is shared with any stream still being sent so the entry may be removed at any time.
+ */
+struct MqttClient::InflightMessage {
+	std::shared_ptr<PublishRequest> request; ///< Content for re-sending, dropped on PUBREC
+	OneShotElapseTimer<NanoTime::Seconds> retryTimer;
+	bool pending{true};	  ///< Needs (re)sending
+	bool released{false}; ///< PUBREC received, so PUBREL is sent instead
+	bool streamed{false}; ///< Content was sent from a stream so isn't retained or spooled
+};
+
 MqttClient::MqttClient(bool withDefaultPayloadParser, bool autoDestruct)
 	: TcpClient(autoDestruct), pingTimer(pingRepeatTime)
 {
@@ -103,6 +180,7 @@ MqttClient::~MqttClient()
 
 bool MqttClient::onTcpReceive(TcpClient&, char* data, int size)
 {
+	MALLOC_TAG_SCOPE(mqtt);
 	pingTimer.start();
 	int rc = mqtt_parser_execute(&parser, &incomingMessage, (uint8_t*)data, (size_t)size);
 	if(rc == MQTT_PARSER_RC_ERROR) {
@@ -123,34 +201,77 @@ int MqttClient::staticOnDataBegin(void* userData, mqtt_message_t* message)
 {
 	GET_CLIENT();
 
-	if(client->payloadParser) {
-		client->payloadState.offset = 0;
-		return client->payloadParser(client->payloadState, message, nullptr, MQTT_PAYLOAD_PARSER_START);
-	}
-
-	return 0;
+	client->matchSubscriptions(*message);
+	return client->parsePayload(message, nullptr, MQTT_PAYLOAD_PARSER_START);
 }
 
 int MqttClient::staticOnDataPayload(void* userData, mqtt_message_t* message, const char* data, size_t length)
 {
 	GET_CLIENT();
 
-	if(client->payloadParser) {
-		return client->payloadParser(client->payloadState, message, data, length);
-	}
-
-	return 0;
+	return client->parsePayload(message, data, length);
 }
 
 int MqttClient::staticOnDataEnd(void* userData, mqtt_message_t* message)
 {
 	GET_CLIENT();
 
-	if(client->payloadParser) {
-		return client->payloadParser(client->payloadState, message, nullptr, MQTT_PAYLOAD_PARSER_END);
+	return client->parsePayload(message, nullptr, MQTT_PAYLOAD_PARSER_END);
+}
+
+/*
+ * Content goes to the parsers of matching subscriptions, if they have one.
+ * Otherwise the default parser is used.
+ */
+int MqttClient::parsePayload(mqtt_message_t* message, const char* data, int length)
+{
+	bool handled{false};
+	for(auto sub : matches) {
+		if(sub->removed || !sub->payloadParser) {
+			continue;
+		}
+		handled = true;
+		if(length == MQTT_PAYLOAD_PARSER_START) {
+			sub->payloadState.offset = 0;
+		}
+		int rc = sub->payloadParser(sub->payloadState, message, data, length);
+		if(rc != 0) {
+			return rc;
+		}
+	}
+
+	if(handled || !payloadParser) {
+		return 0;
 	}
 
-	return 0;
+	if(length == MQTT_PAYLOAD_PARSER_START) {
+		payloadState.offset = 0;
+	}
+	return payloadParser(payloadState, message, data, length);
+}
+
+void MqttClient::matchSubscriptions(const mqtt_message_t& message)
+{
+	if(matchesValid || message.common.type != MQTT_TYPE_PUBLISH) {
+		return;
+	}
+
+	// Handlers may unsubscribe, so keep matched entries valid until dispatch has completed
+	subscriptions.lock();
+	matchesValid = true;
+	auto& topic = message.publish.topic_name;
+	subscriptions.match(reinterpret_cast<const char*>(topic.data), topic.length, matches);
+}
+
+void MqttClient::clearMatches()
+{
+	if(!matchesValid) {
+		return;
+	}
+
+	matches.setSize(0);
+	matchesValid = false;
+	subscriptions.unlock();
 }
 
 int MqttClient::staticOnMessageEnd(void* userData, mqtt_message_t* message)
@@ -171,6 +292,25 @@ int MqttClient::onMessageEnd(mqtt_message_t* message)
 			setTimeOut(USHRT_MAX);
 			setBits(flags, MQTT_CLIENT_CONNECTED);
 		}
+	} else if(message->common.type == MQTT_TYPE_PUBLISH) {
+		// Messages without content may not have been matched yet
+		matchSubscriptions(*message);
+		bool matched = (matches.count() != 0);
+		int rc{0};
+		for(auto sub : matches) {
+			if(!sub->removed) {
+				rc = sub->handler(*this, message);
+				if(rc != 0) {
+					break;
+				}
+			}
+		}
+		clearMatches();
+		if(matched) {
+			return rc;
+		}
+	} else {
+		acknowledge(*message);
 	}
 
 	auto& handler = static_cast<const HandlerMap&>(eventHandlers)[message->common.type];
@@ -198,6 +338,7 @@ bool MqttClient::setWill(const String& topic, const String& message, uint8_t fla
 
 bool MqttClient::connect(const Url& url, const String& clientName)
 {
+	MALLOC_TAG_SCOPE(mqtt);
 	this->url = url;
 
 	bool useSsl{url.Scheme == URI_SCHEME_MQTT_SECURE};
@@ -246,35 +387,327 @@ bool MqttClient::connect(const Url& url, const String& clientName)
 	return TcpClient::connect(url.Host, url.getPort(), useSsl);
 }
 
-bool MqttClient::publish(const String& topic, const String& content, uint8_t flags)
+bool MqttClient::publish(String&& topic, String&& content, uint8_t flags)
+{
+	PublishRequest request(flags);
+	request.topic = std::move(topic);
+	request.content = std::move(content);
+	return submitPublish(request.message);
+}
+
+bool MqttClient::publish(const FlashString& topic, String&& content, uint8_t flags)
 {
+	PublishRequest request(flags);
+	request.flashTopic = &topic;
+	request.content = std::move(content);
+	return submitPublish(request.message);
+}
+
+bool MqttClient::submitPublish(mqtt_message_t& message)
+{
+	MALLOC_TAG_SCOPE(mqtt);
+	auto& request = getPublishRequest(message);
+
+	// Nothing must be sent before CONNECT, or ahead of queued messages
+	if(!connectQueued && requestQueue.count() == 0 && getConnectionState() == eTCS_Connected &&
+	   isWindowOpen(&message)) {
+		if(!startPublish(message)) {
+			return false;
+		}
+		commit();
+		return true;
+	}
+
 	if(requestQueue.full()) {
 		return false;
 	}
 
-	auto message = createMessage(MQTT_TYPE_PUBLISH);
-
-	message->common.retain = static_cast<mqtt_retain_t>((flags >> 0) & 0x01);
-	message->common.qos = static_cast<mqtt_qos_t>((flags >> 1) & 0x03);
-	message->common.dup = static_cast<mqtt_dup_t>((flags >> 3) & 0x01);
-
-	if(!copyString(message->publish.topic_name, topic) || !copyString(message->publish.content, content)) {
-		delete message;
+	auto queued = new PublishRequest(std::move(request));
+	if(queued == nullptr) {
 		return false;
 	}
 
-	bool success = requestQueue.enqueue(message);
+	bool success = requestQueue.enqueue(&queued->message);
 	if(success) {
 		// Try to force-send message to decrease latency.
 		// Should work for small size messages but there is no guarantee.
 		commit();
+	} else {
+		delete queued;
 	}
 
 	return success;
 }
 
+/*
+ * Send a PUBLISH request, entering it into the in-flight window if acknowledgement is required
+ */
+bool MqttClient::startPublish(mqtt_message_t& message)
+{
+	// Oversized messages must not take a slot in the window
+	if(!checkPublishSize(message)) {
+		return false;
+	}
+
+	if(message.common.qos == MQTT_QOS_AT_MOST_ONCE) {
+		return sendPublish(message);
+	}
+
+	auto msg = new InflightMessage;
+	if(msg == nullptr) {
+		return false;
+	}
+	msg->request = std::make_shared<PublishRequest>(std::move(getPublishRequest(message)));
+	if(!msg->request) {
+		delete msg;
+		return false;
+	}
+
+	auto& request = *msg->request;
+	auto id = getNextMessageId();
+	request.message.publish.message_id = id;
+	if(spool != nullptr) {
+		auto flags = getPublishFlags(request.message);
+		if(request.flashTopic) {
+			spool->store(id, flags, String(*request.flashTopic), request.content);
+		} else {
+			spool->store(id, flags, request.topic, request.content);
+		}
+	}
+	inflight.set(id, msg);
+
+	return transmit(id, *msg);
+}
+
+/*
+ * Serialise PUBLISH header, topic and small payloads into the TCP send buffer.
+ * Larger payloads are moved into a stream.
+ * If the request has an owner then content is shared with the stream instead.
+ */
+bool MqttClient::sendPublish(mqtt_message_t& message, const std::shared_ptr<void>& owner)
+{
+	if(!checkPublishSize(message)) {
+		return false;
+	}
+
+	auto& request = getPublishRequest(message);
+	size_t topicLength = request.flashTopic ? request.flashTopic->length() : request.topic.length();
+	size_t contentLength = request.content.length();
+	bool hasMessageId = (message.common.qos != MQTT_QOS_AT_MOST_ONCE);
+	size_t remainingLength = 2 + topicLength + (hasMessageId ? 2 : 0) + contentLength;
+
+	// Packet type and flags, up to 4 bytes of remaining length, topic length
+	uint8_t header[7];
+	unsigned pos{0};
+	header[pos++] = (MQTT_TYPE_PUBLISH << 4) | (message.common.dup << 3) | (message.common.qos << 1) |
+					message.common.retain;
+	size_t len = remainingLength;
+	do {
+		uint8_t c = len & 0x7f;
+		len >>= 7;
+		header[pos++] = (len == 0) ? c : (c | 0x80);
+	} while(len != 0);
+	header[pos++] = topicLength >> 8;
+	header[pos++] = topicLength;
+
+	debug_d("[MQTT] Sending message type %u", MQTT_TYPE_PUBLISH);
+
+	if(!send(reinterpret_cast<const char*>(header), pos)) {
+		return false;
+	}
+
+	// Subsequent writes are appended to the same send buffer
+	bool ok{true};
+	if(request.flashTopic) {
+		char buf[64];
+		for(size_t offset = 0; ok && offset < topicLength; offset += sizeof(buf)) {
+			auto count = request.flashTopic->read(offset, buf, sizeof(buf));
+			ok = send(buf, count);
+		}
+	} else if(topicLength != 0) {
+		ok = send(request.topic.c_str(), topicLength);
+	}
+	if(ok && hasMessageId) {
+		char id[]{char(message.publish.message_id >> 8), char(message.publish.message_id)};
+		ok = send(id, sizeof(id));
+	}
+	bool copyContent = (contentLength <= MQTT_PUBLISH_COPY_MAX);
+	if(ok && copyContent && contentLength != 0) {
+		ok = send(request.content.c_str(), contentLength);
+	}
+	if(!ok) {
+		// Header has already gone so the stream is now invalid
+		debug_e("[MQTT] Unable to send message");
+		close();
+		return false;
+	}
+
+	if(copyContent) {
+		// Nothing more to send
+	} else if(owner) {
+		std::shared_ptr<const char[]> content(owner, request.content.c_str());
+		if(!send(new SharedMemoryStream<const char[]>(content, contentLength))) {
+			debug_e("[MQTT] Unable to send content");
+			close();
+			return false;
+		}
+	} else if(!send(new MemoryDataStream(std::move(request.content)))) {
+		// Header has already gone so the stream is now invalid
+		debug_e("[MQTT] Unable to send content");
+		close();
+		return false;
+	}
+
+	pingTimer.start();
+	return true;
+}
+
+unsigned MqttClient::setSpool(MqttSpool* spool)
+{
+	this->spool = spool;
+	if(spool == nullptr) {
+		return 0;
+	}
+
+	return spool->load([this](uint16_t id, uint8_t flags, String& topic, String& content, bool released) {
+		auto msg = new InflightMessage;
+		if(msg == nullptr) {
+			return;
+		}
+		msg->released = released;
+		if(!released) {
+			msg->request = std::make_shared<PublishRequest>(flags);
+			auto& request = *msg->request;
+			request.message.common.dup = MQTT_DUP_TRUE;
+			request.message.publish.message_id = id;
+			request.topic = std::move(topic);
+			request.content = std::move(content);
+		}
+		inflight.set(id, msg);
+	});
+}
+
+uint16_t MqttClient::getNextMessageId()
+{
+	// Zero is not a valid packet identifier
+	do {
+		++messageId;
+	} while(messageId == 0 || inflight.contains(messageId));
+
+	return messageId;
+}
+
+/*
+ * QoS 1/2 messages must wait for a free slot in the in-flight window.
+ * This includes stream content which, although it cannot be re-sent, is tracked until acknowledged.
+ */
+bool MqttClient::isWindowOpen(const mqtt_message_t* message) const
+{
+	if(message == nullptr || message->common.type != MQTT_TYPE_PUBLISH ||
+	   message->common.qos == MQTT_QOS_AT_MOST_ONCE) {
+		return true;
+	}
+
+	return inflight.count() < maxInflight;
+}
+
+/*
+ * Send PUBLISH, or PUBREL if the message has been released, and restart the retry timer
+ */
+bool MqttClient::transmit(uint16_t id, InflightMessage& msg)
+{
+	msg.pending = false;
+	msg.retryTimer.reset(retryInterval);
+
+	if(msg.released) {
+		debug_d("[MQTT] Sending PUBREL #%u", id);
+		const uint8_t packet[]{(MQTT_TYPE_PUBREL << 4) | 0x02, 2, uint8_t(id >> 8), uint8_t(id)};
+		return send(reinterpret_cast<const char*>(packet), sizeof(packet));
+	}
+
+	auto& request = *msg.request;
+	if(!sendPublish(request.message, msg.request)) {
+		return false;
+	}
+
+	// Any further transmissions are duplicates
+	request.message.common.dup = MQTT_DUP_TRUE;
+	return true;
+}
+
+/*
+ * Send one message which is due for re-sending, either because the retry timer has expired
+ * or because it was interrupted by a disconnection
+ */
+bool MqttClient::resendInflight()
+{
+	if(!bitsSet(flags, MQTT_CLIENT_CONNECTED)) {
+		return false;
+	}
+
+	auto& map = static_cast<const InflightMap&>(inflight);
+	for(unsigned i = 0; i < map.count(); ++i) {
+		auto id = map.keyAt(i);
+		auto msg = inflight.find(id);
+		if(msg->streamed && !msg->released) {
+			// Nothing to re-send until PUBREC arrives
+			continue;
+		}
+		if(msg->pending || (retryInterval != 0 && msg->retryTimer.expired())) {
+			debug_d("[MQTT] Re-sending #%u", id);
+			transmit(id, *msg);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MqttClient::acknowledge(mqtt_message_t& message)
+{
+	uint16_t id;
+	switch(message.common.type) {
+	case MQTT_TYPE_PUBACK:
+		id = message.puback.message_id;
+		break;
+	case MQTT_TYPE_PUBREC:
+		id = message.pubrec.message_id;
+		break;
+	case MQTT_TYPE_PUBCOMP:
+		id = message.pubcomp.message_id;
+		break;
+	default:
+		return;
+	}
+
+	auto msg = inflight.find(id);
+	if(msg == nullptr) {
+		debug_w("[MQTT] Unexpected acknowledgement for #%u", id);
+		return;
+	}
+
+	if(message.common.type == MQTT_TYPE_PUBREC) {
+		// Payload no longer required
+		if(!msg->released) {
+			msg->request.reset();
+			msg->released = true;
+			if(spool != nullptr && !msg->streamed) {
+				spool->release(id);
+			}
+		}
+		msg->pending = true;
+		return;
+	}
+
+	if(spool != nullptr && !msg->streamed) {
+		spool->remove(id);
+	}
+	inflight.remove(id);
+}
+
 bool MqttClient::publish(const String& topic, IDataSourceStream* stream, uint8_t flags)
 {
+	MALLOC_TAG_SCOPE(mqtt);
 	if(!stream || stream->available() < 1) {
 		debug_e("Sending empty stream or stream with unknown size is not supported");
 		return false;
@@ -329,15 +762,36 @@ bool MqttClient::subscribe(const String& topic)
 	return requestQueue.enqueue(message);
 }
 
+bool MqttClient::subscribe(const String& topic, MqttDelegate handler, MqttPayloadParser payloadParser)
+{
+	MALLOC_TAG_SCOPE(mqtt);
+	bool isNew = !subscriptions.contains(topic);
+	if(!subscriptions.add(topic, handler, payloadParser)) {
+		debug_e("[MQTT] Invalid topic filter '%s'", topic.c_str());
+		return false;
+	}
+
+	if(!subscribe(topic)) {
+		if(isNew) {
+			subscriptions.remove(topic);
+		}
+		return false;
+	}
+
+	return true;
+}
+
 bool MqttClient::unsubscribe(const String& topic)
 {
 	debug_d("unsubscribing from '%s'", topic.c_str());
 
+	subscriptions.remove(topic);
+
 	if(requestQueue.full()) {
 		return false;
 	}
 
-	auto message = createMessage(MQTT_TYPE_SUBSCRIBE);
+	auto message = createMessage(MQTT_TYPE_UNSUBSCRIBE);
 
 	message->unsubscribe.topics = (mqtt_topic_t*)MQTT_MALLOC(sizeof(mqtt_topic_t));
 	memset(message->unsubscribe.topics, 0, sizeof(mqtt_topic_t));
@@ -351,16 +805,21 @@ bool MqttClient::unsubscribe(const String& topic)
 
 void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 {
+	MALLOC_TAG_SCOPE(mqtt);
 	switch(state) {
 	REENTER:
 	case eMCS_Ready: {
 		if(outgoingMessage != &connectMessage) {
 			deleteMessage(outgoingMessage);
 		}
+		outgoingMessage = nullptr;
 		if(connectQueued) {
 			outgoingMessage = &connectMessage;
 			connectQueued = false;
-		} else {
+		} else if(resendInflight()) {
+			state = eMCS_SendingData;
+			goto SENDING;
+		} else if(isWindowOpen(requestQueue.peek())) {
 			outgoingMessage = requestQueue.dequeue();
 		}
 		if(!outgoingMessage) {
@@ -372,6 +831,12 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 			outgoingMessage = createMessage(MQTT_TYPE_PINGREQ);
 		}
 
+		if(isPublishRequest(outgoingMessage)) {
+			startPublish(*outgoingMessage);
+			state = eMCS_SendingData;
+			goto SENDING;
+		}
+
 		debug_d("[MQTT] Sending message type %u", outgoingMessage->common.type);
 
 		IDataSourceStream* payloadStream{nullptr};
@@ -381,6 +846,17 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 			if(payloadStream) {
 				outgoingMessage->publish.content.length = payloadStream->available();
 			}
+			if(outgoingMessage->common.qos != MQTT_QOS_AT_MOST_ONCE) {
+				auto id = getNextMessageId();
+				outgoingMessage->publish.message_id = id;
+				// Track so acknowledgement completes, and for QoS 2 gets a PUBREL
+				auto msg = new InflightMessage;
+				if(msg != nullptr) {
+					msg->pending = false;
+					msg->streamed = true;
+					inflight.set(id, msg);
+				}
+			}
 		}
 
 		size_t packetLength = mqtt_serialiser_size(&serialiser, outgoingMessage);
@@ -408,6 +884,7 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 		[[fallthrough]];
 	}
 
+	SENDING:
 	case eMCS_SendingData:
 		pingTimer.start();
 		if(stream != nullptr && !stream->isFinished()) {
@@ -427,5 +904,19 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 void MqttClient::onFinished(TcpClientState finishState)
 {
 	clearBits(flags, MQTT_CLIENT_CONNECTED);
+	clearMatches();
+
+	// Anything unacknowledged must be re-sent after reconnecting, except stream content which is lost
+	auto& map = static_cast<const InflightMap&>(inflight);
+	for(unsigned i = map.count(); i-- != 0;) {
+		auto id = map.keyAt(i);
+		auto msg = inflight.find(id);
+		if(msg->streamed && !msg->released) {
+			inflight.remove(id);
+		} else {
+			msg->pending = true;
+		}
+	}
+
 	TcpClient::onFinished(finishState);
 }
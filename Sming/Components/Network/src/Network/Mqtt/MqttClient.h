@@ -16,8 +16,11 @@
 #include <WString.h>
 #include <WHashMap.h>
 #include <Data/ObjectQueue.h>
+#include <Data/ObjectMap.h>
 #include <Platform/Timers.h>
 #include "MqttPayloadParser.h"
+#include "MqttSpool.h"
+#include "MqttTopicTree.h"
 #include <mqtt-codec/src/message.h>
 #include <mqtt-codec/src/serialiser.h>
 #include <mqtt-codec/src/parser.h>
@@ -34,13 +37,24 @@ enum MqttClientState { eMCS_Ready = 0, eMCS_SendingData };
 #define MQTT_REQUEST_POOL_SIZE 10
 #endif
 
+/**
+ * @brief Default maximum number of QoS 1/2 messages awaiting acknowledgement
+ */
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 8
+#endif
+
+/**
+ * @brief Default time in seconds before an unacknowledged message is re-sent
+ */
+#ifndef MQTT_RETRY_INTERVAL
+#define MQTT_RETRY_INTERVAL 20
+#endif
+
 #define MQTT_CLIENT_CONNECTED bit(1)
 
 #define MQTT_FLAG_RETAINED 1
 
-class MqttClient;
-
-using MqttDelegate = Delegate<int(MqttClient& client, mqtt_message_t* message)>;
 using MqttRequestQueue = ObjectQueue<mqtt_message_t, MQTT_REQUEST_POOL_SIZE>;
 
 class MqttClient : protected TcpClient
@@ -75,6 +89,41 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Set maximum number of QoS 1/2 messages which may be awaiting acknowledgement
+	 * @param count Use 1 for stop-and-wait behaviour
+	 * @note Further messages are held in the request queue until the window opens.
+	 */
+	void setMaxInflight(uint8_t count)
+	{
+		maxInflight = std::max(count, uint8_t(1));
+	}
+
+	/**
+	 * @brief Get number of QoS 1/2 messages awaiting acknowledgement
+	 */
+	unsigned getInflightCount() const
+	{
+		return inflight.count();
+	}
+
+	/**
+	 * @brief Set time after which an unacknowledged message is re-sent
+	 * @param seconds Use 0 to re-send only after reconnecting
+	 */
+	void setRetryInterval(uint16_t seconds)
+	{
+		retryInterval = seconds;
+	}
+
+	/**
+	 * @brief Persist QoS 1/2 messages until acknowledged
+	 * @param spool Must remain valid whilst in use by the client. Pass nullptr to stop spooling.
+	 * @retval unsigned Number of unacknowledged messages restored from the spool
+	 * @note Call before connecting. Restored messages are re-sent once the connection is established.
+	 */
+	unsigned setSpool(MqttSpool* spool);
+
 	/**
 	 * Sets last will and testament
 	 * @param topic
@@ -98,7 +147,30 @@ public:
 	 * @param flags Optional flags
 	 * @retval bool
 	 */
-	bool publish(const String& topic, const String& message, uint8_t flags = 0);
+	bool publish(const String& topic, const String& message, uint8_t flags = 0)
+	{
+		return publish(String(topic), String(message), flags);
+	}
+
+	/**
+	 * @brief Publish a message without copying topic or content
+	 * @param topic Moved into client
+	 * @param message Message content, moved into client
+	 * @param flags Optional flags
+	 * @retval bool
+	 * @note If nothing else is waiting to be sent the message is serialised directly
+	 * into the TCP send buffer, otherwise it is queued without copying.
+	 */
+	bool publish(String&& topic, String&& message, uint8_t flags = 0);
+
+	/**
+	 * @brief Publish a message using a topic stored in flash
+	 * @param topic Must remain valid until message has been sent
+	 * @param message Message content, moved into client
+	 * @param flags Optional flags
+	 * @retval bool
+	 */
+	bool publish(const FlashString& topic, String&& message, uint8_t flags = 0);
 
 	/**
 	 * @brief Publish a message
@@ -106,6 +178,8 @@ public:
 	 * @param message Message content as read-only stream
 	 * @param flags Optional flags
 	 * @retval bool
+	 * @note QoS 1/2 messages published this way occupy a slot in the in-flight window until acknowledged.
+	 * Stream content cannot be re-sent or spooled, so is lost if the connection drops before then.
 	 */
 	bool publish(const String& topic, IDataSourceStream* stream, uint8_t flags = 0);
 
@@ -116,10 +190,23 @@ public:
 	 */
 	bool subscribe(const String& topic);
 
+	/**
+	 * @brief Subscribe to a topic and register a handler for matching messages
+	 * @param topic Topic filter, which may contain `+` and `#` wildcards
+	 * @param handler Invoked for each received PUBLISH message whose topic matches the filter
+	 * @param payloadParser Optional parser to stream content of matching messages,
+	 * instead of the parser set by `setPayloadParser()`
+	 * @retval bool
+	 * @note Messages which match no registered filter go to the handler set by `setMessageHandler()`.
+	 * Where filters overlap, every matching handler is invoked.
+	 */
+	bool subscribe(const String& topic, MqttDelegate handler, MqttPayloadParser payloadParser = nullptr);
+
 	/**
 	 * @brief Unsubscribe from a topic
 	 * @param topic
 	 * @retval bool
+	 * @note Any handler registered for this topic filter is removed
 	 */
 	bool unsubscribe(const String& topic);
 
@@ -230,6 +317,25 @@ private:
 	static int staticOnMessageEnd(void* user_data, mqtt_message_t* message);
 	int onMessageEnd(mqtt_message_t* message);
 
+	// Topic filter dispatch
+	void matchSubscriptions(const mqtt_message_t& message);
+	void clearMatches();
+	int parsePayload(mqtt_message_t* message, const char* data, int length);
+
+	// Zero-copy publishing: message is the first member of a PublishRequest
+	bool submitPublish(mqtt_message_t& message);
+	bool startPublish(mqtt_message_t& message);
+	bool sendPublish(mqtt_message_t& message, const std::shared_ptr<void>& owner = nullptr);
+
+	// QoS 1/2 in-flight window
+	struct InflightMessage;
+	using InflightMap = ObjectMap<uint16_t, InflightMessage>;
+	uint16_t getNextMessageId();
+	bool isWindowOpen(const mqtt_message_t* message) const;
+	bool transmit(uint16_t id, InflightMessage& msg);
+	bool resendInflight();
+	void acknowledge(mqtt_message_t& message);
+
 private:
 	Url url;
 
@@ -237,6 +343,9 @@ private:
 	using HandlerMap = HashMap<mqtt_type_t, MqttDelegate>;
 	HandlerMap eventHandlers;
 	MqttPayloadParser payloadParser = nullptr;
+	MqttTopicTree subscriptions;
+	MqttTopicTree::MatchList matches; ///< Subscriptions matching the incoming message
+	bool matchesValid = false;
 
 	// states
 	MqttClientState state = eMCS_Ready;
@@ -254,6 +363,13 @@ private:
 	mqtt_message_t* outgoingMessage = nullptr;
 	mqtt_message_t incomingMessage;
 
+	// in-flight window
+	InflightMap inflight;
+	MqttSpool* spool = nullptr;
+	uint16_t messageId = 0; ///< Last packet identifier allocated
+	uint16_t retryInterval = MQTT_RETRY_INTERVAL;
+	uint8_t maxInflight = MQTT_MAX_INFLIGHT;
+
 	// parsers and serializers
 	mqtt_serialiser_t serialiser;
 	static const mqtt_parser_callbacks_t callbacks;
@@ -0,0 +1,181 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttSpool.cpp
+ *
+ ****/
+
+#include "MqttSpool.h"
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr uint8_t RECORD_MAGIC{0xA5};
+
+// Flash bits can only be cleared without an erase, so each transition clears more bits
+constexpr uint8_t RECORD_WRITING{0xff}; ///< Header written, body may be incomplete
+constexpr uint8_t RECORD_STORED{0xfe};
+constexpr uint8_t RECORD_RELEASED{0x7e};
+constexpr uint8_t RECORD_REMOVED{0x00};
+
+struct RecordHeader {
+	uint8_t magic; ///< RECORD_MAGIC, 0xff if erased
+	uint8_t state; ///< RECORD_xxx
+	uint16_t id;
+	uint8_t flags;
+	uint8_t reserved;
+	uint16_t topicLength;
+	uint32_t contentLength;
+
+	size_t recordSize() const
+	{
+		return ALIGNUP4(sizeof(RecordHeader) + topicLength + contentLength);
+	}
+
+	bool isErased() const
+	{
+		auto p = reinterpret_cast<const uint8_t*>(this);
+		for(unsigned i = 0; i < sizeof(RecordHeader); ++i) {
+			if(p[i] != 0xff) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+static_assert(sizeof(RecordHeader) == 12, "Bad RecordHeader size");
+
+bool readString(Storage::Partition& partition, storage_size_t offset, String& s, size_t length)
+{
+	if(!s.setLength(length)) {
+		return false;
+	}
+	return partition.read(offset, s.begin(), length);
+}
+
+} // namespace
+
+unsigned MqttPartitionSpool::load(LoadCallback callback)
+{
+	records.clear();
+	writeOffset = 0;
+
+	auto size = partition.size();
+	RecordHeader hdr;
+	while(writeOffset + sizeof(hdr) <= size) {
+		if(!partition.read(writeOffset, hdr)) {
+			writeOffset = size;
+			break;
+		}
+		if(hdr.magic != RECORD_MAGIC) {
+			// Records are started by writing the header, so anything programmed here wasn't written by us
+			if(!hdr.isErased()) {
+				// Corrupt: don't write any more until the partition has been erased
+				debug_w("[MQTT] Spool corrupt at 0x%08x", unsigned(writeOffset));
+				writeOffset = size;
+			}
+			break;
+		}
+		if(writeOffset + hdr.recordSize() > size) {
+			writeOffset = size;
+			break;
+		}
+
+		if(hdr.state == RECORD_WRITING) {
+			// Interrupted whilst writing, so never acknowledged as stored: skip over it
+			debug_w("[MQTT] Spool record #%u incomplete", hdr.id);
+		} else if(hdr.state != RECORD_REMOVED) {
+			String topic;
+			String content;
+			auto offset = writeOffset + sizeof(hdr);
+			if(readString(partition, offset, topic, hdr.topicLength) &&
+			   readString(partition, offset + hdr.topicLength, content, hdr.contentLength)) {
+				records[hdr.id] = writeOffset;
+				if(callback) {
+					callback(hdr.id, hdr.flags, topic, content, hdr.state == RECORD_RELEASED);
+				}
+			} else {
+				debug_e("[MQTT] Spool read failed");
+			}
+		}
+
+		writeOffset += hdr.recordSize();
+	}
+
+	debug_d("[MQTT] Spool has %u messages, %u bytes used", records.count(), unsigned(writeOffset));
+
+	return records.count();
+}
+
+bool MqttPartitionSpool::store(uint16_t id, uint8_t flags, const String& topic, const String& content)
+{
+	RecordHeader hdr{
+		.magic = RECORD_MAGIC,
+		.state = RECORD_WRITING,
+		.id = id,
+		.flags = flags,
+		.reserved = 0xff,
+		.topicLength = uint16_t(topic.length()),
+		.contentLength = uint32_t(content.length()),
+	};
+
+	auto size = partition.size();
+	if(writeOffset + hdr.recordSize() > size) {
+		if(records.count() != 0 || hdr.recordSize() > size) {
+			debug_w("[MQTT] Spool full");
+			return false;
+		}
+		debug_d("[MQTT] Erasing spool");
+		if(!partition.erase_range(0, size)) {
+			return false;
+		}
+		writeOffset = 0;
+	}
+
+	/*
+	 * Header first so the space is claimed, then commit once the body is complete.
+	 * An interrupted write is then skipped by load() rather than being written over.
+	 */
+	auto offset = writeOffset + sizeof(hdr);
+	const uint8_t state{RECORD_STORED};
+	if(!partition.write(writeOffset, &hdr, sizeof(hdr)) ||
+	   !partition.write(offset, topic.c_str(), hdr.topicLength) ||
+	   !partition.write(offset + hdr.topicLength, content.c_str(), hdr.contentLength) ||
+	   !partition.write(writeOffset + offsetof(RecordHeader, state), &state, sizeof(state))) {
+		debug_e("[MQTT] Spool write failed");
+		// Region no longer erased
+		writeOffset = size;
+		return false;
+	}
+
+	records[id] = writeOffset;
+	writeOffset += hdr.recordSize();
+	return true;
+}
+
+bool MqttPartitionSpool::setState(uint16_t id, uint8_t state)
+{
+	int i = records.indexOf(id);
+	if(i < 0) {
+		return false;
+	}
+
+	auto offset = records.valueAt(i) + offsetof(RecordHeader, state);
+	return partition.write(offset, &state, sizeof(state));
+}
+
+void MqttPartitionSpool::release(uint16_t id)
+{
+	setState(id, RECORD_RELEASED);
+}
+
+void MqttPartitionSpool::remove(uint16_t id)
+{
+	if(setState(id, RECORD_REMOVED)) {
+		records.remove(id);
+	}
+}
@@ -0,0 +1,108 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttSpool.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <WHashMap.h>
+#include <Delegate.h>
+#include <Storage/Partition.h>
+
+/** @defgroup   mqttspool MQTT message spool
+ *  @brief      Persistent storage for unacknowledged QoS 1/2 messages
+ *  @ingroup    mqttclient
+ *  @{
+ */
+
+/**
+ * @brief Interface for persisting the MQTT client in-flight window
+ *
+ * Messages are stored when first sent and removed once acknowledged,
+ * so they can be re-sent after a restart.
+ */
+class MqttSpool
+{
+public:
+	/**
+	 * @brief Invoked for each message found by `load()`
+	 * @param id Packet identifier
+	 * @param flags Publish flags, as returned by `MqttClient::getFlags()`
+	 * @param topic Moved into client
+	 * @param content Moved into client
+	 * @param released true if PUBREC has been received for this (QoS 2) message
+	 */
+	using LoadCallback = Delegate<void(uint16_t id, uint8_t flags, String& topic, String& content, bool released)>;
+
+	virtual ~MqttSpool()
+	{
+	}
+
+	/**
+	 * @brief Read back all stored messages
+	 * @param callback Invoked for each message still awaiting acknowledgement
+	 * @retval unsigned Number of messages found
+	 * @note Must be called once before any other method
+	 */
+	virtual unsigned load(LoadCallback callback) = 0;
+
+	/**
+	 * @brief Store a message when it enters the in-flight window
+	 * @retval bool false if the message could not be stored
+	 */
+	virtual bool store(uint16_t id, uint8_t flags, const String& topic, const String& content) = 0;
+
+	/**
+	 * @brief Record that PUBREC has been received, so PUBREL is sent instead of the message
+	 */
+	virtual void release(uint16_t id) = 0;
+
+	/**
+	 * @brief Discard an acknowledged message
+	 */
+	virtual void remove(uint16_t id) = 0;
+};
+
+/**
+ * @brief Spool messages to a flash partition
+ *
+ * Messages are appended to the partition as a log.
+ * Releasing or removing a message only clears bits in its record header so no erase is required.
+ * A record is only committed once completely written, so one interrupted by power loss is skipped on reload.
+ * The partition is erased when full, provided all messages in it have been acknowledged.
+ */
+class MqttPartitionSpool : public MqttSpool
+{
+public:
+	MqttPartitionSpool(Storage::Partition partition) : partition(partition)
+	{
+	}
+
+	unsigned load(LoadCallback callback) override;
+	bool store(uint16_t id, uint8_t flags, const String& topic, const String& content) override;
+	void release(uint16_t id) override;
+	void remove(uint16_t id) override;
+
+	/**
+	 * @brief Get number of messages currently stored
+	 */
+	unsigned count() const
+	{
+		return records.count();
+	}
+
+private:
+	bool setState(uint16_t id, uint8_t state);
+
+	Storage::Partition partition;
+	HashMap<uint16_t, storage_size_t> records; ///< Packet ID -> record offset
+	storage_size_t writeOffset{0};			   ///< Where next record will be written
+};
+
+/** @} */
@@ -0,0 +1,263 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicTree.cpp
+ *
+ ****/
+
+#include "MqttTopicTree.h"
+
+namespace
+{
+// Return end of topic level
+const char* findSeparator(const char* level, const char* end)
+{
+	auto sep = static_cast<const char*>(memchr(level, '/', end - level));
+	return sep ?: end;
+}
+
+void addMatch(MqttTopicTree::Subscription* sub, MqttTopicTree::MatchList& list)
+{
+	if(sub != nullptr && !sub->removed) {
+		list.add(sub);
+	}
+}
+
+} // namespace
+
+bool MqttTopicTree::isValidFilter(const String& filter)
+{
+	if(filter.length() == 0 || filter.length() > 0xffff) {
+		return false;
+	}
+
+	auto level = filter.c_str();
+	auto end = level + filter.length();
+	for(;;) {
+		auto sep = findSeparator(level, end);
+		auto len = sep - level;
+		for(auto p = level; p != sep; ++p) {
+			if((*p == '+' || *p == '#') && len != 1) {
+				return false;
+			}
+		}
+		if(*level == '#' && sep != end) {
+			return false;
+		}
+		if(sep == end) {
+			return true;
+		}
+		level = sep + 1;
+	}
+}
+
+std::unique_ptr<MqttTopicTree::Subscription>* MqttTopicTree::getSlot(const String& filter, bool create)
+{
+	auto node = &root;
+	auto level = filter.c_str();
+	auto end = level + filter.length();
+	for(;;) {
+		auto sep = findSeparator(level, end);
+		auto len = sep - level;
+		if(len == 1 && *level == '#') {
+			return &node->remaining;
+		}
+
+		Node* child;
+		if(len == 1 && *level == '+') {
+			if(!node->anyLevel && create) {
+				node->anyLevel.reset(new Node);
+			}
+			child = node->anyLevel.get();
+		} else {
+			String name(level, len);
+			child = node->children.find(name);
+			if(child == nullptr && create) {
+				child = new Node;
+				node->children.set(name, child);
+			}
+		}
+		if(child == nullptr) {
+			return nullptr;
+		}
+
+		node = child;
+		if(sep == end) {
+			return &node->subscription;
+		}
+		level = sep + 1;
+	}
+}
+
+bool MqttTopicTree::add(const String& filter, MqttDelegate handler, MqttPayloadParser payloadParser)
+{
+	if(!handler || !isValidFilter(filter)) {
+		return false;
+	}
+
+	auto slot = getSlot(filter, true);
+	if(slot == nullptr) {
+		return false;
+	}
+
+	auto& sub = *slot;
+	if(!sub) {
+		sub.reset(new Subscription);
+		if(!sub) {
+			return false;
+		}
+		++subscriptionCount;
+	} else if(sub->removed) {
+		sub->removed = false;
+		++subscriptionCount;
+	}
+
+	sub->handler = handler;
+	sub->payloadParser = payloadParser;
+	return true;
+}
+
+MqttTopicTree::Subscription* MqttTopicTree::find(const String& filter)
+{
+	if(!isValidFilter(filter)) {
+		return nullptr;
+	}
+
+	auto slot = getSlot(filter, false);
+	if(slot == nullptr || !*slot || (*slot)->removed) {
+		return nullptr;
+	}
+
+	return slot->get();
+}
+
+bool MqttTopicTree::remove(const String& filter)
+{
+	auto sub = find(filter);
+	if(sub == nullptr) {
+		return false;
+	}
+
+	sub->removed = true;
+	--subscriptionCount;
+	pruneRequired = true;
+	if(lockCount == 0) {
+		unlock();
+	}
+
+	return true;
+}
+
+void MqttTopicTree::clear()
+{
+	subscriptionCount = 0;
+	if(lockCount != 0) {
+		markRemoved(root);
+		pruneRequired = true;
+		return;
+	}
+
+	root.children.clear();
+	root.anyLevel.reset();
+	root.subscription.reset();
+	root.remaining.reset();
+	pruneRequired = false;
+}
+
+void MqttTopicTree::markRemoved(Node& node)
+{
+	for(auto sub : {node.subscription.get(), node.remaining.get()}) {
+		if(sub != nullptr) {
+			sub->removed = true;
+		}
+	}
+	if(node.anyLevel) {
+		markRemoved(*node.anyLevel);
+	}
+	for(unsigned i = 0; i < node.children.count(); ++i) {
+		Node* child = node.children.valueAt(i);
+		markRemoved(*child);
+	}
+}
+
+void MqttTopicTree::unlock()
+{
+	if(lockCount != 0) {
+		--lockCount;
+	}
+	if(lockCount == 0 && pruneRequired) {
+		prune(root);
+		pruneRequired = false;
+	}
+}
+
+/*
+ * Free removed subscriptions and any nodes left empty
+ * Returns true if the node itself is now empty
+ */
+bool MqttTopicTree::prune(Node& node)
+{
+	auto pruneSubscription = [](std::unique_ptr<Subscription>& sub) {
+		if(sub && sub->removed) {
+			sub.reset();
+		}
+	};
+
+	pruneSubscription(node.subscription);
+	pruneSubscription(node.remaining);
+
+	if(node.anyLevel && prune(*node.anyLevel)) {
+		node.anyLevel.reset();
+	}
+
+	for(int i = node.children.count() - 1; i >= 0; --i) {
+		Node* child = node.children.valueAt(i);
+		if(prune(*child)) {
+			node.children.removeAt(i);
+		}
+	}
+
+	return !node.subscription && !node.remaining && !node.anyLevel && node.children.count() == 0;
+}
+
+unsigned MqttTopicTree::match(const char* topic, size_t length, MatchList& list)
+{
+	if(topic == nullptr || subscriptionCount == 0) {
+		return 0;
+	}
+
+	auto count = list.count();
+	matchLevel(root, topic, topic + length, true, list);
+	return list.count() - count;
+}
+
+void MqttTopicTree::matchLevel(Node& node, const char* level, const char* end, bool first, MatchList& list)
+{
+	// Topics starting with '$' are not matched by wildcards at the first level
+	bool wildcards = !(first && level != end && *level == '$');
+	if(wildcards) {
+		addMatch(node.remaining.get(), list);
+	}
+
+	auto sep = findSeparator(level, end);
+	auto visit = [&](Node* child) {
+		if(child == nullptr) {
+			return;
+		}
+		if(sep != end) {
+			matchLevel(*child, sep + 1, end, false, list);
+			return;
+		}
+		addMatch(child->subscription.get(), list);
+		// `#` also matches the parent level
+		addMatch(child->remaining.get(), list);
+	};
+
+	visit(node.children.find(String(level, sep - level)));
+	if(wildcards) {
+		visit(node.anyLevel.get());
+	}
+}
@@ -0,0 +1,135 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicTree.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <WVector.h>
+#include <Data/ObjectMap.h>
+#include <Delegate.h>
+#include <memory>
+#include "MqttPayloadParser.h"
+
+/** @defgroup   mqtttopictree MQTT topic filters
+ *  @brief      Dispatch incoming messages by topic
+ *  @ingroup    mqttclient
+ *  @{
+ */
+
+class MqttClient;
+
+using MqttDelegate = Delegate<int(MqttClient& client, mqtt_message_t* message)>;
+
+/**
+ * @brief Registry of topic filters, stored as a trie of topic levels
+ *
+ * Filters may contain `+` (match one level) and `#` (match all remaining levels) wildcards.
+ * The cost of matching a topic depends on its number of levels, not on the number of filters.
+ * Child levels are looked up by hash once a node has several of them.
+ */
+class MqttTopicTree
+{
+public:
+	struct Subscription {
+		MqttDelegate handler;
+		MqttPayloadParser payloadParser; ///< Optional: receives content of matching messages
+		MqttPayloadParserState payloadState{};
+		bool removed{false}; ///< Set if removed whilst tree is locked
+	};
+
+	using MatchList = Vector<Subscription*>;
+
+	MqttTopicTree() = default;
+	MqttTopicTree(const MqttTopicTree&) = delete;
+	MqttTopicTree& operator=(const MqttTopicTree&) = delete;
+
+	/**
+	 * @brief Check a topic filter is well-formed
+	 *
+	 * Wildcards must occupy an entire level, and `#` must be the last level.
+	 */
+	static bool isValidFilter(const String& filter);
+
+	/**
+	 * @brief Add or replace a subscription
+	 * @param filter Topic filter
+	 * @param handler Invoked for messages whose topic matches the filter
+	 * @param payloadParser Optional parser to stream message content
+	 * @retval bool false if filter is invalid
+	 */
+	bool add(const String& filter, MqttDelegate handler, MqttPayloadParser payloadParser = nullptr);
+
+	/**
+	 * @brief Remove a subscription
+	 * @retval bool false if filter not registered
+	 */
+	bool remove(const String& filter);
+
+	/**
+	 * @brief Find subscription for an exact filter
+	 * @retval Subscription* nullptr if not registered
+	 */
+	Subscription* find(const String& filter);
+
+	bool contains(const String& filter)
+	{
+		return find(filter) != nullptr;
+	}
+
+	/**
+	 * @brief Get number of registered filters
+	 */
+	unsigned count() const
+	{
+		return subscriptionCount;
+	}
+
+	void clear();
+
+	/**
+	 * @brief Find all subscriptions matching a topic
+	 * @param topic Topic name from received message
+	 * @param length Length of topic
+	 * @param list Matching subscriptions are appended to this list
+	 * @retval unsigned Number of matches found
+	 * @note Lock the tree whilst using the results if handlers may modify it
+	 */
+	unsigned match(const char* topic, size_t length, MatchList& list);
+
+	/**
+	 * @brief Defer freeing removed subscriptions whilst match results are in use
+	 */
+	void lock()
+	{
+		++lockCount;
+	}
+
+	void unlock();
+
+private:
+	struct Node {
+		ObjectMap<String, Node, HashMapHash<String>> children;
+		std::unique_ptr<Node> anyLevel;				///< `+` wildcard
+		std::unique_ptr<Subscription> subscription; ///< Filter ends at this level
+		std::unique_ptr<Subscription> remaining;	///< `#` wildcard follows this level
+	};
+
+	std::unique_ptr<Subscription>* getSlot(const String& filter, bool create);
+	void matchLevel(Node& node, const char* level, const char* end, bool first, MatchList& list);
+	bool prune(Node& node);
+	void markRemoved(Node& node);
+
+	Node root;
+	unsigned subscriptionCount{0};
+	unsigned lockCount{0};
+	bool pruneRequired{false};
+};
+
+/** @} */
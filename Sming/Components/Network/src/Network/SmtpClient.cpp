@@ -252,7 +252,7 @@ void SmtpClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 
 		// send the final dot
 		state = eSMTP_Sent;
-		delete stream;
+		releaseStream(stream);
 		stream = nullptr;
 
 		sendString(F("\r\n.\r\n"));
@@ -330,7 +330,8 @@ bool SmtpClient::sendMailBody(MailMessage* mail)
 		return true;
 	}
 
-	delete stream;
+	// Content may still be queued by reference
+	releaseStream(stream);
 	stream = mail->stream.release(); // avoid intermediate buffers
 
 	return false;
@@ -12,10 +12,55 @@
 #include "Data/Stream/MemoryDataStream.h"
 #include "Data/Stream/StreamChain.h"
 
+namespace
+{
+/*
+ * Shares ownership of a stream whose content may be referenced by the TCP send queue.
+ * One reference is attached to a chain, another released to the connection.
+ */
+class SharedStreamRef : public IDataSourceStream
+{
+public:
+	SharedStreamRef(std::shared_ptr<IDataSourceStream> source) : source(source)
+	{
+	}
+
+	StreamType getStreamType() const override
+	{
+		return source->getStreamType();
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override
+	{
+		return source->readMemoryBlock(data, bufSize);
+	}
+
+	bool seek(int len) override
+	{
+		return source->seek(len);
+	}
+
+	bool isFinished() override
+	{
+		return source->isFinished();
+	}
+
+	int available() override
+	{
+		return source->available();
+	}
+
+private:
+	std::shared_ptr<IDataSourceStream> source;
+};
+
+} // namespace
+
 void TcpClient::freeStreams()
 {
-	delete stream;
+	releaseStream(stream);
 	stream = nullptr;
+	pendingBytes = 0;
 }
 
 bool TcpClient::connect(const String& server, int port, bool useSsl)
@@ -46,7 +91,13 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 
 	std::unique_ptr<MemoryDataStream> newStream;
 	auto memoryStream = static_cast<MemoryDataStream*>(stream);
-	if(memoryStream == nullptr || memoryStream->getStreamType() != eSST_MemoryWritable) {
+	bool canAppend = memoryStream != nullptr && memoryStream->getStreamType() == eSST_MemoryWritable;
+	if(canAppend && isReferencePending() && size_t(memoryStream->available()) < memoryStream->getSize() &&
+	   memoryStream->getSize() + len > memoryStream->getCapacity()) {
+		// Content already written by reference must not be moved by reallocation
+		canAppend = false;
+	}
+	if(!canAppend) {
 		newStream = std::make_unique<MemoryDataStream>();
 		if(!newStream) {
 			return false;
@@ -60,6 +111,10 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 	}
 
 	memoryStream->write(data, len);
+	if(!newStream) {
+		// Appended to current stream
+		pendingBytes += len;
+	}
 
 	(void)newStream.release();
 	return send(memoryStream, forceCloseAfterSent);
@@ -68,7 +123,8 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 {
 	std::unique_ptr<IDataSourceStream> sourceRef;
-	if(stream != source) {
+	bool isNewSource = (stream != source);
+	if(isNewSource) {
 		sourceRef.reset(source);
 	}
 
@@ -97,7 +153,14 @@ bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 				return false;
 			}
 
-			if(!chainStream->attachStream(stream)) {
+			IDataSourceStream* current = stream;
+			if(isReferencePending()) {
+				// Chain releases the stream when read out, but queued data may still refer to it
+				std::shared_ptr<IDataSourceStream> shared(stream);
+				releaseStreamHolder(stream, new SharedStreamRef(shared));
+				current = new SharedStreamRef(shared);
+			}
+			if(!chainStream->attachStream(current)) {
 				debug_w("Unable to attach stream to new chain!");
 				return false;
 			}
@@ -116,6 +179,9 @@ bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 	int length = source->available();
 	if(length > 0) {
 		totalSentBytes += length;
+		if(isNewSource) {
+			pendingBytes += length;
+		}
 	}
 
 	debug_d("Sending stream. Bytes to send: %d", length);
@@ -201,7 +267,11 @@ void TcpClient::pushAsyncPart()
 		return;
 	}
 
-	write(stream);
+	// Streams are disposed of via releaseStream() so content may be sent without copying
+	int written = write(stream, 0);
+	if(written > 0) {
+		pendingBytes -= std::min(pendingBytes, size_t(written));
+	}
 
 	if(stream->isFinished()) {
 		debug_d("TcpClient stream finished");
@@ -118,6 +118,15 @@ public:
 	 */
 	bool send(IDataSourceStream* source, bool forceCloseAfterSent = false);
 
+	/**
+	 * @brief Get number of bytes queued for sending which have not yet been passed to the TCP stack
+	 * @note Streams of unknown size are not included
+	 */
+	size_t getPendingBytes() const
+	{
+		return pendingBytes;
+	}
+
 	bool isProcessing()
 	{
 		return state == eTCS_Connected || state == eTCS_Connecting;
@@ -173,6 +182,7 @@ private:
 	TcpClientCloseAfterSentState closeAfterSent = eTCCASS_None;
 	uint16_t totalSentConfirmedBytes = 0;
 	uint16_t totalSentBytes = 0;
+	size_t pendingBytes = 0;
 };
 
 /** @} */
@@ -14,6 +14,7 @@
 #include "NetUtils.h"
 #include <WString.h>
 #include <lwip/dns.h>
+#include <MallocTag.h>
 
 #define debug_tcp_e(fmt, ...) debug_e("TCP %p " fmt, this, ##__VA_ARGS__)
 #define debug_tcp_w(fmt, ...) debug_w("TCP %p " fmt, this, ##__VA_ARGS__)
@@ -26,10 +27,67 @@
 #define debug_tcp_ext(fmt, ...) debug_none(fmt, ##__VA_ARGS__)
 #endif
 
+/*
+ * Takes over a closed connection whilst its send queue still refers to released stream content.
+ * Once everything has been acknowledged the connection is closed and the streams deleted.
+ */
+class TcpConnection::RetainedConnection : public TcpConnection
+{
+public:
+	RetainedConnection(TcpConnection& source) : TcpConnection(source.tcp, true)
+	{
+		timeOut = TCP_RETAINED_CONNECTION_TIMEOUT;
+		referencePending = true;
+		retainedStreams = std::move(source.retainedStreams);
+		source.referencedStreams.clear();
+		source.referencePending = false;
+		source.tcp = nullptr;
+	}
+
+	void close() override
+	{
+		// Remote may close its side but still acknowledge our data
+		if(!referencePending) {
+			TcpConnection::close();
+		}
+	}
+
+protected:
+	err_t onSent(uint16_t) override
+	{
+		if(!referencePending) {
+			// Connection gets deleted on return from internalOnSent()
+			tcp_poll(tcp, staticOnPoll, 1);
+			tcp_arg(tcp, nullptr);
+			tcp = nullptr;
+		}
+		return ERR_OK;
+	}
+
+	err_t onPoll() override
+	{
+		if(sleep < timeOut) {
+			return ERR_OK;
+		}
+
+		debug_tcp_w("abort, data written by reference not acknowledged");
+		tcp_arg(tcp, nullptr);
+		tcp_err(tcp, nullptr);
+		tcp_abort(tcp);
+		// pcb has been freed so must not be touched again by destructor
+		tcp = nullptr;
+		referencePending = false;
+		releaseRetainedStreams();
+		delete this;
+		return ERR_ABRT;
+	}
+};
+
 TcpConnection::~TcpConnection()
 {
 	autoSelfDestruct = false;
 	close();
+	releaseRetainedStreams();
 
 	delete ssl;
 
@@ -201,6 +259,7 @@ void TcpConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 
 int TcpConnection::write(const char* data, int len, uint8_t apiflags)
 {
+	MALLOC_TAG_SCOPE(tcp);
 	err_t err;
 
 	if(ssl != nullptr) {
@@ -228,13 +287,17 @@ int TcpConnection::write(const char* data, int len, uint8_t apiflags)
 	return len;
 }
 
-int TcpConnection::write(IDataSourceStream* stream)
+int TcpConnection::write(IDataSourceStream* stream, uint8_t apiflags)
 {
 	if(ssl != nullptr && !ssl->isConnected()) {
 		// wait until the SSL handshake is done.
 		return 0;
 	}
 
+	// SSL encrypts into its own buffers so there is nothing to gain by referencing stream content
+	bool byReference = (ssl == nullptr) && (apiflags & TCP_WRITE_FLAG_COPY) == 0;
+	apiflags |= TCP_WRITE_FLAG_MORE;
+
 	// Send data from DataStream
 	size_t total = 0;
 	unsigned pushCount = 0;
@@ -244,15 +307,38 @@ int TcpConnection::write(IDataSourceStream* stream)
 			break;
 		}
 
-		char buffer[NETWORK_SEND_BUFFER_SIZE];
-		auto bytesRead = stream->readMemoryBlock(buffer, std::min(sizeof(buffer), available));
-		if(bytesRead == 0) {
-			break;
+		int bytesWritten;
+		const char* data{nullptr};
+		size_t len = byReference ? stream->peekBuffer(data) : 0;
+#ifdef ARCH_ESP8266
+		// Flash memory cannot be accessed bytewise by the TCP stack
+		if(len != 0 && isFlashPtr(data)) {
+			len = 0;
+		}
+#endif
+		if(len != 0 && !canReference(stream)) {
+			len = 0;
+		}
+		if(len != 0) {
+			bytesWritten = write(data, std::min(len, available), apiflags);
+			if(bytesWritten > 0) {
+				referencePending = true;
+				if(!referencedStreams.contains(stream)) {
+					referencedStreams.add(stream);
+				}
+			}
+		} else {
+			char buffer[NETWORK_SEND_BUFFER_SIZE];
+			auto bytesRead = stream->readMemoryBlock(buffer, std::min(sizeof(buffer), available));
+			if(bytesRead == 0) {
+				break;
+			}
+
+			bytesWritten = write(buffer, bytesRead, apiflags | TCP_WRITE_FLAG_COPY);
 		}
 
 		++pushCount;
 
-		int bytesWritten = write(buffer, bytesRead, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
 		debug_tcp_d("Written: %d, Available: %u, isFinished: %d, PushCount: %u", bytesWritten, available,
 					stream->isFinished(), pushCount);
 
@@ -277,6 +363,54 @@ int TcpConnection::write(IDataSourceStream* stream)
 	return total;
 }
 
+void TcpConnection::releaseStream(IDataSourceStream* stream)
+{
+	if(stream == nullptr) {
+		return;
+	}
+
+	// Streams never written by reference, or whose content has been acknowledged, can go now
+	if(referencedStreams.removeElement(stream)) {
+		retainedStreams.add(stream);
+	} else {
+		delete stream;
+	}
+}
+
+void TcpConnection::releaseStreamHolder(IDataSourceStream* stream, IDataSourceStream* holder)
+{
+	if(holder == nullptr) {
+		return;
+	}
+
+	if(referencedStreams.removeElement(stream)) {
+		retainedStreams.add(holder);
+	} else {
+		delete holder;
+	}
+}
+
+bool TcpConnection::canReference(IDataSourceStream* stream) const
+{
+	if(referencedStreams.contains(stream)) {
+		return true;
+	}
+	if(referencedStreams.count() + retainedStreams.count() < TCP_MAX_RETAINED_STREAMS) {
+		return true;
+	}
+	debug_tcp_d("retained stream limit reached, copying");
+	return false;
+}
+
+void TcpConnection::releaseRetainedStreams()
+{
+	referencedStreams.clear();
+	for(auto stream : retainedStreams) {
+		delete stream;
+	}
+	retainedStreams.clear();
+}
+
 void TcpConnection::close()
 {
 	if(ssl != nullptr) {
@@ -288,9 +422,15 @@ void TcpConnection::close()
 	}
 	debug_tcp_d("connection closing");
 
-	tcp_poll(tcp, staticOnPoll, 1);
-	tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
-	tcp = nullptr;
+	if(referencePending) {
+		// Hand over the connection (and retained streams) so referenced content outlives this object
+		new RetainedConnection(*this);
+		assert(tcp == nullptr);
+	} else {
+		tcp_poll(tcp, staticOnPoll, 1);
+		tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
+		tcp = nullptr;
+	}
 
 	onClosed();
 
@@ -402,6 +542,7 @@ bool TcpConnection::internalConnect(IpAddress addr, uint16_t port)
 
 err_t TcpConnection::internalOnConnected(err_t err)
 {
+	MALLOC_TAG_SCOPE(tcp);
 	debug_tcp_d("connected: useSSL: %d, Error: %d", useSsl, err);
 
 	if(useSsl && err == ERR_OK) {
@@ -448,6 +589,7 @@ bool TcpConnection::enableSsl(const String& hostName)
 
 err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 {
+	MALLOC_TAG_SCOPE(tcp);
 	sleep = 0;
 
 	if(err != ERR_OK /*&& err != ERR_CLSD && err != ERR_RST*/) {
@@ -520,7 +662,13 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 
 err_t TcpConnection::internalOnSent(uint16_t len)
 {
+	MALLOC_TAG_SCOPE(tcp);
 	sleep = 0;
+	if(referencePending && tcp_sndqueuelen(tcp) == 0) {
+		// Everything written by reference has been acknowledged
+		referencePending = false;
+		releaseRetainedStreams();
+	}
 	err_t res = onSent(len);
 	checkSelfFree();
 	debug_tcp_ext("<sent");
@@ -541,6 +689,7 @@ err_t TcpConnection::staticOnPoll(void* arg, tcp_pcb* tcp)
 
 err_t TcpConnection::internalOnPoll()
 {
+	MALLOC_TAG_SCOPE(tcp);
 	sleep++;
 	err_t res = onPoll();
 	if(res == ERR_OK) {
@@ -553,6 +702,8 @@ err_t TcpConnection::internalOnPoll()
 void TcpConnection::internalOnError(err_t err)
 {
 	tcp = nullptr; // IMPORTANT. No available connection after error!
+	referencePending = false;
+	releaseRetainedStreams();
 	onError(err);
 	checkSelfFree();
 	debug_tcp_ext("<error");
@@ -18,11 +18,28 @@
 #include <Network/IpConnection.h>
 #include <Network/Ssl/Session.h>
 #include <lwip/tcp.h>
+#include <WVector.h>
 
 #define NETWORK_DEBUG
 
 #define NETWORK_SEND_BUFFER_SIZE 1024
 
+/**
+ * @brief Poll intervals to wait for acknowledgement of data written by reference after closing
+ */
+#ifndef TCP_RETAINED_CONNECTION_TIMEOUT
+#define TCP_RETAINED_CONNECTION_TIMEOUT 20
+#endif
+
+/**
+ * @brief Maximum number of streams which may be referenced by unacknowledged data
+ *
+ * Once reached, stream content is copied into the send buffer instead.
+ */
+#ifndef TCP_MAX_RETAINED_STREAMS
+#define TCP_MAX_RETAINED_STREAMS 8
+#endif
+
 enum TcpConnectionEvent {
 	eTCE_Connected = 0, ///< Occurs after connection establishment
 	eTCE_Received,		///< Occurs on data receive
@@ -91,8 +108,33 @@ public:
 	 *  @param stream
 	 *  @param apiflags TCP_WRITE_FLAG_COPY, TCP_WRITE_FLAG_MORE
 	 *  @retval int negative on error, 0 when retry is needed or positive on success
+	 *  @note Without TCP_WRITE_FLAG_COPY, content from streams which support `peekBuffer()`
+	 *  is passed to the TCP stack by reference. Such streams must be disposed of using
+	 *  `releaseStream()` so they are kept until the data has been acknowledged.
+	 *  At most TCP_MAX_RETAINED_STREAMS streams are referenced at once, further content is copied.
+	 */
+	int write(IDataSourceStream* stream, uint8_t apiflags = TCP_WRITE_FLAG_COPY);
+
+	/**
+	 * @brief Delete a stream once any of its content queued by reference has been acknowledged
+	 * @param stream
+	 */
+	void releaseStream(IDataSourceStream* stream);
+
+	/**
+	 * @brief Release an object which keeps an active stream alive
+	 * @param stream Stream which may have been written by reference, still in use by the caller
+	 * @param holder Deleted once any queued content of `stream` has been acknowledged
 	 */
-	int write(IDataSourceStream* stream);
+	void releaseStreamHolder(IDataSourceStream* stream, IDataSourceStream* holder);
+
+	/**
+	 * @brief Determine if the send queue contains data written by reference
+	 */
+	bool isReferencePending() const
+	{
+		return referencePending;
+	}
 
 	uint16_t getAvailableWriteSize()
 	{
@@ -215,9 +257,14 @@ protected:
 	void internalOnDnsResponse(const char* name, LWIP_IP_ADDR_T* ipaddr, int port);
 
 private:
+	class RetainedConnection;
+
 	static err_t staticOnPoll(void* arg, tcp_pcb* tcp);
 	static void closeTcpConnection(tcp_pcb* tpcb);
 
+	void releaseRetainedStreams();
+	bool canReference(IDataSourceStream* stream) const;
+
 	void checkSelfFree()
 	{
 		if(tcp == nullptr && autoSelfDestruct) {
@@ -237,6 +284,9 @@ protected:
 
 private:
 	TcpConnectionDestroyedDelegate destroyedDelegate = nullptr;
+	Vector<IDataSourceStream*> referencedStreams{0, 4}; ///< Active streams with content in the send queue
+	Vector<IDataSourceStream*> retainedStreams{0, 4};	///< Released streams which may still be referenced
+	bool referencePending = false;						///< Send queue contains data written by reference
 };
 
 /** @} */
@@ -29,9 +29,14 @@ bool UdpConnection::initialize(udp_pcb* pcb)
 
 void UdpConnection::close()
 {
+	if(udp == nullptr) {
+		return;
+	}
+
 	udp_recv(udp, nullptr, nullptr);
 	udp_remove(udp);
 	udp = nullptr;
+	// Receive buffer is kept as a callback may still be using it
 }
 
 bool UdpConnection::listen(int port)
@@ -93,17 +98,149 @@ bool UdpConnection::sendTo(IpAddress remoteIP, uint16_t remotePort, const char*
 	}
 }
 
+bool UdpConnection::sendPacket(pbuf* p)
+{
+	if(p == nullptr) {
+		return false;
+	}
+
+	err_t res = udp_send(udp, p);
+	return res == ERR_OK;
+}
+
+bool UdpConnection::sendPacketTo(IpAddress remoteIP, uint16_t remotePort, pbuf* p)
+{
+	if(p == nullptr) {
+		return false;
+	}
+
+	err_t res = udp_sendto(udp, p, remoteIP, remotePort);
+	return res == ERR_OK;
+}
+
+bool UdpConnection::sendPacket(UdpPacketBuilder& packet)
+{
+	bool res = sendPacket(packet.getPbuf());
+	packet.sent();
+	return res;
+}
+
+bool UdpConnection::sendPacketTo(IpAddress remoteIP, uint16_t remotePort, UdpPacketBuilder& packet)
+{
+	bool res = sendPacketTo(remoteIP, remotePort, packet.getPbuf());
+	packet.sent();
+	return res;
+}
+
+pbuf* UdpConnection::createRef(const void* data, size_t length)
+{
+#ifdef ARCH_HOST
+	/*
+	 * The tap driver copies outgoing frames before returning,
+	 * and lwIP copies referenced data if it has to queue the packet (e.g. pending ARP resolution).
+	 */
+	pbuf* p = pbuf_alloc(PBUF_RAW, length, PBUF_REF);
+	if(p != nullptr) {
+		p->payload = const_cast<void*>(data);
+	}
+#else
+	// Network drivers may hold on to outgoing buffers until transmission completes, so caller memory must be copied
+	pbuf* p = pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
+	if(p != nullptr) {
+		memcpy(p->payload, data, length);
+	}
+#endif
+	return p;
+}
+
+void UdpConnection::releaseRef(pbuf* p)
+{
+	if(p != nullptr) {
+		pbuf_free(p);
+	}
+}
+
+bool UdpConnection::sendNoCopy(const void* data, size_t length)
+{
+	pbuf* p = createRef(data, length);
+	bool res = sendPacket(p);
+	releaseRef(p);
+	return res;
+}
+
+bool UdpConnection::sendToNoCopy(IpAddress remoteIP, uint16_t remotePort, const void* data, size_t length)
+{
+	pbuf* p = createRef(data, length);
+	bool res = sendPacketTo(remoteIP, remotePort, p);
+	releaseRef(p);
+	return res;
+}
+
+unsigned UdpConnection::sendToMany(const UdpDestination* destinations, unsigned count, const void* data,
+								   size_t length)
+{
+	/*
+	 * The payload has no room for headers, so lwIP chains a separate header buffer
+	 * for each datagram and leaves the payload untouched.
+	 */
+	pbuf* p = createRef(data, length);
+	if(p == nullptr) {
+		return 0;
+	}
+
+	unsigned sent{0};
+	for(unsigned i = 0; i < count; ++i) {
+		auto& dest = destinations[i];
+		if(sendPacketTo(dest.ip, dest.port, p)) {
+			++sent;
+		}
+	}
+	releaseRef(p);
+
+	debug_d("UDP sent %u of %u datagrams", sent, count);
+	return sent;
+}
+
+unsigned UdpConnection::sendToMany(const UdpDestination* destinations, unsigned count, UdpPacketBuilder& packet)
+{
+	unsigned sent{0};
+	if(packet.length() != 0) {
+		sent = sendToMany(destinations, count, packet.getBuffer(), packet.length());
+	}
+	packet.clear();
+	return sent;
+}
+
+char* UdpConnection::getReceiveBuffer(size_t size)
+{
+	if(size > receiveBufferSize) {
+		// Round up to reduce re-allocation as datagram sizes vary
+		size = (size + 31) & ~31U;
+		receiveBuffer.reset(new char[size]);
+		receiveBufferSize = receiveBuffer ? size : 0;
+	}
+	return receiveBuffer.get();
+}
+
 void UdpConnection::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
 	debug_d("UDP received: %d bytes", buf->tot_len);
+	if(onPacketCallback) {
+		UdpPacket packet(*this, buf, remoteIP, remotePort);
+		onPacketCallback(*this, packet);
+		return;
+	}
+
 	if(onDataCallback) {
-		auto data = new char[buf->tot_len + 1];
+		auto data = getReceiveBuffer(buf->tot_len + 1);
+		if(data == nullptr) {
+			debug_e("UDP out of memory");
+			return;
+		}
 		pbuf_copy_partial(buf, data, buf->tot_len, 0);
 		data[buf->tot_len] = '\0';
 
 		onDataCallback(*this, data, buf->tot_len, remoteIP, remotePort);
-
-		delete[] data;
 	}
 }
 
@@ -117,6 +254,19 @@ void UdpConnection::staticOnReceive(void* arg, struct udp_pcb*, struct pbuf* p,
 	pbuf_free(p);
 }
 
+const char* UdpPacket::getData()
+{
+	if(isContiguous()) {
+		return static_cast<const char*>(buf->payload);
+	}
+
+	auto data = connection.getReceiveBuffer(buf->tot_len);
+	if(data != nullptr) {
+		pbuf_copy_partial(buf, data, buf->tot_len, 0);
+	}
+	return data;
+}
+
 bool UdpConnection::setMulticast([[maybe_unused]] IpAddress ip)
 {
 #if LWIP_MULTICAST_TX_OPTIONS
@@ -11,7 +11,10 @@
 #pragma once
 
 #include <Network/IpConnection.h>
+#include <Network/UdpPacket.h>
+#include <Network/UdpPacketBuilder.h>
 #include <lwip/udp.h>
+#include <memory>
 
 /** @defgroup   udp UDP
  *  @brief      Provides base for UDP clients or services
@@ -21,9 +24,24 @@
 
 class UdpConnection;
 
+/**
+ * @brief Address and port of a datagram recipient
+ */
+struct UdpDestination {
+	IpAddress ip;
+	uint16_t port;
+};
+
 using UdpConnectionDataDelegate =
 	Delegate<void(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort)>;
 
+/**
+ * @brief Delegate for receiving datagrams without copying
+ * @param connection The receiving connection
+ * @param packet View of the datagram, valid only for the duration of the call
+ */
+using UdpConnectionPacketDelegate = Delegate<void(UdpConnection& connection, UdpPacket& packet)>;
+
 class UdpConnection : public IpConnection
 {
 public:
@@ -37,6 +55,11 @@ public:
 		initialize();
 	}
 
+	UdpConnection(UdpConnectionPacketDelegate packetHandler) : onPacketCallback(packetHandler)
+	{
+		initialize();
+	}
+
 	virtual ~UdpConnection()
 	{
 		close();
@@ -71,6 +94,60 @@ public:
 		return sendTo(remoteIP, remotePort, data.c_str(), data.length());
 	}
 
+	/**
+	 * @name Send a prepared lwIP buffer without copying
+	 * @param p Buffer to send. Ownership remains with the caller.
+	 * @retval bool true on success
+	 * @note lwIP prepends protocol headers to `p` in place, so it must not be re-sent.
+	 * Use a `UdpPacketBuilder` for re-usable buffers.
+	 * @{
+	 */
+	bool sendPacket(pbuf* p);
+	bool sendPacketTo(IpAddress remoteIP, uint16_t remotePort, pbuf* p);
+	/** @} */
+
+	/**
+	 * @name Send content of a packet builder
+	 * @param packet The builder is cleared after sending, ready for re-use
+	 * @retval bool true on success
+	 * @{
+	 */
+	bool sendPacket(UdpPacketBuilder& packet);
+	bool sendPacketTo(IpAddress remoteIP, uint16_t remotePort, UdpPacketBuilder& packet);
+	/** @} */
+
+	/**
+	 * @name Send data by reference
+	 * @param data Content to send, must remain valid until the call returns
+	 * @param length Number of bytes to send
+	 * @retval bool true on success
+	 *
+	 * On Host, data is referenced by a `PBUF_REF` buffer rather than copied.
+	 * lwIP allocates a separate header buffer, so this is best suited to larger datagrams.
+	 * If a datagram has to be queued, e.g. pending ARP resolution, lwIP takes a copy so the data need not persist.
+	 *
+	 * @note Network drivers on other architectures may hold on to buffers until transmission completes,
+	 * so there the data is copied.
+	 * @{
+	 */
+	bool sendNoCopy(const void* data, size_t length);
+	bool sendToNoCopy(IpAddress remoteIP, uint16_t remotePort, const void* data, size_t length);
+	/** @} */
+
+	/**
+	 * @name Send the same datagram to several recipients
+	 * @param destinations List of recipients
+	 * @param count Number of recipients
+	 * @retval unsigned Number of datagrams successfully sent
+	 *
+	 * A single payload buffer referencing the content is shared by all datagrams.
+	 * Data must remain valid until the call returns: see `sendNoCopy()`.
+	 * @{
+	 */
+	unsigned sendToMany(const UdpDestination* destinations, unsigned count, const void* data, size_t length);
+	unsigned sendToMany(const UdpDestination* destinations, unsigned count, UdpPacketBuilder& packet);
+	/** @} */
+
 	/**
 	 * @brief Sets the UDP multicast IP.
 	 * @param ip
@@ -92,16 +169,45 @@ public:
 	 */
 	bool setMulticastTtl(size_t ttl);
 
+	/**
+	 * @brief Set delegate to receive datagrams without copying
+	 *
+	 * Takes precedence over any data delegate passed to the constructor.
+	 */
+	void setPacketCallback(UdpConnectionPacketDelegate packetHandler)
+	{
+		onPacketCallback = packetHandler;
+	}
+
 protected:
 	virtual void onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort);
 
+	/**
+	 * @brief Get buffer for working on received data
+	 * @param size Number of bytes required
+	 * @retval char* nullptr if allocation failed
+	 *
+	 * The buffer is retained and re-used for subsequent packets, growing as required.
+	 * It is released when the connection is destroyed, so remains valid if a callback closes the connection.
+	 */
+	char* getReceiveBuffer(size_t size);
+
 protected:
 	bool initialize(udp_pcb* pcb = nullptr);
+	static pbuf* createRef(const void* data, size_t length);
+	static void releaseRef(pbuf* p);
 	static void staticOnReceive(void* arg, struct udp_pcb* pcb, struct pbuf* p, LWIP_IP_ADDR_T* addr, u16_t port);
 
 protected:
 	udp_pcb* udp = nullptr;
 	UdpConnectionDataDelegate onDataCallback = nullptr;
+	UdpConnectionPacketDelegate onPacketCallback = nullptr;
+
+private:
+	friend class UdpPacket;
+
+	std::unique_ptr<char[]> receiveBuffer;
+	size_t receiveBufferSize{0};
 };
 
 /** @} */
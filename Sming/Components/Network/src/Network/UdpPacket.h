@@ -0,0 +1,169 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * UdpPacket.h
+ *
+ ****/
+
+#pragma once
+
+#include <IpAddress.h>
+#include <lwip/pbuf.h>
+
+class UdpConnection;
+
+/**
+ * @brief Read-only view of a received UDP datagram
+ *
+ * The datagram remains in the lwIP buffer chain it arrived in and is only valid for the
+ * duration of the receive callback. Nothing is copied unless the handler asks for it.
+ *
+ * Datagrams usually arrive in a single buffer, in which case `getPayload()` gives direct access.
+ * Chained datagrams may be walked segment by segment, read in pieces using `read()`, or obtained
+ * as contiguous data using `getData()`, which copies into a buffer owned by the connection.
+ *
+ * @ingroup udp
+ */
+class UdpPacket
+{
+public:
+	/**
+	 * @brief A contiguous section of datagram content
+	 */
+	struct Segment {
+		const char* data;
+		uint16_t length;
+	};
+
+	class Iterator
+	{
+	public:
+		Iterator(const pbuf* buf) : buf(buf)
+		{
+		}
+
+		Segment operator*() const
+		{
+			return Segment{static_cast<const char*>(buf->payload), buf->len};
+		}
+
+		Iterator& operator++()
+		{
+			buf = (buf->len == buf->tot_len) ? nullptr : buf->next;
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const
+		{
+			return buf == other.buf;
+		}
+
+		bool operator!=(const Iterator& other) const
+		{
+			return buf != other.buf;
+		}
+
+	private:
+		const pbuf* buf;
+	};
+
+	UdpPacket(UdpConnection& connection, pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
+		: connection(connection), buf(buf), remoteIP(remoteIP), remotePort(remotePort)
+	{
+	}
+
+	IpAddress getRemoteIP() const
+	{
+		return remoteIP;
+	}
+
+	uint16_t getRemotePort() const
+	{
+		return remotePort;
+	}
+
+	/**
+	 * @brief Get total length of the datagram
+	 */
+	size_t length() const
+	{
+		return buf->tot_len;
+	}
+
+	/**
+	 * @brief Determine if content is held in a single buffer
+	 */
+	bool isContiguous() const
+	{
+		return buf->len == buf->tot_len;
+	}
+
+	/**
+	 * @brief Get direct access to content
+	 * @retval const char* nullptr if content is chained
+	 */
+	const char* getPayload() const
+	{
+		return isContiguous() ? static_cast<const char*>(buf->payload) : nullptr;
+	}
+
+	/**
+	 * @brief Get content as a single block, copying only if it is chained
+	 * @retval const char* nullptr if a buffer could not be allocated
+	 * @note The copy is held in a buffer owned by the connection which is re-used for subsequent packets
+	 */
+	const char* getData();
+
+	/**
+	 * @brief Copy part of the content
+	 * @param offset Position in datagram to start reading from
+	 * @param buffer Where to write content
+	 * @param length Maximum number of bytes to read
+	 * @retval size_t Number of bytes read
+	 */
+	size_t read(size_t offset, void* buffer, size_t length) const
+	{
+		return pbuf_copy_partial(buf, buffer, length, offset);
+	}
+
+	/**
+	 * @brief Get a single byte of content, 0 if offset is out of range
+	 */
+	uint8_t operator[](size_t offset) const
+	{
+		return pbuf_get_at(buf, offset);
+	}
+
+	/**
+	 * @name Iterate over content segments
+	 * @{
+	 */
+	Iterator begin() const
+	{
+		return Iterator(buf->tot_len == 0 ? nullptr : buf);
+	}
+
+	Iterator end() const
+	{
+		return Iterator(nullptr);
+	}
+	/** @} */
+
+	/**
+	 * @brief Get the underlying lwIP buffer
+	 * @note Use `pbuf_ref()` to retain it beyond the receive callback
+	 */
+	pbuf* getPbuf() const
+	{
+		return buf;
+	}
+
+private:
+	UdpConnection& connection;
+	pbuf* buf; ///< Older lwIP versions lack const-correct accessors
+	IpAddress remoteIP;
+	uint16_t remotePort;
+};
@@ -0,0 +1,96 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * UdpPacketBuilder.cpp
+ *
+ ****/
+
+#include "UdpPacketBuilder.h"
+#include <lwip/pbuf.h>
+#include <debug_progmem.h>
+
+UdpPacketBuilder::~UdpPacketBuilder()
+{
+	if(buf != nullptr) {
+		pbuf_free(buf);
+	}
+}
+
+char* UdpPacketBuilder::getBuffer()
+{
+	if(buf == nullptr) {
+		buf = pbuf_alloc(PBUF_TRANSPORT, bufferCapacity, PBUF_RAM);
+		if(buf == nullptr) {
+			debug_e("UDP packet alloc failed (%u bytes)", bufferCapacity);
+			return nullptr;
+		}
+		payload = static_cast<char*>(buf->payload);
+	}
+
+	return payload;
+}
+
+size_t UdpPacketBuilder::write(const uint8_t* data, size_t size)
+{
+	auto buffer = getBuffer();
+	if(buffer == nullptr) {
+		overflow = true;
+		return 0;
+	}
+
+	size_t space = bufferCapacity - contentLength;
+	if(size > space) {
+		overflow = true;
+		size = space;
+	}
+	memcpy(&buffer[contentLength], data, size);
+	contentLength += size;
+	return size;
+}
+
+bool UdpPacketBuilder::setLength(size_t length)
+{
+	if(length > bufferCapacity) {
+		return false;
+	}
+
+	contentLength = length;
+	return true;
+}
+
+void UdpPacketBuilder::clear()
+{
+	contentLength = 0;
+	overflow = false;
+}
+
+pbuf* UdpPacketBuilder::getPbuf()
+{
+	if(buf == nullptr || contentLength == 0) {
+		return nullptr;
+	}
+
+	// Trim without releasing memory so buffer can be re-used
+	buf->len = buf->tot_len = contentLength;
+	return buf;
+}
+
+void UdpPacketBuilder::sent()
+{
+	if(buf != nullptr) {
+		if(buf->ref > 1) {
+			// Still queued by lwIP, so release our reference and allocate another when required
+			pbuf_free(buf);
+			buf = nullptr;
+			payload = nullptr;
+		} else {
+			// Drop headers added during transmission
+			buf->payload = payload;
+		}
+	}
+
+	clear();
+}
@@ -0,0 +1,104 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * UdpPacketBuilder.h
+ *
+ ****/
+
+#pragma once
+
+#include <Print.h>
+
+struct pbuf;
+
+/**
+ * @brief Builds an outgoing UDP datagram directly in a network buffer
+ *
+ * Content is written using the usual `Print` methods, or directly via `getBuffer()`.
+ * Room is reserved for protocol headers so the buffer is passed to lwIP without copying.
+ *
+ * After sending, the builder is cleared and its buffer re-used for the next datagram,
+ * unless lwIP or the network driver is still holding on to it (e.g. pending ARP resolution,
+ * or awaiting transmission by the network driver) in which case a new one is allocated.
+ *
+ * @ingroup udp
+ */
+class UdpPacketBuilder : public Print
+{
+public:
+	/**
+	 * @brief Create a builder
+	 * @param capacity Maximum size of datagram. Buffer is allocated on first use.
+	 */
+	UdpPacketBuilder(uint16_t capacity) : bufferCapacity(capacity)
+	{
+	}
+
+	UdpPacketBuilder(const UdpPacketBuilder&) = delete;
+	UdpPacketBuilder& operator=(const UdpPacketBuilder&) = delete;
+
+	~UdpPacketBuilder();
+
+	size_t write(uint8_t c) override
+	{
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t* data, size_t size) override;
+
+	using Print::write;
+
+	/**
+	 * @brief Get direct access to the datagram content
+	 * @retval char* nullptr if buffer allocation failed
+	 * @note Call `setLength()` after writing content directly
+	 */
+	char* getBuffer();
+
+	/**
+	 * @brief Set length of content, e.g. after writing via `getBuffer()`
+	 * @retval bool false if length exceeds capacity
+	 */
+	bool setLength(size_t length);
+
+	size_t length() const
+	{
+		return contentLength;
+	}
+
+	size_t capacity() const
+	{
+		return bufferCapacity;
+	}
+
+	/**
+	 * @brief Determine if any content was discarded because the datagram was full
+	 */
+	bool isOverflow() const
+	{
+		return overflow;
+	}
+
+	/**
+	 * @brief Discard content, keeping the buffer for re-use
+	 */
+	void clear();
+
+private:
+	friend class UdpConnection;
+
+	// Get buffer trimmed to content length, ready for sending
+	pbuf* getPbuf();
+
+	// Called after getPbuf() has been sent, as lwIP prepends headers in-place
+	void sent();
+
+	pbuf* buf{nullptr};
+	char* payload{nullptr};
+	uint16_t bufferCapacity;
+	uint16_t contentLength{0};
+	bool overflow{false};
+};
@@ -13,6 +13,10 @@
 #include <esp_spi_flash.h>
 #include <debug_progmem.h>
 
+#ifdef ARCH_HOST
+#include <spi_flash/flashmem.h>
+#endif
+
 namespace Storage
 {
 DEFINE_FSTR(FS_SPIFLASH, "spiFlash")
@@ -69,4 +73,11 @@ bool SpiFlash::erase_range(storage_size_t address, storage_size_t size)
 	return true;
 }
 
+#ifdef ARCH_HOST
+bool SpiFlash::sync()
+{
+	return host_flashmem_sync();
+}
+#endif
+
 } // namespace Storage
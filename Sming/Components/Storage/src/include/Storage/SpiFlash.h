@@ -41,6 +41,10 @@ public:
 	bool read(storage_size_t address, void* dst, size_t size) override;
 	bool write(storage_size_t address, const void* src, size_t size) override;
 	bool erase_range(storage_size_t address, storage_size_t size) override;
+
+#ifdef ARCH_HOST
+	bool sync() override;
+#endif
 };
 
 } // namespace Storage
@@ -31,22 +31,35 @@
 #include <netinet/in.h>
 #include <sys/ioctl.h>
 #include <netif/etharp.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
 extern "C" {
 #include <netif/tapif.h>
 }
-
-#ifdef __APPLE__
-#include <fcntl.h>
 #include <net/if_dl.h>
 // For some reason _ip_data from lwip/core/ip.c isn't found, so add it here.
 #include <lwip/ip.h>
 struct ip_globals ip_data;
+#else
+#include <linux/if_tun.h>
 #endif
 
 namespace
 {
 struct netif net_if;
 
+#ifndef __APPLE__
+// Limit packets processed per call so other tasks don't get starved
+constexpr unsigned maxInputPackets{16};
+
+// Largest ethernet frame, allowing for a VLAN tag
+constexpr size_t maxFrameSize{1518};
+
+int tapFd{-1}; ///< Non-blocking handle for tap device
+#endif
+
 void getMacAddress(const char* ifname, uint8_t hwaddr[6])
 {
 	memset(hwaddr, 0, 6);
@@ -135,6 +148,89 @@ bool getifaddr(struct lwip_net_config& netcfg)
 	freeifaddrs(list);
 	return res;
 }
+/*
+ * Minimal tap interface driver, as contrib tapif doesn't expose its file descriptor
+ */
+
+err_t tapOutput(struct netif*, struct pbuf* p)
+{
+	char buf[maxFrameSize];
+	if(p->tot_len > sizeof(buf)) {
+		return ERR_BUF;
+	}
+
+	auto len = pbuf_copy_partial(p, buf, p->tot_len, 0);
+	if(write(tapFd, buf, len) != ssize_t(len)) {
+		host_debug_w("tap write: %s", strerror(errno));
+		return ERR_IF;
+	}
+
+	return ERR_OK;
+}
+
+/*
+ * Read one packet and pass it to the stack.
+ * Return false if there is nothing to read.
+ */
+bool tapInput(struct netif* netif)
+{
+	char buf[maxFrameSize];
+	auto len = read(tapFd, buf, sizeof(buf));
+	if(len <= 0) {
+		return false;
+	}
+
+	auto p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+	if(p == nullptr) {
+		host_debug_w("%s", "tap: dropped packet");
+		return true;
+	}
+
+	pbuf_take(p, buf, len);
+	if(netif->input(p, netif) != ERR_OK) {
+		pbuf_free(p);
+	}
+	return true;
+}
+
+/*
+ * Attach to existing tap interface, name passed as state
+ */
+err_t tapInit(struct netif* netif)
+{
+	auto ifname = static_cast<const char*>(netif->state);
+	netif->state = nullptr;
+
+	int fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+	if(fd < 0) {
+		host_debug_e("/dev/net/tun: %s", strerror(errno));
+		return ERR_IF;
+	}
+
+	struct ifreq ifr {
+	};
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	if(ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		host_debug_e("Attach to '%s' failed: %s", ifname, strerror(errno));
+		close(fd);
+		return ERR_IF;
+	}
+
+	tapFd = fd;
+
+	netif->name[0] = 't';
+	netif->name[1] = 'p';
+	netif->output = etharp_output;
+	netif->linkoutput = tapOutput;
+	netif->mtu = 1500;
+	netif->hwaddr_len = 6;
+	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_IGMP;
+	netif_set_link_up(netif);
+
+	return ERR_OK;
+}
+
 #endif
 
 } // namespace
@@ -165,8 +261,6 @@ struct netif* lwip_arch_init(struct lwip_net_config& netcfg)
 		return nullptr;
 	}
 
-	setenv("PRECONFIGURED_TAPIF", netcfg.ifname, true);
-
 #endif
 
 	if(ip_addr_isany(&netcfg.ipaddr)) {
@@ -176,7 +270,14 @@ struct netif* lwip_arch_init(struct lwip_net_config& netcfg)
 	}
 
 	lwip_init();
+#ifdef __APPLE__
 	netif_add(&net_if, &netcfg.ipaddr, &netcfg.netmask, &netcfg.gw, nullptr, tapif_init, ethernet_input);
+#else
+	if(netif_add(&net_if, &netcfg.ipaddr, &netcfg.netmask, &netcfg.gw, netcfg.ifname, tapInit, ethernet_input) ==
+	   nullptr) {
+		return nullptr;
+	}
+#endif
 	getMacAddress(netcfg.ifname, net_if.hwaddr);
 
 	return &net_if;
@@ -185,13 +286,48 @@ struct netif* lwip_arch_init(struct lwip_net_config& netcfg)
 bool lwip_arch_service()
 {
 	/* poll netif, pass packet to lwIP */
-	int res = tapif_select(&net_if);
+#ifdef __APPLE__
+	bool res = tapif_select(&net_if) > 0;
+#else
+	bool res = tapFd >= 0 && tapInput(&net_if);
+#endif
+	netif_poll(&net_if);
+	sys_check_timeouts();
+
+	return res;
+}
+
+int lwip_arch_get_fd()
+{
+#ifdef __APPLE__
+	return -1;
+#else
+	return tapFd;
+#endif
+}
+
+bool lwip_arch_service_input()
+{
+#ifdef __APPLE__
+	return lwip_arch_service();
+#else
+	bool res{false};
+	for(unsigned i = 0; tapFd >= 0 && i < maxInputPackets && tapInput(&net_if); ++i) {
+		res = true;
+	}
 	netif_poll(&net_if);
 	sys_check_timeouts();
 
-	return res > 0;
+	return res;
+#endif
 }
 
 void lwip_arch_shutdown()
 {
+#ifndef __APPLE__
+	if(tapFd >= 0) {
+		close(tapFd);
+		tapFd = -1;
+	}
+#endif
 }
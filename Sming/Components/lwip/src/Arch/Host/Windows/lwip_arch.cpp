@@ -198,6 +198,16 @@ bool lwip_arch_service()
 	return true;
 }
 
+int lwip_arch_get_fd()
+{
+	return -1;
+}
+
+bool lwip_arch_service_input()
+{
+	return lwip_arch_service();
+}
+
 void lwip_arch_shutdown()
 {
 	/* release the pcap library... */
@@ -20,16 +20,60 @@
 #include "lwip_arch.h"
 #include "lwip/netif.h"
 #include <SimpleTimer.h>
+#include <Platform/System.h>
+#include <hostlib/reactor.h>
 
 namespace
 {
 SimpleTimer lwipServiceTimer;
 host_lwip_init_callback_t init_callback;
 
+int netifFd{-1}; ///< Set when interface is serviced by reactor
+
 // Service stack more frequently when busy to ensure decent throughput
 constexpr unsigned activeInterval{2};
 constexpr unsigned inactiveInterval{100};
 
+constexpr unsigned netifEvents{REACTOR_EVENT_READ | REACTOR_EVENT_ONESHOT};
+
+/*
+ * Called from main thread when packets have arrived
+ */
+void serviceInput()
+{
+	lwip_arch_service_input();
+	// Get notified of further packets
+	CReactor::instance()->modify(netifFd, netifEvents);
+}
+
+/*
+ * Called from reactor thread. Notification is one-shot, so the reactor doesn't
+ * report the interface again until main thread has serviced it.
+ */
+void netifReady(unsigned)
+{
+	auto reactor = CReactor::instance();
+	reactor->interrupt_begin();
+	System.queueCallback(serviceInput);
+	reactor->interrupt_end();
+}
+
+bool watchNetif()
+{
+	auto reactor = CReactor::instance();
+	int fd = lwip_arch_get_fd();
+	if(reactor == nullptr || fd < 0) {
+		return false;
+	}
+
+	if(!reactor->add(fd, netifEvents, netifReady)) {
+		return false;
+	}
+
+	netifFd = fd;
+	return true;
+}
+
 } // namespace
 
 bool host_lwip_init(const struct lwip_param& param)
@@ -80,6 +124,17 @@ bool host_lwip_init(const struct lwip_param& param)
 		init_callback();
 	}
 
+	if(watchNetif()) {
+		// Incoming packets are notified by reactor so timer need only service timeouts
+		lwipServiceTimer.initializeMs<inactiveInterval>([]() {
+			lwip_arch_service_input();
+			// In case task queue was full when last notified
+			CReactor::instance()->modify(netifFd, netifEvents);
+		});
+		lwipServiceTimer.start();
+		return true;
+	}
+
 	lwipServiceTimer.initializeMs(activeInterval, []() {
 		bool active = lwip_arch_service();
 		lwipServiceTimer.setIntervalMs(active ? activeInterval : inactiveInterval);
@@ -93,6 +148,13 @@ bool host_lwip_init(const struct lwip_param& param)
 void host_lwip_shutdown()
 {
 	lwipServiceTimer.stop();
+	if(netifFd >= 0) {
+		auto reactor = CReactor::instance();
+		if(reactor != nullptr) {
+			reactor->remove(netifFd);
+		}
+		netifFd = -1;
+	}
 	lwip_arch_shutdown();
 }
 
@@ -45,6 +45,18 @@ void lwip_arch_shutdown();
  */
 bool lwip_arch_service();
 
+/*
+ * Get file descriptor which becomes readable when packets arrive.
+ * Return -1 if not available, in which case the stack must be polled.
+ */
+int lwip_arch_get_fd();
+
+/*
+ * Process any pending packets without blocking, then service timeouts.
+ * Return true if data was processed, false otherwise.
+ */
+bool lwip_arch_service_input();
+
 #ifdef __cplusplus
 }
 #endif
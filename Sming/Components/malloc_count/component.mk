@@ -8,9 +8,15 @@ else
 ENABLE_MALLOC_COUNT ?= 1
 endif
 
+# Maximum number of allocation tags, including those used by the framework
+COMPONENT_VARS += MALLOC_COUNT_MAX_TAGS
+MALLOC_COUNT_MAX_TAGS ?= 16
+COMPONENT_CXXFLAGS += -DMALLOC_COUNT_MAX_TAGS=$(MALLOC_COUNT_MAX_TAGS)
+
 ifeq ($(ENABLE_MALLOC_COUNT),1)
 
-COMPONENT_CXXFLAGS += -DENABLE_MALLOC_COUNT=1
+# Framework code applies allocation tags when this is set
+GLOBAL_CFLAGS += -DENABLE_MALLOC_COUNT=1
 
 # Hook all the memory allocation functions we need to monitor heap activity
 MC_WRAP_FUNCS := \
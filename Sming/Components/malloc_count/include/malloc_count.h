@@ -30,8 +30,11 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <functional>
 
+class Print;
+
 namespace MallocCount
 {
 /**
@@ -93,4 +96,151 @@ void enableLogging(bool enable);
  */
 void setLogThreshold(size_t threshold);
 
+/**
+ * @name Tagged allocations
+ *
+ * Each allocation is attributed to the tag which is current when it is made.
+ * Tags are typically set for a subsystem using a `TagScope` guard.
+ * Reallocated and freed blocks are accounted against their original tag.
+ *
+ * @{
+ */
+
+/**
+ * @brief Identifies a subsystem for heap accounting
+ */
+using Tag = uint8_t;
+
+/**
+ * @brief Tags used by the framework
+ */
+namespace Tags
+{
+constexpr Tag untagged{0};
+constexpr Tag tcp{1};
+constexpr Tag http{2};
+constexpr Tag ssl{3};
+constexpr Tag mqtt{4};
+} // namespace Tags
+
+/**
+ * @brief Number of allocation size classes in tag histograms
+ *
+ * Bucket 0 counts allocations of up to 16 bytes, bucket 1 up to 32 bytes, and so on.
+ * The last bucket counts all larger allocations.
+ */
+constexpr unsigned histogramBuckets{8};
+
+struct TagStats {
+	size_t current;						///< Memory currently allocated
+	size_t peak;						///< Peak memory allocated
+	size_t count;						///< Number of allocations made
+	size_t histogram[histogramBuckets]; ///< Number of allocations made, by size
+};
+
+/**
+ * @brief Register an application tag
+ * @param name Must remain valid, e.g. a string literal
+ * @retval Tag Existing tag if already registered, `Tags::untagged` if there is no room
+ */
+Tag registerTag(const char* name);
+
+/**
+ * @brief Get number of tags in use, including framework tags
+ */
+unsigned getTagCount();
+
+/**
+ * @brief Get the name of a tag
+ * @retval const char* nullptr if tag is not registered
+ */
+const char* getTagName(Tag tag);
+
+/**
+ * @brief Set tag for subsequent allocations
+ * @retval Tag Previous tag
+ */
+Tag setTag(Tag tag);
+
+/**
+ * @brief Get tag currently applied to allocations
+ */
+Tag getTag();
+
+/**
+ * @brief Get statistics for a tag
+ */
+const TagStats& getTagStats(Tag tag);
+
+/**
+ * @brief Reset the peak allocation of all tags to current
+ */
+void resetTagPeaks();
+
+/**
+ * @brief Print statistics for all tags
+ * @param p Output, e.g. `Serial` or a stream for an HTTP response
+ * @param asJson Produce a JSON array instead of a text table
+ * @retval size_t Number of characters written
+ */
+size_t printTagStats(Print& p, bool asJson = false);
+
+/**
+ * @brief Apply a tag to allocations made within a scope
+ */
+class TagScope
+{
+public:
+	TagScope(Tag tag) : previous(setTag(tag))
+	{
+	}
+
+	~TagScope()
+	{
+		setTag(previous);
+	}
+
+	TagScope(const TagScope&) = delete;
+	TagScope& operator=(const TagScope&) = delete;
+
+private:
+	Tag previous;
+};
+
+#ifdef ARCH_HOST
+
+/**
+ * @brief Information about a current allocation
+ */
+struct AllocationInfo {
+	const void* ptr;	///< Address of allocated memory
+	size_t size;		///< Size requested
+	Tag tag;			///< Tag applied when allocated
+	const void* caller; ///< Address of code which made the (re-)allocation
+	size_t sequence;	///< Value of `getAllocCount()` when allocated, for ordering
+};
+
+using AllocationCallback = std::function<void(const AllocationInfo& info)>;
+
+/**
+ * @brief Host only: Enumerate current allocations, newest first
+ * @param callback Must not allocate or free memory
+ */
+void enumerateAllocations(AllocationCallback callback);
+
+/**
+ * @brief Host only: Print current allocations made after a given point
+ * @param p
+ * @param sequence Value of `getAllocCount()` at the start of the period of interest
+ * @param tag Only list allocations with this tag, or all if `Tags::untagged`
+ * @retval size_t Number of characters written
+ *
+ * Caller addresses may be resolved using `addr2line`.
+ */
+size_t printAllocations(Print& p, size_t sequence = 0, Tag tag = Tags::untagged);
+
+#endif
+
+/** @} */
+
 }; // namespace MallocCount
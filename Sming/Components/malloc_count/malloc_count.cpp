@@ -40,6 +40,18 @@
 #include "include/malloc_count.h"
 #include <debug_progmem.h>
 #include <esp_attr.h>
+#include <Print.h>
+#ifdef ARCH_HOST
+#include <atomic>
+#ifndef __WIN32
+#include <csignal>
+#include <pthread.h>
+#endif
+#endif
+
+#ifndef MALLOC_COUNT_MAX_TAGS
+#define MALLOC_COUNT_MAX_TAGS 16
+#endif
 
 // Names for the actual implementations
 #ifdef ARCH_ESP8266
@@ -77,9 +89,22 @@ size_t logThreshold{256};
 
 #ifdef ENABLE_MALLOC_COUNT
 
-/* to each allocation additional data is added for bookkeeping. due to
- * alignment requirements, we can optionally add more than just one integer. */
-constexpr size_t alignment{16}; /* bytes (>= 2*sizeof(size_t)) */
+/* Bookkeeping information immediately precedes each allocation */
+struct Header {
+#ifdef ARCH_HOST
+	// Host maintains a list of all allocations for leak checking
+	Header* prev;
+	Header* next;
+	const void* caller;
+	size_t sequence;
+#endif
+	size_t size;
+	MallocCount::Tag tag;
+	size_t sentinel; // Must be last
+};
+
+/* Padded to maintain alignment */
+constexpr size_t alignment{(sizeof(Header) + 15) & ~15};
 
 /* a sentinel value prefixed to each allocation */
 constexpr size_t sentinel{0xDEADC0DE};
@@ -90,10 +115,15 @@ template <typename T = void*> T offsetPointer(void* ptr, intptr_t offset)
 	return reinterpret_cast<T>(reinterpret_cast<intptr_t>(ptr) + offset);
 }
 
+Header* getHeader(void* ptr)
+{
+	return offsetPointer<Header*>(ptr, -sizeof(Header));
+}
+
 /* Get pointer to sentinel */
 size_t* getSentinel(void* ptr)
 {
-	return offsetPointer<size_t*>(ptr, -sizeof(size_t));
+	return &getHeader(ptr)->sentinel;
 }
 
 /* output */
@@ -123,10 +153,97 @@ size_t allocationLimit{0};
 
 MallocCount::Callback userCallback;
 
+/* per-tag statistics */
+const char* tagNames[MALLOC_COUNT_MAX_TAGS]{"untagged", "tcp", "http", "ssl", "mqtt"};
+MallocCount::TagStats tagStats[MALLOC_COUNT_MAX_TAGS];
+unsigned tagCount{MallocCount::Tags::mqtt + 1};
+#ifdef ARCH_HOST
+// Other threads may allocate whilst the main thread has a tag applied
+thread_local MallocCount::Tag currentTag{MallocCount::Tags::untagged};
+#else
+MallocCount::Tag currentTag{MallocCount::Tags::untagged};
+#endif
+
 #ifdef ENABLE_MALLOC_COUNT
 
+#ifdef ARCH_HOST
+
+Header* allocationList;
+std::atomic_flag listLock = ATOMIC_FLAG_INIT;
+
+/*
+ * Interrupts are emulated by suspending the main thread from a signal handler.
+ * If that happened whilst it held this lock, any allocation made by interrupt code would spin forever.
+ * Signals are therefore blocked whilst the lock is held, so suspension is deferred until it has been released.
+ */
+class ListLock
+{
+public:
+	ListLock()
+	{
+#ifndef __WIN32
+		sigset_t set;
+		sigfillset(&set);
+		pthread_sigmask(SIG_BLOCK, &set, &previousMask);
+#endif
+		while(listLock.test_and_set(std::memory_order_acquire)) {
+		}
+	}
+
+	~ListLock()
+	{
+		listLock.clear(std::memory_order_release);
+#ifndef __WIN32
+		pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+#endif
+	}
+
+	ListLock(const ListLock&) = delete;
+	ListLock& operator=(const ListLock&) = delete;
+
+private:
+#ifndef __WIN32
+	sigset_t previousMask;
+#endif
+};
+
+void listAdd(Header* hdr)
+{
+	ListLock lock;
+	hdr->prev = nullptr;
+	hdr->next = allocationList;
+	if(allocationList != nullptr) {
+		allocationList->prev = hdr;
+	}
+	allocationList = hdr;
+}
+
+void listRemove(Header* hdr)
+{
+	ListLock lock;
+	if(hdr->prev == nullptr) {
+		allocationList = hdr->next;
+	} else {
+		hdr->prev->next = hdr->next;
+	}
+	if(hdr->next != nullptr) {
+		hdr->next->prev = hdr->prev;
+	}
+}
+
+#endif
+
+unsigned getBucket(size_t size)
+{
+	unsigned bucket{0};
+	for(size_t limit = 16; bucket < MallocCount::histogramBuckets - 1 && size > limit; limit <<= 1) {
+		++bucket;
+	}
+	return bucket;
+}
+
 /* add allocation to statistics */
-void inc_count(size_t inc)
+void inc_count(size_t inc, MallocCount::Tag tag)
 {
 	stats.current += inc;
 	stats.total += inc;
@@ -135,15 +252,24 @@ void inc_count(size_t inc)
 	}
 	++stats.count;
 
+	auto& ts = tagStats[tag];
+	ts.current += inc;
+	if(ts.current > ts.peak) {
+		ts.peak = ts.current;
+	}
+	++ts.count;
+	++ts.histogram[getBucket(inc)];
+
 	if(userCallback) {
 		userCallback(stats.current);
 	}
 }
 
 /* decrement allocation to statistics */
-void dec_count(size_t dec)
+void dec_count(size_t dec, MallocCount::Tag tag)
 {
 	stats.current -= dec;
+	tagStats[tag].current -= dec;
 	if(userCallback) {
 		userCallback(stats.current);
 	}
@@ -211,13 +337,168 @@ void setCallback(Callback callback)
 	userCallback = std::move(callback);
 }
 
+Tag registerTag(const char* name)
+{
+	for(unsigned i = 0; i < tagCount; ++i) {
+		if(strcmp(tagNames[i], name) == 0) {
+			return i;
+		}
+	}
+	if(tagCount >= MALLOC_COUNT_MAX_TAGS) {
+		return Tags::untagged;
+	}
+	tagNames[tagCount] = name;
+	return tagCount++;
+}
+
+unsigned getTagCount()
+{
+	return tagCount;
+}
+
+const char* getTagName(Tag tag)
+{
+	return (tag < tagCount) ? tagNames[tag] : nullptr;
+}
+
+Tag setTag(Tag tag)
+{
+	auto previous = currentTag;
+	currentTag = (tag < tagCount) ? tag : Tags::untagged;
+	return previous;
+}
+
+Tag getTag()
+{
+	return currentTag;
+}
+
+const TagStats& getTagStats(Tag tag)
+{
+	return tagStats[(tag < tagCount) ? tag : Tags::untagged];
+}
+
+void resetTagPeaks()
+{
+	for(auto& ts : tagStats) {
+		ts.peak = ts.current;
+	}
+}
+
+size_t printTagStats(Print& p, bool asJson)
+{
+	size_t n{0};
+	if(asJson) {
+		n += p.print('[');
+	} else {
+		n += p.println(_F("Tag             Current      Peak     Count  Histogram (<=16, 32, 64, ...)"));
+	}
+	for(unsigned tag = 0; tag < tagCount; ++tag) {
+		auto& ts = tagStats[tag];
+		if(asJson) {
+			if(tag != 0) {
+				n += p.print(',');
+			}
+			n += p.print(_F("{\"tag\":\""));
+			n += p.print(tagNames[tag]);
+			n += p.print(_F("\",\"current\":"));
+			n += p.print(ts.current);
+			n += p.print(_F(",\"peak\":"));
+			n += p.print(ts.peak);
+			n += p.print(_F(",\"count\":"));
+			n += p.print(ts.count);
+			n += p.print(_F(",\"histogram\":["));
+			for(unsigned i = 0; i < histogramBuckets; ++i) {
+				if(i != 0) {
+					n += p.print(',');
+				}
+				n += p.print(ts.histogram[i]);
+			}
+			n += p.print(_F("]}"));
+		} else {
+			char buf[64];
+			m_snprintf(buf, sizeof(buf), _F("%-12s %10u %9u %9u "), tagNames[tag], unsigned(ts.current), unsigned(ts.peak),
+					   unsigned(ts.count));
+			n += p.print(buf);
+			for(unsigned i = 0; i < histogramBuckets; ++i) {
+				n += p.print(' ');
+				n += p.print(ts.histogram[i]);
+			}
+			n += p.println();
+		}
+	}
+	if(asJson) {
+		n += p.print(']');
+	}
+	return n;
+}
+
+#ifdef ARCH_HOST
+
+void enumerateAllocations(AllocationCallback callback)
+{
+#ifdef ENABLE_MALLOC_COUNT
+	ListLock lock;
+	for(auto hdr = allocationList; hdr != nullptr; hdr = hdr->next) {
+		callback(AllocationInfo{offsetPointer(hdr, sizeof(Header)), hdr->size, hdr->tag, hdr->caller, hdr->sequence});
+	}
+#else
+	(void)callback;
+#endif
+}
+
+size_t printAllocations(Print& p, size_t sequence, Tag tag)
+{
+	// Printing may allocate, so take a snapshot first
+	constexpr unsigned maxItems{100};
+	AllocationInfo items[maxItems];
+	unsigned count{0};
+	unsigned total{0};
+	size_t size{0};
+#ifdef ENABLE_MALLOC_COUNT
+	{
+		ListLock lock;
+		for(auto hdr = allocationList; hdr != nullptr; hdr = hdr->next) {
+			if(hdr->sequence < sequence || (tag != Tags::untagged && hdr->tag != tag)) {
+				continue;
+			}
+			++total;
+			size += hdr->size;
+			if(count < maxItems) {
+				items[count++] =
+					AllocationInfo{offsetPointer(hdr, sizeof(Header)), hdr->size, hdr->tag, hdr->caller, hdr->sequence};
+			}
+		}
+	}
+#endif
+
+	size_t n{0};
+	for(unsigned i = 0; i < count; ++i) {
+		auto& info = items[i];
+		char buf[100];
+		m_snprintf(buf, sizeof(buf), _F("#%u %p %u bytes, tag %s, caller %p"), unsigned(info.sequence), info.ptr,
+				   unsigned(info.size), tagNames[info.tag], info.caller);
+		n += p.println(buf);
+	}
+	if(count < total) {
+		n += p.print(_F("..."));
+	}
+	n += p.print(total);
+	n += p.print(_F(" allocations, "));
+	n += p.print(size);
+	n += p.println(_F(" bytes"));
+	return n;
+}
+
+#endif // ARCH_HOST
+
 #ifdef ENABLE_MALLOC_COUNT
 
 /****************************************************/
 /* malloc_count function implementations             */
 /****************************************************/
 
-extern "C" void* mc_malloc(size_t size)
+void* allocate(size_t size, [[maybe_unused]] const void* caller)
 {
 	if(size == 0) {
 		return nullptr;
@@ -237,11 +518,18 @@ extern "C" void* mc_malloc(size_t size)
 	}
 
 	/* prepend allocation size and check sentinel */
-	*static_cast<size_t*>(ret) = size;
 	ret = offsetPointer(ret, alignment);
-	*getSentinel(ret) = sentinel;
-
-	inc_count(size);
+	auto hdr = getHeader(ret);
+	hdr->size = size;
+	hdr->tag = currentTag;
+	hdr->sentinel = sentinel;
+
+	inc_count(size, hdr->tag);
+#ifdef ARCH_HOST
+	hdr->caller = caller;
+	hdr->sequence = stats.count;
+	listAdd(hdr);
+#endif
 	if(size >= logThreshold) {
 		log("malloc(%u) = %p (cur %u)", size, ret, stats.current);
 	}
@@ -249,9 +537,14 @@ extern "C" void* mc_malloc(size_t size)
 	return ret;
 }
 
+extern "C" void* mc_malloc(size_t size)
+{
+	return allocate(size, __builtin_return_address(0));
+}
+
 extern "C" void* mc_zalloc(size_t size)
 {
-	auto ptr = mc_malloc(size);
+	auto ptr = allocate(size, __builtin_return_address(0));
 	if(ptr != nullptr) {
 		memset(ptr, 0, size);
 	}
@@ -271,10 +564,14 @@ extern "C" void mc_free(void* ptr)
 		// ... or memory not allocated by our malloc()
 	} else {
 		*p_sentinel = 0; // Clear sentinel to avoid false-positives
+		auto hdr = getHeader(ptr);
+#ifdef ARCH_HOST
+		listRemove(hdr);
+#endif
 		ptr = offsetPointer(ptr, -alignment);
 
-		size_t size = *static_cast<size_t*>(ptr);
-		dec_count(size);
+		size_t size = hdr->size;
+		dec_count(size, hdr->tag);
 
 		if(size >= logThreshold) {
 			log("free(%p) -> %u (cur %u)", offsetPointer(ptr, alignment), size, stats.current);
@@ -286,7 +583,12 @@ extern "C" void mc_free(void* ptr)
 
 extern "C" void* mc_calloc(size_t nmemb, size_t size)
 {
-	return mc_zalloc(nmemb * size);
+	auto len = nmemb * size;
+	auto ptr = allocate(len, __builtin_return_address(0));
+	if(ptr != nullptr) {
+		memset(ptr, 0, len);
+	}
+	return ptr;
 }
 
 extern "C" void* mc_realloc(void* ptr, size_t size)
@@ -299,7 +601,7 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 
 	// special case ptr == 0 -> malloc()
 	if(ptr == nullptr) {
-		return mc_malloc(size);
+		return allocate(size, __builtin_return_address(0));
 	}
 
 	if(*getSentinel(ptr) != sentinel) {
@@ -314,19 +616,29 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 		return nullptr;
 	}
 
-	ptr = offsetPointer(ptr, -alignment);
+	auto hdr = getHeader(ptr);
+	size_t oldsize = hdr->size;
+	auto tag = hdr->tag;
 
-	size_t oldsize = *static_cast<size_t*>(ptr);
+#ifdef ARCH_HOST
+	// Block may move
+	listRemove(hdr);
+#endif
+
+	ptr = offsetPointer(ptr, -alignment);
 
 	void* newptr = REAL(F_REALLOC)(ptr, alignment + size);
 
 	if(newptr == nullptr) {
 		log("realloc(%u -> %u) failed", oldsize, size);
+#ifdef ARCH_HOST
+		listAdd(hdr);
+#endif
 		return nullptr;
 	}
 
-	dec_count(oldsize);
-	inc_count(size);
+	dec_count(oldsize, tag);
+	inc_count(size, tag);
 
 	if(size >= logThreshold) {
 		if(newptr == ptr) {
@@ -337,9 +649,16 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 		}
 	}
 
-	*static_cast<size_t*>(newptr) = size;
+	newptr = offsetPointer(newptr, alignment);
+	hdr = getHeader(newptr);
+	hdr->size = size;
+#ifdef ARCH_HOST
+	hdr->caller = __builtin_return_address(0);
+	hdr->sequence = stats.count;
+	listAdd(hdr);
+#endif
 
-	return offsetPointer(newptr, alignment);
+	return newptr;
 }
 
 static __attribute__((destructor)) void finish()
@@ -382,22 +701,22 @@ extern "C" void WRAP(vPortFree)(void*) __attribute__((alias("mc_free")));
 
 void* operator new(size_t size)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new(size_t size, const std::nothrow_t&) noexcept
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size, const std::nothrow_t&) noexcept
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void operator delete(void* ptr)
@@ -429,7 +748,7 @@ void operator delete[](void* ptr, size_t)
 extern "C" char* WRAP(strdup)(const char* s)
 {
 	auto len = strlen(s) + 1;
-	auto dup = static_cast<char*>(mc_malloc(len));
+	auto dup = static_cast<char*>(allocate(len, __builtin_return_address(0)));
 	memcpy(dup, s, len);
 	return dup;
 }
@@ -14,6 +14,7 @@
 #include <Network/TcpConnection.h>
 #include <Print.h>
 #include <Platform/Clocks.h>
+#include <MallocTag.h>
 
 namespace Ssl
 {
@@ -41,6 +42,7 @@ String Options::toString() const
 
 bool Session::onAccept(TcpConnection* client, tcp_pcb* tcp)
 {
+	MALLOC_TAG_SCOPE(ssl);
 	debug_i("SSL %p onAccept(%p, %p)", this, client, tcp);
 
 	if(!keyCert.isValid()) {
@@ -71,6 +73,7 @@ bool Session::onAccept(TcpConnection* client, tcp_pcb* tcp)
 
 bool Session::onConnect(tcp_pcb* tcp)
 {
+	MALLOC_TAG_SCOPE(ssl);
 	debug_d("SSL %p: Starting connection...", this);
 
 	assert(!connection);
@@ -143,6 +146,7 @@ void Session::close()
 
 int Session::read(InputBuffer& input, uint8_t*& output)
 {
+	MALLOC_TAG_SCOPE(ssl);
 	if(!connection) {
 		debug_w("SSL: no connection");
 		return -1;
@@ -162,6 +166,7 @@ int Session::read(InputBuffer& input, uint8_t*& output)
 
 int Session::write(const uint8_t* data, size_t length)
 {
+	MALLOC_TAG_SCOPE(ssl);
 	if(!connection) {
 		debug_e("!! SSL Session connection is NULL");
 		return ERR_CONN;
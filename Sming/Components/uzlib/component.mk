@@ -1,3 +1,8 @@
 COMPONENT_SUBMODULES := uzlib
-COMPONENT_INCDIRS := uzlib/src
-COMPONENT_SRCDIRS := uzlib/src
+COMPONENT_INCDIRS := uzlib/src src/include
+COMPONENT_SRCDIRS := uzlib/src src
+COMPONENT_DOXYGEN_INPUT := src/include
+
+COMPONENT_VARS += DEFLATE_STREAM_WINDOW_SIZE
+DEFLATE_STREAM_WINDOW_SIZE ?= 1024
+GLOBAL_CFLAGS += -DDEFLATE_STREAM_WINDOW_SIZE=$(DEFLATE_STREAM_WINDOW_SIZE)
@@ -0,0 +1,213 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DeflateStream.cpp
+ *
+ ****/
+
+#include "include/Data/Stream/DeflateStream.h"
+#include <debug_progmem.h>
+#include <algorithm>
+
+extern "C" {
+#include <uzlib.h>
+}
+
+namespace
+{
+// Deflate back-references cannot exceed 32768 bytes, which must cover history plus window
+constexpr size_t maxWindowSize{16384};
+constexpr size_t minWindowSize{64};
+
+// No file name or timestamp, XFL indicates fastest compression, OS unknown
+constexpr uint8_t gzipHeader[]{0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0xff};
+
+// 32K window, fastest compression, no preset dictionary
+constexpr uint8_t zlibHeader[]{0x78, 0x01};
+
+} // namespace
+
+DeflateStream::DeflateStream(IDataSourceStream* source, Format format, size_t windowSize)
+	: source(source), windowSize(std::max(std::min(windowSize, maxWindowSize), minWindowSize)), format(format)
+{
+	comp.reset(new uzlib_comp{});
+	buffer.reset(new uint8_t[2 * this->windowSize]);
+	if(!comp || !buffer) {
+		state = State::error;
+		return;
+	}
+
+	comp->hash_bits = DEFLATE_STREAM_HASH_BITS;
+	comp->dict_size = 2 * this->windowSize;
+	comp->hash_table = new uzlib_hash_entry_t[1U << DEFLATE_STREAM_HASH_BITS]{};
+
+	// Fixed Huffman codes expand literals by at most 9/8
+	auto& out = comp->out;
+	out.outsize = this->windowSize + this->windowSize / 8 + 32;
+	out.outbuf = static_cast<unsigned char*>(malloc(out.outsize));
+	if(comp->hash_table == nullptr || out.outbuf == nullptr) {
+		debug_e("[DEFLATE] Out of memory");
+		state = State::error;
+		return;
+	}
+
+	if(format == Format::gzip) {
+		writeRaw(gzipHeader, sizeof(gzipHeader));
+		checksum = ~0U;
+	} else {
+		writeRaw(zlibHeader, sizeof(zlibHeader));
+		checksum = 1;
+	}
+	zlib_start_block(&out);
+}
+
+DeflateStream::~DeflateStream()
+{
+	if(comp) {
+		delete[] comp->hash_table;
+		free(comp->out.outbuf);
+	}
+}
+
+bool DeflateStream::writeRaw(const void* data, size_t length)
+{
+	auto& out = comp->out;
+	size_t required = out.outlen + length;
+	if(required > size_t(out.outsize)) {
+		auto newBuffer = static_cast<unsigned char*>(realloc(out.outbuf, required));
+		if(newBuffer == nullptr) {
+			state = State::error;
+			return false;
+		}
+		out.outbuf = newBuffer;
+		out.outsize = required;
+	}
+	memcpy(&out.outbuf[out.outlen], data, length);
+	out.outlen += length;
+	return true;
+}
+
+void DeflateStream::produce()
+{
+	comp->out.outlen = 0;
+	outPos = 0;
+
+	if(state != State::body) {
+		return;
+	}
+
+	auto window = &buffer[historyLength];
+	size_t length{0};
+	while(length < windowSize) {
+		auto count = source->readMemoryBlock(reinterpret_cast<char*>(&window[length]), windowSize - length);
+		if(count == 0) {
+			break;
+		}
+		source->seek(count);
+		length += count;
+	}
+
+	if(length != 0) {
+		compressWindow(length);
+	}
+
+	if(source->isFinished()) {
+		finish();
+	}
+}
+
+void DeflateStream::compressWindow(size_t length)
+{
+	auto window = &buffer[historyLength];
+	uzlib_compress(comp.get(), window, length);
+	if(format == Format::gzip) {
+		checksum = uzlib_crc32(window, length, checksum);
+	} else {
+		checksum = uzlib_adler32(window, length, checksum);
+	}
+	inputLength += length;
+
+	// Retain the most recent input as history for the next window
+	size_t total = historyLength + length;
+	size_t keep = std::min(total, windowSize);
+	size_t shift = total - keep;
+	if(shift != 0) {
+		memmove(buffer.get(), &buffer[shift], keep);
+
+		// Hash entries point into the buffer so must move with it
+		auto limit = &buffer[shift];
+		auto table = comp->hash_table;
+		for(unsigned i = 0; i < (1U << DEFLATE_STREAM_HASH_BITS); ++i) {
+			if(table[i] != nullptr) {
+				table[i] = (table[i] < limit) ? nullptr : table[i] - shift;
+			}
+		}
+	}
+	historyLength = keep;
+}
+
+void DeflateStream::finish()
+{
+	auto& out = comp->out;
+	zlib_finish_block(&out);
+
+	// Discard padding bits left over from the final flush
+	out.outbits = 0;
+	out.noutbits = 0;
+
+	uint8_t trailer[8];
+	size_t length;
+	if(format == Format::gzip) {
+		uint32_t crc = ~checksum;
+		uint32_t size = inputLength;
+		for(unsigned i = 0; i < 4; ++i) {
+			trailer[i] = crc >> (i * 8);
+			trailer[4 + i] = size >> (i * 8);
+		}
+		length = 8;
+	} else {
+		for(unsigned i = 0; i < 4; ++i) {
+			trailer[i] = checksum >> (24 - i * 8);
+		}
+		length = 4;
+	}
+
+	if(writeRaw(trailer, length)) {
+		state = State::finished;
+	}
+	debug_d("[DEFLATE] Compressed %u bytes to %u", inputLength, outputLength + out.outlen);
+}
+
+uint16_t DeflateStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0 || !comp || state == State::error) {
+		return 0;
+	}
+
+	if(outPos == size_t(comp->out.outlen)) {
+		produce();
+	}
+
+	auto length = std::min(comp->out.outlen - outPos, size_t(bufSize));
+	memcpy(data, &comp->out.outbuf[outPos], length);
+	return length;
+}
+
+int DeflateStream::seekFrom(int offset, SeekOrigin origin)
+{
+	if(origin != SeekOrigin::Current || offset < 0 || !comp || size_t(offset) > comp->out.outlen - outPos) {
+		return -1;
+	}
+
+	outPos += offset;
+	outputLength += offset;
+	return outputLength;
+}
+
+bool DeflateStream::isFinished()
+{
+	return state == State::error || (state == State::finished && outPos == size_t(comp->out.outlen));
+}
@@ -0,0 +1,130 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DeflateStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/Stream/DataSourceStream.h>
+#include <memory>
+
+/**
+ * @brief Size of the history window used by DeflateStream
+ *
+ * RAM usage is approximately 3.2 times this value plus the hash table.
+ */
+#ifndef DEFLATE_STREAM_WINDOW_SIZE
+#define DEFLATE_STREAM_WINDOW_SIZE 1024
+#endif
+
+/**
+ * @brief Number of bits used to index the DeflateStream match hash table
+ */
+#ifndef DEFLATE_STREAM_HASH_BITS
+#define DEFLATE_STREAM_HASH_BITS 10
+#endif
+
+struct uzlib_comp;
+
+/**
+ * @brief Read-only stream which compresses the content of a source stream
+ *
+ * Output is generated on demand, a window of source data at a time, so RAM usage is fixed
+ * regardless of content length. Matches may refer back into the previous window.
+ *
+ * Content is encoded as a single block using fixed Huffman codes, which suits the
+ * highly repetitive text typical of JSON and HTML.
+ *
+ * The output length is not known in advance, so HTTP responses use chunked encoding.
+ *
+ * @ingroup stream data
+ */
+class DeflateStream : public IDataSourceStream
+{
+public:
+	enum class Format {
+		zlib, ///< RFC 1950, for HTTP `Content-Encoding: deflate`
+		gzip, ///< RFC 1952, for HTTP `Content-Encoding: gzip`
+	};
+
+	/**
+	 * @brief Create a compressing stream
+	 * @param source Stream providing uncompressed content. Owned by this object and destroyed with it.
+	 * @param format Header and trailer to wrap compressed data in
+	 * @param windowSize Amount of source data compressed at once, and number of bytes retained for back-references.
+	 * Must not exceed 16384.
+	 */
+	DeflateStream(IDataSourceStream* source, Format format = Format::gzip,
+				  size_t windowSize = DEFLATE_STREAM_WINDOW_SIZE);
+
+	~DeflateStream();
+
+	StreamType getStreamType() const override
+	{
+		return eSST_Transform;
+	}
+
+	bool isValid() const override
+	{
+		return state != State::error && source && source->isValid();
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	/**
+	 * @brief Only forward seeks within data already returned by `readMemoryBlock()` are supported
+	 */
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override;
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+	/**
+	 * @brief Get number of uncompressed bytes consumed from the source so far
+	 */
+	size_t getInputLength() const
+	{
+		return inputLength;
+	}
+
+	/**
+	 * @brief Get number of compressed bytes output so far
+	 */
+	size_t getOutputLength() const
+	{
+		return outputLength;
+	}
+
+private:
+	enum class State {
+		body,
+		finished,
+		error,
+	};
+
+	bool writeRaw(const void* data, size_t length);
+	void produce();
+	void compressWindow(size_t length);
+	void finish();
+
+	std::unique_ptr<IDataSourceStream> source;
+	std::unique_ptr<uzlib_comp> comp;
+	std::unique_ptr<uint8_t[]> buffer; ///< History followed by input window
+	size_t windowSize;
+	size_t historyLength{0};
+	size_t outPos{0}; ///< Read position in compressor output buffer
+	size_t inputLength{0};
+	size_t outputLength{0};
+	uint32_t checksum;
+	Format format;
+	State state{State::body};
+};
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "WVector.h"
+#include "WHashIndex.h"
 #include <memory>
 
 /**
@@ -44,8 +45,11 @@
  *	}
  * 	```
  *
+ * As with HashMap, specify a `Hash` function object such as `HashMapHash<K>`
+ * to index keys for faster lookups in larger maps.
+ *
  */
-template <typename K, typename V> class ObjectMap
+template <typename K, typename V, typename Hash = void> class ObjectMap : private wiring_private::HashIndex<K, Hash>
 {
 public:
 	ObjectMap() = default;
@@ -62,7 +66,7 @@ public:
 	class Value
 	{
 	public:
-		Value(ObjectMap<K, V>& map, const K& key) : map(map), key(key)
+		Value(ObjectMap& map, const K& key) : map(map), key(key)
 		{
 		}
 
@@ -112,7 +116,7 @@ public:
 		}
 
 	private:
-		ObjectMap<K, V>& map;
+		ObjectMap& map;
 		K key;
 	};
 
@@ -142,6 +146,9 @@ public:
 	 */
 	K& keyAt(unsigned idx)
 	{
+		// Key may be modified
+		hashIndex().invalidate();
+		++revision;
 		return entries[idx].key;
 	}
 
@@ -206,11 +213,12 @@ public:
 	 */
 	void set(const K& key, V* value)
 	{
-		int i = entries.indexOf(key);
+		int i = indexOf(key);
 		if(i >= 0) {
 			entries[i].value.reset(value);
-		} else {
-			entries.addElement(new Entry(key, value));
+		} else if(entries.addElement(new Entry(key, value))) {
+			hashIndex().add(entries.count() - 1, [this](unsigned i) -> const K& { return entries[i].key; });
+			++revision;
 		}
 	}
 
@@ -222,7 +230,7 @@ public:
 	 */
 	V* find(const K& key) const
 	{
-		int index = entries.indexOf(key);
+		int index = indexOf(key);
 		return (index < 0) ? nullptr : entries[index].value.get();
 	}
 
@@ -233,7 +241,9 @@ public:
 	 */
 	int indexOf(const K& key) const
 	{
-		return entries.indexOf(key);
+		return hashIndex().find(
+			key, entries.count(), [this](unsigned i) -> const K& { return entries[i].key; },
+			[](const K& key1, const K& key2) { return key1 == key2; });
 	}
 
 	/**
@@ -243,7 +253,7 @@ public:
 	 */
 	bool contains(const K& key) const
 	{
-		return entries.contains(key);
+		return indexOf(key) >= 0;
 	}
 
 	/**
@@ -253,6 +263,8 @@ public:
 	void removeAt(unsigned index)
 	{
 		entries.remove(index);
+		hashIndex().invalidate();
+		++revision;
 	}
 
 	/**
@@ -293,7 +305,7 @@ public:
 		std::unique_ptr<V> value;
 		if(index < entries.count()) {
 			entries[index].value.swap(value);
-			entries.remove(index);
+			removeAt(index);
 		}
 		return value.release();
 	}
@@ -304,6 +316,8 @@ public:
 	void clear()
 	{
 		entries.clear();
+		hashIndex().clear();
+		++revision;
 	}
 
 protected:
@@ -325,9 +339,32 @@ protected:
 		}
 	};
 
+	/**
+	 * @brief Get a value which changes whenever keys are added, removed or may have been modified
+	 * @note Allows derived classes to detect changes made via `Value`, which cannot be overridden
+	 */
+	unsigned getRevision() const
+	{
+		return revision;
+	}
+
 	Vector<Entry> entries;
 
 private:
+	using HashIndex = wiring_private::HashIndex<K, Hash>;
+
+	HashIndex& hashIndex()
+	{
+		return *this;
+	}
+
+	const HashIndex& hashIndex() const
+	{
+		return *this;
+	}
+
+	unsigned revision{0};
+
 	// Copy constructor unsafe, so prevent access
-	ObjectMap(ObjectMap<K, V>& that);
+	ObjectMap(ObjectMap& that);
 };
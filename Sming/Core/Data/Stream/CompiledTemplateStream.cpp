@@ -0,0 +1,421 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.cpp
+ *
+ ****/
+
+#include "CompiledTemplateStream.h"
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr uint32_t COMPILED_TEMPLATE_MAGIC{0x43504d54}; // "TMPC"
+
+// Must be able to hold the longest possible tag
+constexpr size_t COMPILE_BUFFER_SIZE{256};
+static_assert(COMPILE_BUFFER_SIZE > TEMPLATE_MAX_VAR_NAME_LEN + 4, "Compile buffer too small");
+
+struct FileHeader {
+	uint32_t magic;
+	uint32_t sourceLength;
+	uint32_t opCount;
+	uint32_t namesLength;
+};
+
+enum class TagResult {
+	none,	 ///< Not a tag
+	tag,	 ///< Valid tag
+	moreData ///< Cannot tell without more data
+};
+
+/*
+ * Check for a tag at `p`, which points to an opening brace.
+ * Follows the same rules as TemplateStream.
+ */
+TagResult parseTag(const char* p, size_t avail, bool eof, bool doubleBraces, size_t& nameLength, size_t& tagLength)
+{
+	const size_t delimLength = 1 + doubleBraces;
+	if(avail <= delimLength) {
+		return eof ? TagResult::none : TagResult::moreData;
+	}
+	if(doubleBraces) {
+		if(p[1] != '{') {
+			return TagResult::none;
+		}
+	} else if(p[1] <= ' ' || p[1] == '"') {
+		return TagResult::none;
+	}
+
+	auto name = p + delimLength;
+	auto maxLength = std::min(avail - delimLength, size_t(TEMPLATE_MAX_VAR_NAME_LEN + 1));
+	auto end = static_cast<const char*>(memchr(name, '}', maxLength));
+	if(end == nullptr) {
+		return (eof || maxLength > TEMPLATE_MAX_VAR_NAME_LEN) ? TagResult::none : TagResult::moreData;
+	}
+	nameLength = end - name;
+	if(nameLength == 0) {
+		return TagResult::none;
+	}
+
+	tagLength = end + 1 - p;
+	if(doubleBraces) {
+		// Double end brace isn't necessary, but if present skip it
+		if(tagLength == avail) {
+			if(!eof) {
+				return TagResult::moreData;
+			}
+		} else if(p[tagLength] == '}') {
+			++tagLength;
+		}
+	}
+
+	return TagResult::tag;
+}
+
+/*
+ * Variable names are case-sensitive, so `{Name}` and `{name}` are distinct
+ */
+int findName(const CStringArray& names, const char* name, size_t length)
+{
+	for(auto it = names.begin(); it != names.end(); ++it) {
+		auto s = *it;
+		if(strncmp(s, name, length) == 0 && s[length] == '\0') {
+			return it.index();
+		}
+	}
+
+	return -1;
+}
+
+} // namespace
+
+/* CompiledTemplate */
+
+void CompiledTemplate::clear()
+{
+	ops.reset();
+	opCount = 0;
+	opCapacity = 0;
+	names = nullptr;
+	srcLength = 0;
+}
+
+bool CompiledTemplate::addOp(uint32_t offset, size_t length, uint16_t id)
+{
+	if(opCount == opCapacity) {
+		auto newCapacity = std::max(opCapacity * 2, 16U);
+		auto newOps = new Op[newCapacity];
+		if(newOps == nullptr) {
+			return false;
+		}
+		if(opCount != 0) {
+			memcpy(newOps, ops.get(), opCount * sizeof(Op));
+		}
+		ops.reset(newOps);
+		opCapacity = newCapacity;
+	}
+
+	ops[opCount++] = Op{offset, uint16_t(length), id};
+	return true;
+}
+
+bool CompiledTemplate::addLiteral(uint32_t offset, size_t length)
+{
+	while(length != 0) {
+		auto len = std::min(length, size_t(0xffff));
+		if(!addOp(offset, len, literalId)) {
+			return false;
+		}
+		offset += len;
+		length -= len;
+	}
+	return true;
+}
+
+bool CompiledTemplate::compile(IDataSourceStream& source, bool doubleBraces)
+{
+	clear();
+
+	char buffer[COMPILE_BUFFER_SIZE];
+	size_t bufferOffset{0}; ///< Source position of buffer[0]
+	size_t length{0};		///< Bytes in buffer
+	size_t pos{0};			///< Scan position in buffer
+	size_t literalStart{0}; ///< Source position of current literal span
+	bool eof{false};
+
+	for(;;) {
+		if(!eof) {
+			auto count = source.readMemoryBlock(&buffer[length], sizeof(buffer) - length);
+			source.seek(count);
+			length += count;
+			eof = (count == 0) || source.isFinished();
+		}
+
+		size_t keep{length}; // Start of content to retain for next pass
+		while(pos < length) {
+			auto p = static_cast<const char*>(memchr(&buffer[pos], '{', length - pos));
+			if(p == nullptr) {
+				pos = length;
+				break;
+			}
+
+			size_t tagStart = p - buffer;
+			size_t nameLength;
+			size_t tagLength;
+			auto res = parseTag(p, length - tagStart, eof, doubleBraces, nameLength, tagLength);
+			if(res == TagResult::moreData) {
+				keep = tagStart;
+				break;
+			}
+			if(res == TagResult::none) {
+				pos = tagStart + 1;
+				continue;
+			}
+
+			auto name = p + 1 + doubleBraces;
+			int id = findName(names, name, nameLength);
+			if(id < 0) {
+				id = names.count();
+				if(id >= literalId || !names.add(name, nameLength)) {
+					return false;
+				}
+			}
+
+			auto tagOffset = bufferOffset + tagStart;
+			if(!addLiteral(literalStart, tagOffset - literalStart) || !addOp(tagOffset, tagLength, id)) {
+				return false;
+			}
+			literalStart = tagOffset + tagLength;
+			pos = tagStart + tagLength;
+		}
+
+		if(eof && keep == length) {
+			break;
+		}
+
+		memmove(buffer, &buffer[keep], length - keep);
+		bufferOffset += keep;
+		length -= keep;
+		pos -= std::min(pos, keep);
+	}
+
+	srcLength = bufferOffset + length;
+	if(!addLiteral(literalStart, srcLength - literalStart)) {
+		return false;
+	}
+
+	debug_d("[TMPL] Compiled %u bytes into %u ops, %u variables", srcLength, opCount, names.count());
+	return true;
+}
+
+bool CompiledTemplate::saveTo(Print& p) const
+{
+	FileHeader hdr{COMPILED_TEMPLATE_MAGIC, srcLength, opCount, uint32_t(names.length())};
+	size_t opsSize = opCount * sizeof(Op);
+	return p.write(reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr)) == sizeof(hdr) &&
+		   p.write(reinterpret_cast<const uint8_t*>(ops.get()), opsSize) == opsSize &&
+		   p.write(reinterpret_cast<const uint8_t*>(names.c_str()), hdr.namesLength) == hdr.namesLength;
+}
+
+bool CompiledTemplate::loadFrom(IDataSourceStream& stream)
+{
+	clear();
+
+	FileHeader hdr;
+	if(stream.readBytes(reinterpret_cast<char*>(&hdr), sizeof(hdr)) != sizeof(hdr) ||
+	   hdr.magic != COMPILED_TEMPLATE_MAGIC) {
+		return false;
+	}
+
+	// Check header against the data actually present before allocating anything
+	int avail = stream.available();
+	if(avail < 0 || hdr.opCount > hdr.sourceLength || hdr.opCount > size_t(avail) / sizeof(Op) ||
+	   hdr.namesLength > size_t(avail) - hdr.opCount * sizeof(Op)) {
+		debug_w("[TMPL] Invalid compiled template");
+		return false;
+	}
+
+	if(hdr.opCount != 0) {
+		ops.reset(new Op[hdr.opCount]);
+		if(!ops) {
+			return false;
+		}
+		size_t opsSize = hdr.opCount * sizeof(Op);
+		if(stream.readBytes(reinterpret_cast<char*>(ops.get()), opsSize) != opsSize) {
+			clear();
+			return false;
+		}
+		opCount = opCapacity = hdr.opCount;
+	}
+
+	String s;
+	if(!s.setLength(hdr.namesLength) || stream.readBytes(s.begin(), hdr.namesLength) != hdr.namesLength) {
+		clear();
+		return false;
+	}
+	names = std::move(s);
+
+	// Reject references to unknown variables
+	auto varCount = names.count();
+	for(unsigned i = 0; i < opCount; ++i) {
+		if(!ops[i].isLiteral() && ops[i].id >= varCount) {
+			clear();
+			return false;
+		}
+	}
+
+	srcLength = hdr.sourceLength;
+	return true;
+}
+
+int CompiledTemplate::getVariableId(const String& name) const
+{
+	return findName(names, name.c_str(), name.length());
+}
+
+/* CompiledTemplateStream */
+
+CompiledTemplateStream::CompiledTemplateStream(const CompiledTemplate& tmpl, IDataSourceStream* source, bool owned)
+	: tmpl(tmpl), source(source), sourceOwned(owned)
+{
+	values.reset(new Value[tmpl.variables().count()]);
+	if(source == nullptr) {
+		opIndex = tmpl.count();
+	}
+}
+
+void CompiledTemplateStream::setVar(unsigned id, const String& value)
+{
+	if(id < tmpl.variables().count()) {
+		values[id].text = value;
+		values[id].state = Value::State::set;
+	}
+}
+
+CompiledTemplateStream::Span CompiledTemplateStream::getSpan(unsigned index)
+{
+	auto& op = tmpl[index];
+	if(!op.isLiteral()) {
+		auto& value = values[op.id];
+		if(value.state == Value::State::none) {
+			value.state = Value::State::fetched;
+			if(getValueCallback) {
+				value.text = getValueCallback(op.id);
+			}
+		}
+		if(value.text) {
+			return Span{value.text.c_str(), 0, value.text.length()};
+		}
+	}
+
+	// Literal, or unresolved tag which is emitted unchanged
+	return Span{nullptr, op.offset, op.length};
+}
+
+void CompiledTemplateStream::skipEmpty()
+{
+	while(opPos == 0 && opIndex < tmpl.count() && getSpan(opIndex).length == 0) {
+		++opIndex;
+	}
+}
+
+size_t CompiledTemplateStream::readSource(size_t offset, char* buffer, size_t length)
+{
+	if(offset != sourcePos) {
+		if(source->seekFrom(offset, SeekOrigin::Start) != int(offset)) {
+			debug_e("[TMPL] Source seek failed");
+			return 0;
+		}
+		sourcePos = offset;
+	}
+
+	size_t count{0};
+	while(count < length) {
+		auto n = source->readMemoryBlock(buffer + count, length - count);
+		if(n == 0) {
+			break;
+		}
+		source->seek(n);
+		sourcePos += n;
+		count += n;
+	}
+
+	return count;
+}
+
+uint16_t CompiledTemplateStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0) {
+		return 0;
+	}
+
+	skipEmpty();
+
+	// Read ahead without changing position
+	size_t count{0};
+	auto index = opIndex;
+	auto pos = opPos;
+	while(count < size_t(bufSize) && index < tmpl.count()) {
+		auto span = getSpan(index);
+		auto len = std::min(span.length - pos, size_t(bufSize) - count);
+		if(span.text != nullptr) {
+			memcpy(&data[count], span.text + pos, len);
+		} else {
+			len = readSource(span.offset + pos, &data[count], len);
+		}
+		count += len;
+		pos += len;
+		if(pos < span.length) {
+			break;
+		}
+		++index;
+		pos = 0;
+	}
+
+	return count;
+}
+
+int CompiledTemplateStream::seekFrom(int offset, SeekOrigin origin)
+{
+	if(origin == SeekOrigin::Start && offset == 0) {
+		opIndex = source ? 0 : tmpl.count();
+		opPos = 0;
+		streamPos = 0;
+		// Values obtained via callback may differ for the next render
+		for(unsigned i = 0; i < tmpl.variables().count(); ++i) {
+			if(values[i].state == Value::State::fetched) {
+				values[i].text = nullptr;
+				values[i].state = Value::State::none;
+			}
+		}
+		return 0;
+	}
+
+	// Forward-only seeks
+	if(origin != SeekOrigin::Current || offset < 0) {
+		return -1;
+	}
+
+	size_t remain = offset;
+	while(remain != 0 && opIndex < tmpl.count()) {
+		auto span = getSpan(opIndex);
+		auto len = std::min(span.length - opPos, remain);
+		opPos += len;
+		remain -= len;
+		if(opPos >= span.length) {
+			++opIndex;
+			opPos = 0;
+		}
+	}
+	if(remain != 0) {
+		return -1;
+	}
+
+	skipEmpty();
+	streamPos += offset;
+	return streamPos;
+}
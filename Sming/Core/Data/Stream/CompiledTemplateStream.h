@@ -0,0 +1,238 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "TemplateStream.h"
+#include <Data/CStringArray.h>
+#include <memory>
+
+/**
+ * @brief Template parsed once into a list of literal spans and variable references
+ *
+ * Uses the same tag syntax as `TemplateStream`.
+ * The result may be kept in RAM and shared by any number of `CompiledTemplateStream` instances,
+ * or saved alongside the template source and loaded on startup.
+ *
+ * @ingroup stream
+ */
+class CompiledTemplate
+{
+public:
+	/**
+	 * @brief Identifies a literal span
+	 */
+	static constexpr uint16_t literalId{0xffff};
+
+	/**
+	 * @brief A template operation
+	 *
+	 * Literals refer to a span of the source.
+	 * Variables also record the location of their tag, which is emitted unchanged if no value is available.
+	 */
+	struct Op {
+		uint32_t offset; ///< Position in source
+		uint16_t length; ///< Length of span in source
+		uint16_t id;	 ///< Variable ID, or literalId
+
+		bool isLiteral() const
+		{
+			return id == literalId;
+		}
+	};
+
+	/**
+	 * @brief Parse template source
+	 * @param source Read sequentially from the start
+	 * @param doubleBraces true if tags are of the form `{{varname}}`
+	 * @retval bool false on memory allocation failure
+	 */
+	bool compile(IDataSourceStream& source, bool doubleBraces = false);
+
+	/**
+	 * @brief Write compiled template in binary form
+	 * @retval bool true on success
+	 */
+	bool saveTo(Print& p) const;
+
+	/**
+	 * @brief Read compiled template written by `saveTo()`
+	 * @retval bool false if data is invalid
+	 */
+	bool loadFrom(IDataSourceStream& stream);
+
+	void clear();
+
+	/**
+	 * @brief Number of operations
+	 */
+	unsigned count() const
+	{
+		return opCount;
+	}
+
+	const Op& operator[](unsigned index) const
+	{
+		return ops[index];
+	}
+
+	/**
+	 * @brief Length of template source, as compiled
+	 *
+	 * Can be compared with the current source to check a saved template is still valid.
+	 */
+	size_t sourceLength() const
+	{
+		return srcLength;
+	}
+
+	/**
+	 * @brief Names of variables used in the template, indexed by ID
+	 */
+	const CStringArray& variables() const
+	{
+		return names;
+	}
+
+	/**
+	 * @brief Get the ID for a variable
+	 * @param name Variable names are case-sensitive
+	 * @retval int -1 if the template does not use this variable
+	 */
+	int getVariableId(const String& name) const;
+
+private:
+	bool addOp(uint32_t offset, size_t length, uint16_t id);
+	bool addLiteral(uint32_t offset, size_t length);
+
+	std::unique_ptr<Op[]> ops;
+	unsigned opCount{0};
+	unsigned opCapacity{0};
+	CStringArray names;
+	uint32_t srcLength{0};
+};
+
+/**
+ * @brief Render a compiled template without re-parsing the source
+ *
+ * Literal text is read directly from the source stream, which must support `seekFrom()`.
+ * Each variable is resolved once per render, when first required.
+ * Values are set by variable ID or obtained from a callback.
+ *
+ * Output control via `enableOutput()` and `SectionTemplate` expressions are not supported.
+ *
+ * @ingroup stream
+ */
+class CompiledTemplateStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @brief Callback to obtain variable values
+	 * @param id Variable ID
+	 * @retval String Invalid to emit tag unchanged
+	 */
+	using GetValueDelegate = Delegate<String(unsigned id)>;
+
+	/**
+	 * @brief Create a stream to render a template
+	 * @param tmpl Compiled template, must remain valid for the lifetime of this stream
+	 * @param source Template source, as compiled
+	 * @param owned If true (default) then source will be destroyed with this stream
+	 */
+	CompiledTemplateStream(const CompiledTemplate& tmpl, IDataSourceStream* source, bool owned = true);
+
+	~CompiledTemplateStream()
+	{
+		if(sourceOwned) {
+			delete source;
+		}
+	}
+
+	StreamType getStreamType() const override
+	{
+		return source ? eSST_Template : eSST_Invalid;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override
+	{
+		skipEmpty();
+		return opIndex >= tmpl.count();
+	}
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+	/**
+	 * @brief Set value of a variable
+	 * @param id Variable ID, as returned by `CompiledTemplate::getVariableId()`
+	 * @param value
+	 */
+	void setVar(unsigned id, const String& value);
+
+	/**
+	 * @brief Set value of a variable by name
+	 * @retval bool false if the template does not use this variable
+	 */
+	bool setVar(const String& name, const String& value)
+	{
+		int id = tmpl.getVariableId(name);
+		if(id < 0) {
+			return false;
+		}
+		setVar(id, value);
+		return true;
+	}
+
+	/**
+	 * @brief Set a callback to obtain variable values
+	 * @param callback Invoked only for variables without a value
+	 */
+	void onGetValue(GetValueDelegate callback)
+	{
+		getValueCallback = callback;
+	}
+
+private:
+	struct Value {
+		enum class State : uint8_t {
+			none,	 ///< Not yet resolved
+			set,	 ///< Set by application
+			fetched, ///< Obtained from callback
+		};
+		String text;
+		State state{State::none};
+	};
+
+	struct Span {
+		const char* text; ///< Variable value, or nullptr to read from source
+		size_t offset;	  ///< Source position if text is nullptr
+		size_t length;
+	};
+
+	Span getSpan(unsigned index);
+	size_t readSource(size_t offset, char* buffer, size_t length);
+	void skipEmpty();
+
+	const CompiledTemplate& tmpl;
+	IDataSourceStream* source;
+	GetValueDelegate getValueCallback;
+	std::unique_ptr<Value[]> values;
+	size_t sourcePos{0}; ///< Current position in source stream
+	unsigned opIndex{0}; ///< Current operation
+	size_t opPos{0};	 ///< Output position within current operation
+	int streamPos{0};	 ///< Output position
+	bool sourceOwned;
+};
@@ -75,6 +75,20 @@ public:
      */
 	virtual uint16_t readMemoryBlock(char* data, int bufSize) = 0;
 
+	/**
+	 * @brief Get direct access to stream content at the current read position
+	 * @param data On success, points to a contiguous block of stream data
+	 * @retval size_t Number of bytes available at `data`, 0 if not supported
+	 * @note Memory-based streams implement this so content may be consumed without copying.
+	 * The data remains valid until the stream is modified or destroyed.
+	 * The read position is not changed: use `seek()` to advance it.
+	 */
+	virtual size_t peekBuffer(const char*& data)
+	{
+		(void)data;
+		return 0;
+	}
+
 	/**
 	 * @brief Read one character and moves the stream pointer
 	 * @retval The character that was read or -1 if none is available
@@ -56,6 +56,12 @@ public:
 		return written;
 	}
 
+	size_t peekBuffer(const char*& data) override
+	{
+		data = reinterpret_cast<const char*>(buffer.get()) + readPos;
+		return capacity - readPos;
+	}
+
 	bool seek(int len) override
 	{
 		if(readPos + len > capacity) {
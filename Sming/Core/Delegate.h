@@ -15,35 +15,320 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
+#include <new>
+#include <cstdint>
 using namespace std::placeholders;
 
 /**
- * @brief  Delegate class, encapsulates a std::function
- * Added constructor template implements lambda callback which is more efficient than std::bind.
+ * @brief Size of inline storage for Delegate callables, in pointer-sized words
+ */
+#ifndef DELEGATE_STORAGE_WORDS
+#define DELEGATE_STORAGE_WORDS 4
+#endif
+
+/**
+ * @brief If 0, a Delegate which cannot store its callable inline fails to compile
+ */
+#ifndef DELEGATE_HEAP_FALLBACK
+#define DELEGATE_HEAP_FALLBACK 1
+#endif
+
+/**
+ * @brief  Delegate class, encapsulates a callable object
+ *
+ * Usage is as for `std::function`. Callables are stored in a fixed-size buffer within the Delegate,
+ * so binding a function pointer, class method or small lambda does not allocate memory.
+ * Those which are trivially copyable, including all function pointers and method bindings,
+ * are copied without any function call.
+ *
+ * Larger callables are allocated on the heap unless `DELEGATE_HEAP_FALLBACK` is 0,
+ * in which case they are rejected at compile time.
  */
 template <typename> class Delegate; /* undefined */
 
 /** @brief  Delegate class
 */
-template <typename ReturnType, typename... ParamTypes>
-class Delegate<ReturnType(ParamTypes...)> : public std::function<ReturnType(ParamTypes...)>
+template <typename ReturnType, typename... ParamTypes> class Delegate<ReturnType(ParamTypes...)>
 {
-	using StdFunc = std::function<ReturnType(ParamTypes...)>;
+	union Storage {
+		void* ptr; ///< Heap-allocated callable
+		alignas(void*) alignas(uint64_t) unsigned char data[DELEGATE_STORAGE_WORDS * sizeof(void*)];
+	};
+
+	template <typename F>
+	static constexpr bool storeInline = sizeof(F) <= sizeof(Storage) && alignof(F) <= alignof(Storage) &&
+										std::is_nothrow_move_constructible<F>::value;
+
+	template <typename F>
+	using EnableIfCallable =
+		std::enable_if_t<!std::is_same<std::decay_t<F>, Delegate>::value &&
+						 !std::is_same<std::decay_t<F>, std::nullptr_t>::value &&
+						 std::is_invocable_r<ReturnType, std::decay_t<F>&, ParamTypes...>::value>;
 
 public:
-	using StdFunc::function;
+	/**
+	 * @brief Determine if a callable of the given type is stored without heap allocation
+	 */
+	template <typename F> static constexpr bool isInline()
+	{
+		return storeInline<std::decay_t<F>>;
+	}
 
-	Delegate() = default;
+	constexpr Delegate() noexcept : storage{}
+	{
+	}
+
+	constexpr Delegate(std::nullptr_t) noexcept : Delegate()
+	{
+	}
 
 	/** @brief  Delegate a class method
 	 *  @param m Method declaration to delegate
 	 *  @param  c Pointer to the class type
 	 */
-	template <class ClassType>
-	Delegate(ReturnType (ClassType::*m)(ParamTypes...), ClassType* c)
-		: StdFunc([m, c](ParamTypes... params) -> ReturnType { return (c->*m)(params...); })
+	template <class ClassType> Delegate(ReturnType (ClassType::*m)(ParamTypes...), ClassType* c) : Delegate()
+	{
+		if(m != nullptr) {
+			assign(MethodBinding<ClassType>{m, c});
+		}
+	}
+
+	/**
+	 * @brief Delegate a function, lambda, `std::bind` result or other callable
+	 */
+	template <typename F, typename = EnableIfCallable<F>> Delegate(F&& f) : Delegate()
+	{
+		if(!isEmpty<std::decay_t<F>>(f)) {
+			assign(std::forward<F>(f));
+		}
+	}
+
+	Delegate(const Delegate& other) : invoker(other.invoker), manager(other.manager)
+	{
+		if(manager == nullptr) {
+			storage = other.storage;
+		} else {
+			manager(Op::copy, storage, const_cast<Storage&>(other.storage));
+		}
+	}
+
+	Delegate(Delegate&& other) noexcept : Delegate()
+	{
+		moveFrom(other);
+	}
+
+	~Delegate()
+	{
+		reset();
+	}
+
+	Delegate& operator=(const Delegate& other)
+	{
+		if(this != &other) {
+			Delegate(other).swap(*this);
+		}
+		return *this;
+	}
+
+	Delegate& operator=(Delegate&& other) noexcept
+	{
+		if(this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	Delegate& operator=(std::nullptr_t) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	template <typename F, typename = EnableIfCallable<F>> Delegate& operator=(F&& f)
+	{
+		Delegate(std::forward<F>(f)).swap(*this);
+		return *this;
+	}
+
+	void swap(Delegate& other) noexcept
+	{
+		Delegate tmp(std::move(other));
+		other.moveFrom(*this);
+		moveFrom(tmp);
+	}
+
+	/**
+	 * @brief Invoke the callable
+	 * @note Delegate must not be empty
+	 */
+	ReturnType operator()(ParamTypes... params) const
 	{
+		return invoker(const_cast<Storage&>(storage), std::forward<ParamTypes>(params)...);
 	}
+
+	explicit operator bool() const noexcept
+	{
+		return invoker != nullptr;
+	}
+
+	friend bool operator==(const Delegate& d, std::nullptr_t) noexcept
+	{
+		return !d;
+	}
+
+	friend bool operator==(std::nullptr_t, const Delegate& d) noexcept
+	{
+		return !d;
+	}
+
+	friend bool operator!=(const Delegate& d, std::nullptr_t) noexcept
+	{
+		return bool(d);
+	}
+
+	friend bool operator!=(std::nullptr_t, const Delegate& d) noexcept
+	{
+		return bool(d);
+	}
+
+private:
+	enum class Op {
+		copy,
+		move,
+		destroy,
+	};
+
+	using Invoker = ReturnType (*)(Storage& storage, ParamTypes&&... params);
+	using Manager = void (*)(Op op, Storage& dst, Storage& src);
+
+	template <class ClassType> struct MethodBinding {
+		ReturnType (ClassType::*method)(ParamTypes...);
+		ClassType* object;
+
+		ReturnType operator()(ParamTypes... params) const
+		{
+			return (object->*method)(std::forward<ParamTypes>(params)...);
+		}
+	};
+
+	template <typename F> static F& getInline(Storage& storage)
+	{
+		return *std::launder(reinterpret_cast<F*>(storage.data));
+	}
+
+	template <typename F> static F& getHeap(Storage& storage)
+	{
+		return *static_cast<F*>(storage.ptr);
+	}
+
+	template <typename F> static bool isEmpty(const F& f)
+	{
+		if constexpr(std::is_pointer<F>::value || std::is_member_pointer<F>::value) {
+			return f == nullptr;
+		} else if constexpr(std::is_constructible<bool, const F&>::value && !std::is_convertible<const F&, bool>::value) {
+			// Explicit bool operator, e.g. std::function
+			return !f;
+		} else {
+			return false;
+		}
+	}
+
+	template <typename F> static ReturnType invoke(F& f, ParamTypes&&... params)
+	{
+		if constexpr(std::is_void<ReturnType>::value) {
+			std::invoke(f, std::forward<ParamTypes>(params)...);
+		} else {
+			return std::invoke(f, std::forward<ParamTypes>(params)...);
+		}
+	}
+
+	template <typename F> static ReturnType invokeInline(Storage& storage, ParamTypes&&... params)
+	{
+		return invoke(getInline<F>(storage), std::forward<ParamTypes>(params)...);
+	}
+
+	template <typename F> static ReturnType invokeHeap(Storage& storage, ParamTypes&&... params)
+	{
+		return invoke(getHeap<F>(storage), std::forward<ParamTypes>(params)...);
+	}
+
+	template <typename F> static void manageInline(Op op, Storage& dst, Storage& src)
+	{
+		switch(op) {
+		case Op::copy:
+			new(dst.data) F(getInline<F>(src));
+			break;
+		case Op::move:
+			new(dst.data) F(std::move(getInline<F>(src)));
+			getInline<F>(src).~F();
+			break;
+		case Op::destroy:
+			getInline<F>(dst).~F();
+			break;
+		}
+	}
+
+	template <typename F> static void manageHeap(Op op, Storage& dst, Storage& src)
+	{
+		switch(op) {
+		case Op::copy:
+			dst.ptr = new F(getHeap<F>(src));
+			break;
+		case Op::move:
+			dst.ptr = src.ptr;
+			src.ptr = nullptr;
+			break;
+		case Op::destroy:
+			delete &getHeap<F>(dst);
+			break;
+		}
+	}
+
+	template <typename F> void assign(F&& f)
+	{
+		using Callable = std::decay_t<F>;
+		if constexpr(storeInline<Callable>) {
+			new(storage.data) Callable(std::forward<F>(f));
+			invoker = invokeInline<Callable>;
+			if constexpr(!std::is_trivially_copyable<Callable>::value) {
+				manager = manageInline<Callable>;
+			}
+		} else {
+			static_assert(DELEGATE_HEAP_FALLBACK || sizeof(Callable) == 0,
+						  "Delegate callable too large for inline storage: increase DELEGATE_STORAGE_WORDS");
+			storage.ptr = new Callable(std::forward<F>(f));
+			invoker = invokeHeap<Callable>;
+			manager = manageHeap<Callable>;
+		}
+	}
+
+	void moveFrom(Delegate& other) noexcept
+	{
+		invoker = other.invoker;
+		manager = other.manager;
+		if(manager == nullptr) {
+			storage = other.storage;
+		} else {
+			manager(Op::move, storage, other.storage);
+		}
+		other.invoker = nullptr;
+		other.manager = nullptr;
+	}
+
+	void reset() noexcept
+	{
+		if(manager != nullptr) {
+			manager(Op::destroy, storage, storage);
+		}
+		invoker = nullptr;
+		manager = nullptr;
+	}
+
+	Storage storage;
+	Invoker invoker{nullptr};
+	Manager manager{nullptr}; ///< Not required for trivially copyable callables
 };
 
 /** @} */
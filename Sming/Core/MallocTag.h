@@ -0,0 +1,29 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MallocTag.h
+ *
+ ****/
+
+#pragma once
+
+/**
+ * @brief Attribute heap allocations within the current scope to a subsystem
+ * @param tag One of `MallocCount::Tags`, e.g. `tcp`
+ *
+ * Has no effect unless the malloc_count Component is used.
+ */
+#if ENABLE_MALLOC_COUNT
+
+#include <malloc_count.h>
+
+#define MALLOC_TAG_SCOPE(tag) MallocCount::TagScope mallocTagScope_(MallocCount::Tags::tag)
+
+#else
+
+#define MALLOC_TAG_SCOPE(tag)
+
+#endif
@@ -24,6 +24,10 @@ COMPONENT_CXXFLAGS		+= -DSPIFF_FILEDESC_COUNT=$(SPIFF_FILEDESC_COUNT)
 
 COMPONENT_CFLAGS		+= -Wno-tautological-compare
 
+COMPONENT_RELINK_VARS	+= SPIFFS_PATH_INDEX
+SPIFFS_PATH_INDEX		?= 1
+COMPONENT_CXXFLAGS		+= -DSPIFFS_PATH_INDEX=$(SPIFFS_PATH_INDEX)
+
 COMPONENT_RELINK_VARS	+= SPIFFS_OBJ_META_LEN
 SPIFFS_OBJ_META_LEN		?= 16
 COMPONENT_CFLAGS		+= -DSPIFFS_OBJ_META_LEN=$(SPIFFS_OBJ_META_LEN)
@@ -87,6 +87,11 @@ void fillStat(Stat& stat, const SpiffsMetaBuffer& smb)
 	stat.compression = smb.meta.compression;
 }
 
+int notFound()
+{
+	return translateSpiffsError(SPIFFS_ERR_NOT_FOUND);
+}
+
 } // namespace
 
 s32_t FileSystem::f_read(struct spiffs_t* spiffs, u32_t addr, u32_t size, u8_t* dst)
@@ -177,6 +182,8 @@ int FileSystem::mount()
 
 int FileSystem::tryMount(spiffs_config& cfg)
 {
+	invalidateIndex();
+
 	auto err = SPIFFS_mount(handle(), &cfg, reinterpret_cast<uint8_t*>(workBuffer),
 							reinterpret_cast<uint8_t*>(fileDescriptors), sizeof(fileDescriptors), cache, sizeof(cache),
 							nullptr);
@@ -195,6 +202,7 @@ int FileSystem::tryMount(spiffs_config& cfg)
  */
 int FileSystem::format()
 {
+	invalidateIndex();
 	spiffs_config cfg = fs.cfg;
 	// Must be unmounted before format is called - see API
 	SPIFFS_unmount(handle());
@@ -211,6 +219,8 @@ int FileSystem::format()
 
 int FileSystem::check()
 {
+	invalidateIndex();
+
 	fs.check_cb_f = [](spiffs*, [[maybe_unused]] spiffs_check_type type, [[maybe_unused]] spiffs_check_report report,
 					   [[maybe_unused]] u32_t arg1, [[maybe_unused]] u32_t arg2) {
 		if(report > SPIFFS_CHECK_PROGRESS) {
@@ -281,7 +291,21 @@ FileHandle FileSystem::open(const char* path, OpenFlags flags)
 		return FileHandle(Error::NotSupported);
 	}
 
-	auto file = SPIFFS_open(handle(), path, sflags, 0);
+	spiffs_file file;
+	const PathIndex::Entry* entry{nullptr};
+	if(!lookup(path, entry)) {
+		if(flags[OpenFlag::Create]) {
+			invalidateIndex();
+		}
+		file = SPIFFS_open(handle(), path, sflags, 0);
+	} else if(entry != nullptr) {
+		file = SPIFFS_open_by_page(handle(), entry->pix, sflags, 0);
+	} else if(flags[OpenFlag::Create]) {
+		invalidateIndex();
+		file = SPIFFS_open(handle(), path, sflags, 0);
+	} else {
+		return notFound();
+	}
 	if(file < 0) {
 		int err = translateSpiffsError(file);
 		debug_ifserr(err, "open('%s')", path);
@@ -299,6 +323,7 @@ FileHandle FileSystem::open(const char* path, OpenFlags flags)
 
 	// Now truncate the file if so requested
 	if(flags[OpenFlag::Truncate]) {
+		setModified(file);
 		int err = SPIFFS_ftruncate(handle(), file, 0);
 		if(err < 0) {
 			SPIFFS_close(handle(), file);
@@ -321,6 +346,7 @@ int FileSystem::close(FileHandle file)
 	}
 
 	int res = flushMeta(file);
+	commitModified(file);
 	int err = SPIFFS_close(handle(), file);
 	if(err < 0) {
 		res = translateSpiffsError(err);
@@ -343,6 +369,7 @@ file_offset_t FileSystem::tell(FileHandle file)
 
 int FileSystem::ftruncate(FileHandle file, file_size_t new_size)
 {
+	setModified(file);
 	int res = SPIFFS_ftruncate(handle(), file, new_size);
 	return translateSpiffsError(res);
 }
@@ -352,6 +379,7 @@ int FileSystem::flush(FileHandle file)
 	CHECK_MOUNTED()
 
 	int res = flushMeta(file);
+	commitModified(file);
 	int err = SPIFFS_fflush(handle(), file);
 	if(err < 0) {
 		res = translateSpiffsError(err);
@@ -375,6 +403,7 @@ int FileSystem::read(FileHandle file, void* data, size_t size)
 
 int FileSystem::write(FileHandle file, const void* data, size_t size)
 {
+	setModified(file);
 	int res = SPIFFS_write(handle(), file, const_cast<void*>(data), size);
 	CHECK_RES(res)
 
@@ -441,6 +470,7 @@ int FileSystem::flushMeta(FileHandle file)
 	if(smb->flags[SpiffsMetaBuffer::Flag::dirty]) {
 		debug_d("Flushing Metadata to disk");
 		smb->flags[SpiffsMetaBuffer::Flag::dirty] = false;
+		invalidateIndex();
 		int err = SPIFFS_fupdate_meta(handle(), file, smb);
 		if(err < 0) {
 			err = translateSpiffsError(err);
@@ -452,6 +482,60 @@ int FileSystem::flushMeta(FileHandle file)
 	return FS_OK;
 }
 
+/*
+ * Find a path using the index, building it first if necessary.
+ * Returns false if the index is not available, in which case SPIFFS must be searched.
+ */
+bool FileSystem::lookup(const char* path, const PathIndex::Entry*& entry)
+{
+#if SPIFFS_PATH_INDEX
+	if(path == nullptr || strlen(path) >= SPIFFS_OBJ_NAME_LEN) {
+		return false;
+	}
+
+	if(!pathIndex.isValid()) {
+		int err = pathIndex.build(handle());
+		if(err < 0) {
+			debug_w("[SPIFFS] Path index build failed: %s", spiffsErrorToStr(err).c_str());
+			return false;
+		}
+	}
+
+	entry = pathIndex.find(path);
+	return true;
+#else
+	(void)path;
+	(void)entry;
+	return false;
+#endif
+}
+
+void FileSystem::setModified(FileHandle file)
+{
+#if SPIFFS_PATH_INDEX
+	unsigned off = SPIFFS_FH_UNOFFS(handle(), file) - 1;
+	if(off < SPIFF_FILEDESC_COUNT) {
+		modifiedFiles |= 1U << off;
+	}
+	pathIndex.invalidate();
+#endif
+}
+
+/*
+ * Cached writes are committed on flush or close, which may move pages
+ */
+void FileSystem::commitModified(FileHandle file)
+{
+#if SPIFFS_PATH_INDEX
+	unsigned off = SPIFFS_FH_UNOFFS(handle(), file) - 1;
+	uint32_t mask = 1U << off;
+	if(off < SPIFF_FILEDESC_COUNT && (modifiedFiles & mask) != 0) {
+		modifiedFiles &= ~mask;
+		pathIndex.invalidate();
+	}
+#endif
+}
+
 int FileSystem::stat(const char* path, Stat* stat)
 {
 	CHECK_MOUNTED()
@@ -465,6 +549,23 @@ int FileSystem::stat(const char* path, Stat* stat)
 		return FS_OK;
 	}
 
+	const PathIndex::Entry* entry;
+	if(lookup(path, entry)) {
+		if(entry == nullptr) {
+			return notFound();
+		}
+		if(stat != nullptr) {
+			*stat = Stat{};
+			stat->fs = this;
+			stat->name.copy(path);
+			stat->size = entry->size;
+			stat->id = entry->id;
+			fillStat(*stat, entry->smb);
+			checkStat(*stat);
+		}
+		return FS_OK;
+	}
+
 	spiffs_stat ss;
 	int err = SPIFFS_stat(handle(), path ?: "", &ss);
 	CHECK_RES(err)
@@ -635,6 +736,7 @@ int FileSystem::setxattr(const char* path, AttributeTag tag, const void* data, s
 	if(!smb.flags[SpiffsMetaBuffer::Flag::dirty]) {
 		return FS_OK;
 	}
+	invalidateIndex();
 	err = SPIFFS_update_meta(handle(), path, &smb);
 	partition.sync();
 	return translateSpiffsError(err);
@@ -647,6 +749,14 @@ int FileSystem::getxattr(const char* path, AttributeTag tag, void* buffer, size_
 {
 #ifdef SPIFFS_STORE_META
 	FS_CHECK_PATH(path)
+	const PathIndex::Entry* entry;
+	if(lookup(path, entry)) {
+		if(entry == nullptr) {
+			return notFound();
+		}
+		auto smb = entry->smb;
+		return smb.getxattr(tag, buffer, size);
+	}
 	spiffs_stat ss;
 	int err = SPIFFS_stat(handle(), path, &ss);
 	CHECK_RES(err)
@@ -817,6 +927,7 @@ int FileSystem::rename(const char* oldpath, const char* newpath)
 		return Error::BadParam;
 	}
 
+	invalidateIndex();
 	int err = SPIFFS_rename(handle(), oldpath, newpath);
 	partition.sync();
 	return translateSpiffsError(err);
@@ -840,6 +951,7 @@ int FileSystem::remove(const char* path)
 		}
 	}
 
+	invalidateIndex();
 	int err = SPIFFS_remove(handle(), path);
 	err = translateSpiffsError(err);
 	debug_ifserr(err, "remove('%s')", path);
@@ -860,6 +972,7 @@ int FileSystem::fremove(FileHandle file)
 		return Error::ReadOnly;
 	}
 
+	invalidateIndex();
 	int err = SPIFFS_fremove(handle(), file);
 	return translateSpiffsError(err);
 }
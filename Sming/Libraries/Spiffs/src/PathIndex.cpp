@@ -0,0 +1,66 @@
+/**
+ * PathIndex.cpp
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "include/IFS/SPIFFS/PathIndex.h"
+#include <debug_progmem.h>
+
+namespace IFS::SPIFFS
+{
+int PathIndex::build(spiffs* fs)
+{
+	invalidate();
+
+	spiffs_DIR d;
+	if(SPIFFS_opendir(fs, nullptr, &d) == nullptr) {
+		return SPIFFS_errno(fs);
+	}
+
+	SPIFFS_clearerr(fs);
+	spiffs_dirent e;
+	while(SPIFFS_readdir(&d, &e) != nullptr) {
+		Entry entry{
+			.id = e.obj_id,
+			.pix = e.pix,
+			.size = e.size,
+		};
+#ifdef SPIFFS_STORE_META
+		entry.smb.assign(e.meta);
+#else
+		entry.smb.init();
+#endif
+		String path(reinterpret_cast<const char*>(e.name));
+		if(!path) {
+			entries.clear();
+			SPIFFS_closedir(&d);
+			return SPIFFS_ERR_INTERNAL;
+		}
+		entries[path] = entry;
+	}
+
+	int err = SPIFFS_errno(fs);
+	SPIFFS_closedir(&d);
+	if(err < 0) {
+		entries.clear();
+		return err;
+	}
+
+	valid = true;
+	debug_d("[SPIFFS] Indexed %u files", entries.count());
+	return SPIFFS_OK;
+}
+
+} // namespace IFS::SPIFFS
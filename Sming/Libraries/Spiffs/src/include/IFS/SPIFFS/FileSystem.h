@@ -37,17 +37,29 @@
  *  	Standard IFS truncate() method allows file size to be reduced.
  *  	This was added to Sming in version 4.
  *
+ *	Path index
+ *
+ *		SPIFFS searches the entire volume to locate a file by name.
+ *		Paths are indexed in RAM so stat() and open() don't need to do this.
+ *		The index is discarded when the volume is modified and rebuilt on next use.
+ *		Set SPIFFS_PATH_INDEX=0 to disable.
+ *
  */
 
 #pragma once
 
 #include <IFS/IFileSystem.h>
 #include "FileMeta.h"
+#include "PathIndex.h"
 #include "../../../../spiffs/src/spiffs.h"
 extern "C" {
 #include "../../../../spiffs/src/spiffs_nucleus.h"
 }
 
+#ifndef SPIFFS_PATH_INDEX
+#define SPIFFS_PATH_INDEX 1
+#endif
+
 namespace IFS::SPIFFS
 {
 /*
@@ -109,6 +121,24 @@ private:
 
 	int tryMount(spiffs_config& cfg);
 
+	bool lookup(const char* path, const PathIndex::Entry*& entry);
+
+	/*
+	 * Pages may have moved, so paths must be looked up again
+	 */
+	void invalidateIndex()
+	{
+#if SPIFFS_PATH_INDEX
+		pathIndex.invalidate();
+#endif
+	}
+
+	/*
+	 * Track files with changes which may not yet have been written
+	 */
+	void setModified(FileHandle file);
+	void commitModified(FileHandle file);
+
 	SpiffsMetaBuffer* initMetaBuffer(FileHandle file);
 	SpiffsMetaBuffer* getMetaBuffer(FileHandle file);
 	int flushMeta(FileHandle file);
@@ -135,6 +165,11 @@ private:
 	Storage::Partition partition;
 	IProfiler* profiler{nullptr};
 	SpiffsMetaBuffer metaCache[SPIFF_FILEDESC_COUNT];
+#if SPIFFS_PATH_INDEX
+	PathIndex pathIndex;
+	uint32_t modifiedFiles{0}; ///< Bit set per file descriptor
+	static_assert(SPIFF_FILEDESC_COUNT <= 32, "Too many file descriptors");
+#endif
 	spiffs fs{};
 	uint8_t workBuffer[LOG_PAGE_SIZE * 2];
 	spiffs_fd fileDescriptors[SPIFF_FILEDESC_COUNT];
@@ -0,0 +1,89 @@
+/**
+ * PathIndex.h
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include <WHashMap.h>
+#include "FileMeta.h"
+#include "../../../../spiffs/src/spiffs.h"
+
+namespace IFS::SPIFFS
+{
+/**
+ * @brief In-memory index of file paths
+ *
+ * SPIFFS locates a file by name by reading the index header of every object on the volume.
+ * This index is built with a single scan and then resolves paths directly to the
+ * object index header page, size and metadata.
+ *
+ * Any modification to the volume may cause pages to be moved, so the entire index is
+ * discarded on write and rebuilt when next required.
+ */
+class PathIndex
+{
+public:
+	struct Entry {
+		spiffs_obj_id id;
+		spiffs_page_ix pix; ///< Object index header page
+		uint32_t size;
+		SpiffsMetaBuffer smb;
+	};
+
+	/**
+	 * @brief Read all object headers from the volume
+	 * @retval int SPIFFS error code
+	 */
+	int build(spiffs* fs);
+
+	/**
+	 * @brief Discard index following a modification to the volume
+	 */
+	void invalidate()
+	{
+		if(valid) {
+			entries.clear();
+			valid = false;
+		}
+	}
+
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	/**
+	 * @brief Find entry for a path
+	 * @retval Entry* nullptr if file does not exist
+	 * @note Index must be valid
+	 */
+	const Entry* find(const char* path) const
+	{
+		int i = entries.indexOf(path);
+		return (i < 0) ? nullptr : &entries.valueAt(i);
+	}
+
+	unsigned count() const
+	{
+		return entries.count();
+	}
+
+private:
+	HashMap<String, Entry, HashMapHash<String>> entries;
+	bool valid{false};
+};
+
+} // namespace IFS::SPIFFS
@@ -10,6 +10,7 @@
 
 #include "Platform/System.h"
 #include "Timer.h"
+#include <new>
 
 SystemClass System;
 SystemState SystemClass::state = eSS_None;
@@ -29,8 +30,136 @@ os_event_t SystemClass::taskQueue[TASK_QUEUE_LENGTH];
 #ifdef ENABLE_TASK_COUNT
 volatile uint8_t SystemClass::taskCount;
 volatile uint8_t SystemClass::maxTaskCount;
+volatile uint16_t SystemClass::droppedTaskCount;
 #endif
 
+#ifndef TASK_DELEGATE_POOL_SIZE
+/** @brief default number of delegates which may be queued without heap allocation
+ */
+#define TASK_DELEGATE_POOL_SIZE 8
+#endif
+
+TaskDelegateOverflow SystemClass::delegateOverflow{TaskDelegateOverflow::spill};
+
+namespace
+{
+/*
+ * Pool storage for queued delegates.
+ * Slots are constant-initialised so the pool is usable before static constructors have run.
+ * A delegate is only constructed whilst its slot is in use.
+ */
+union DelegateSlot {
+	constexpr DelegateSlot() : next(nullptr)
+	{
+	}
+
+	~DelegateSlot()
+	{
+	}
+
+	DelegateSlot* next; ///< Next free slot
+	TaskDelegate delegate;
+};
+
+/*
+ * Callbacks which could not be placed in the pool or task queue
+ */
+struct SpillNode {
+	TaskDelegate delegate;
+	SpillNode* next;
+};
+
+DelegateSlot delegateSlots[TASK_DELEGATE_POOL_SIZE];
+DelegateSlot* freeSlots; ///< Slots returned to pool
+unsigned slotsUsed;		 ///< Slots taken from array
+SpillNode* spillHead;	 ///< Spilled callbacks in queued order
+SpillNode* spillTail;	 ///< Last spilled callback
+bool spillQueued;		 ///< Task queued to service spill list
+TaskDelegateStats delegateStats{TASK_DELEGATE_POOL_SIZE};
+
+DelegateSlot* allocateSlot(TaskDelegate& callback)
+{
+	auto slot = freeSlots;
+	if(slot != nullptr) {
+		freeSlots = slot->next;
+	} else if(slotsUsed < TASK_DELEGATE_POOL_SIZE) {
+		slot = &delegateSlots[slotsUsed++];
+	} else {
+		return nullptr;
+	}
+
+	new(&slot->delegate) TaskDelegate(std::move(callback));
+	++delegateStats.used;
+	if(delegateStats.used > delegateStats.maxUsed) {
+		delegateStats.maxUsed = delegateStats.used;
+	}
+	return slot;
+}
+
+void releaseSlot(DelegateSlot* slot)
+{
+	slot->delegate.~TaskDelegate();
+	slot->next = freeSlots;
+	freeSlots = slot;
+	--delegateStats.used;
+}
+
+void slotHandler(void* param)
+{
+	auto slot = static_cast<DelegateSlot*>(param);
+	// Release slot first so callback may re-use it
+	TaskDelegate delegate(std::move(slot->delegate));
+	releaseSlot(slot);
+	delegate();
+}
+
+void spillHandler(void*)
+{
+	spillQueued = false;
+
+	// Only service callbacks spilled so far, any added during this call get another task
+	auto node = spillHead;
+	spillHead = spillTail = nullptr;
+	delegateStats.spillCount = 0;
+
+	while(node != nullptr) {
+		node->delegate();
+		auto next = node->next;
+		delete node;
+		node = next;
+	}
+}
+
+void queueSpillHandler()
+{
+	if(spillHead != nullptr && !spillQueued) {
+		spillQueued = System.queueCallback(spillHandler);
+	}
+}
+
+bool addSpill(TaskDelegate& callback)
+{
+	auto node = new SpillNode{std::move(callback), nullptr};
+	if(node == nullptr) {
+		return false;
+	}
+
+	if(spillTail == nullptr) {
+		spillHead = node;
+	} else {
+		spillTail->next = node;
+	}
+	spillTail = node;
+	++delegateStats.spillCount;
+	++delegateStats.spilled;
+
+	// If the task queue is full this gets retried from taskHandler
+	queueSpillHandler();
+	return true;
+}
+
+} // namespace
+
 /** @brief OS calls this function which invokes user-defined callback
  *  @note callback function pointer is placed in event->sig, with parameter in event->par.
  */
@@ -45,6 +174,9 @@ void SystemClass::taskHandler(os_event_t* event)
 	if(callback != nullptr) {
 		callback(reinterpret_cast<void*>(event->par));
 	}
+
+	// There is now room in the task queue
+	queueSpillHandler();
 }
 
 bool SystemClass::initialize()
@@ -84,8 +216,19 @@ bool SystemClass::queueCallback(TaskCallback callback, void* param)
 	restoreInterrupts(level);
 #endif
 
-	return system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback),
-						  reinterpret_cast<os_param_t>(param));
+	if(system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback),
+					  reinterpret_cast<os_param_t>(param))) {
+		return true;
+	}
+
+#ifdef ENABLE_TASK_COUNT
+	level = noInterrupts();
+	--taskCount;
+	++droppedTaskCount;
+	restoreInterrupts(level);
+#endif
+
+	return false;
 }
 
 bool SystemClass::queueCallback(InterruptCallback callback)
@@ -102,23 +245,39 @@ bool SystemClass::queueCallback(TaskDelegate callback)
 
 	// @todo consider failing immediately if called from interrupt context
 
-	auto delegate = new TaskDelegate(std::move(callback));
-	if(delegate == nullptr) {
-		return false;
+	// Once callbacks have spilled, continue adding to spill list to preserve ordering
+	if(spillHead == nullptr || delegateOverflow != TaskDelegateOverflow::spill) {
+		auto slot = allocateSlot(callback);
+		if(slot != nullptr) {
+			if(queueCallback(slotHandler, slot)) {
+				return true;
+			}
+			// Task queue is full
+			callback = std::move(slot->delegate);
+			releaseSlot(slot);
+		}
 	}
 
-	auto delegateHandler = [](void* param) {
-		auto delegate = static_cast<TaskDelegate*>(param);
-		(*delegate)();
-		delete delegate;
-	};
-
-	if(!queueCallback(delegateHandler, delegate)) {
-		delete delegate;
-		return false;
+	switch(delegateOverflow) {
+	case TaskDelegateOverflow::spill:
+		if(addSpill(callback)) {
+			return true;
+		}
+		break;
+	case TaskDelegateOverflow::drop:
+		++delegateStats.dropped;
+		return true;
+	case TaskDelegateOverflow::fail:
+		break;
 	}
 
-	return true;
+	++delegateStats.dropped;
+	return false;
+}
+
+TaskDelegateStats SystemClass::getTaskDelegateStats()
+{
+	return delegateStats;
 }
 
 void SystemClass::restart(unsigned deferMillis)
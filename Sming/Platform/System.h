@@ -93,6 +93,27 @@ enum SystemState {
 	eSS_Ready		 ///< System ready
 };
 
+/**
+ * @brief Action taken by `SystemClass::queueCallback(TaskDelegate)` when no pool slot is available
+ */
+enum class TaskDelegateOverflow {
+	fail,  ///< Callback is not queued and the call returns false
+	drop,  ///< Callback is discarded but the call returns true
+	spill, ///< Callback is allocated on the heap and invoked once there is room in the task queue
+};
+
+/**
+ * @brief Statistics for the deferred delegate pool
+ */
+struct TaskDelegateStats {
+	uint16_t capacity;	 ///< Number of slots in the pool
+	uint16_t used;		 ///< Slots currently in use
+	uint16_t maxUsed;	 ///< Maximum number of slots in use at any one time
+	uint16_t spillCount; ///< Callbacks currently waiting in the spill list
+	uint32_t spilled;	 ///< Total number of callbacks added to the spill list
+	uint32_t dropped;	 ///< Total number of callbacks which were not queued
+};
+
 /** @brief  System class
  */
 class SystemClass
@@ -207,11 +228,28 @@ public:
 	 * @param callback The Delegate to be called
 	 * @retval bool false if callback could not be queued
 	 * @note Provides flexibility and ease of use for using capturing lambdas, etc.
-	 * but requires heap allocation and not as fast as a function callback.
+	 * Delegates are stored in a fixed pool of TASK_DELEGATE_POOL_SIZE slots,
+	 * so heap allocation is only required when that is exhausted.
+	 * See `setTaskDelegateOverflow()`.
 	 * DO NOT use from interrupt context, use a Task/Interrupt callback.
 	 */
 	static bool queueCallback(TaskDelegate callback);
 
+	/**
+	 * @brief Set action to take when the deferred delegate pool is exhausted
+	 * @param policy Default is TaskDelegateOverflow::spill
+	 * @note This also applies if the task queue itself is full
+	 */
+	static void setTaskDelegateOverflow(TaskDelegateOverflow policy)
+	{
+		delegateOverflow = policy;
+	}
+
+	/**
+	 * @brief Get statistics for the deferred delegate pool
+	 */
+	static TaskDelegateStats getTaskDelegateStats();
+
 	/** @brief Get number of tasks currently on queue
 	 *  @retval unsigned
 	 */
@@ -228,25 +266,47 @@ public:
 	 *  @retval unsigned
 	 *  @note If return value is higher than maximum task queue TASK_QUEUE_LENGTH then
 	 *  the queue has overflowed at some point and tasks have been left un-executed.
+	 *  See also `getDroppedTaskCount()`.
 	 */
 	static unsigned getMaxTaskCount()
 	{
 #ifdef ENABLE_TASK_COUNT
 		return maxTaskCount;
+#elif defined(ARCH_HOST)
+		host_task_queue_stats_t stats;
+		return host_get_task_queue_stats(USER_TASK_PRIO_1, &stats) ? stats.high_water : 0;
 #else
 		return 255;
 #endif
 	}
 
+	/** @brief Get number of tasks which could not be queued because the queue was full
+	 *  @retval unsigned
+	 *  @note Always returns 0 if task counting is not available
+	 */
+	static unsigned getDroppedTaskCount()
+	{
+#ifdef ENABLE_TASK_COUNT
+		return droppedTaskCount;
+#elif defined(ARCH_HOST)
+		host_task_queue_stats_t stats;
+		return host_get_task_queue_stats(USER_TASK_PRIO_1, &stats) ? stats.dropped : 0;
+#else
+		return 0;
+#endif
+	}
+
 private:
 	static void taskHandler(os_event_t* event);
 
 private:
 	static SystemState state;
 	static os_event_t taskQueue[]; ///< OS task queue
+	static TaskDelegateOverflow delegateOverflow;
 #ifdef ENABLE_TASK_COUNT
-	static volatile uint8_t taskCount;	///< Number of tasks on queue
-	static volatile uint8_t maxTaskCount; ///< Profiling to establish appropriate queue size
+	static volatile uint8_t taskCount;		   ///< Number of tasks on queue
+	static volatile uint8_t maxTaskCount;	   ///< Profiling to establish appropriate queue size
+	static volatile uint16_t droppedTaskCount; ///< Number of tasks rejected because queue was full
 #endif
 };
 
@@ -0,0 +1,229 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WHashIndex.h - Optional hashed key lookup for HashMap and ObjectMap
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Default hash function object for hashed map lookups
+ * @tparam K Key type
+ * @note Integral and enumerated types are supported, as are string-like types
+ * such as String which provide `c_str()` and `length()`.
+ * Other key types fall back to `std::hash`.
+ * @ingroup wiring
+ */
+template <typename K, typename = void> struct HashMapHash {
+	uint32_t operator()(const K& key) const
+	{
+		return std::hash<K>{}(key);
+	}
+};
+
+template <typename K>
+struct HashMapHash<K, typename std::enable_if<std::is_integral<K>::value || std::is_enum<K>::value>::type> {
+	uint32_t operator()(const K& key) const
+	{
+		return uint32_t(key) * 2654435769U;
+	}
+};
+
+template <typename K>
+struct HashMapHash<K, decltype(void(std::declval<const K&>().c_str()), void(std::declval<const K&>().length()))> {
+	uint32_t operator()(const K& key) const
+	{
+		// FNV-1a
+		uint32_t hash{2166136261U};
+		auto s = key.c_str();
+		for(size_t i = 0; i < key.length(); ++i) {
+			hash ^= uint8_t(s[i]);
+			hash *= 16777619U;
+		}
+		return hash;
+	}
+};
+
+namespace wiring_private
+{
+/**
+ * @brief Open-addressing index of list positions, keyed by hash
+ * @tparam K Key type
+ * @tparam Hash Hash function object, or `void` for plain linear search
+ *
+ * The list owner retains its entries in insertion order, so index positions
+ * are independent of the hash. Lists with fewer than `minCount` entries are
+ * always searched linearly and the table is not allocated.
+ * The table is rebuilt on demand after entries are removed or re-ordered.
+ *
+ * Lookup functions take the following arguments:
+ *
+ * - `getKey(unsigned pos)` returns the key at a list position
+ * - `equal(const K& k1, const K& k2)` returns true if keys match
+ */
+template <typename K, typename Hash> class HashIndex
+{
+public:
+	static constexpr unsigned minCount{8}; ///< Use linear search for smaller lists
+
+	HashIndex() = default;
+	HashIndex(const HashIndex&) = delete;
+	HashIndex& operator=(const HashIndex&) = delete;
+
+	~HashIndex()
+	{
+		free(slots);
+	}
+
+	/**
+	 * @brief Find list position for a key
+	 * @param key Key to locate
+	 * @param count Number of entries in the list
+	 * @retval int Position of key, -1 if not found
+	 */
+	template <typename GetKey, typename Equal>
+	int find(const K& key, unsigned count, GetKey getKey, Equal equal) const
+	{
+		if(count >= minCount && count < emptySlot && (indexed == count || build(count, getKey))) {
+			for(auto i = slotFor(key);; i = (i + 1) & (tableSize - 1)) {
+				auto pos = slots[i];
+				if(pos == emptySlot) {
+					return -1;
+				}
+				if(equal(key, getKey(pos))) {
+					return pos;
+				}
+			}
+		}
+
+		for(unsigned i = 0; i < count; ++i) {
+			if(equal(key, getKey(i))) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Update index after appending a new entry to the list
+	 * @param pos Position of the new entry, which must be last
+	 */
+	template <typename GetKey> void add(unsigned pos, GetKey getKey)
+	{
+		if(indexed != pos || indexed == 0 || (pos + 1) * 2 > tableSize) {
+			// Rebuild on next lookup
+			indexed = 0;
+			return;
+		}
+		insert(getKey(pos), pos);
+		++indexed;
+	}
+
+	/**
+	 * @brief Call when list entries have been removed, re-ordered or keys modified
+	 */
+	void invalidate()
+	{
+		indexed = 0;
+	}
+
+	/**
+	 * @brief Release index memory
+	 */
+	void clear()
+	{
+		free(slots);
+		slots = nullptr;
+		tableSize = 0;
+		indexed = 0;
+	}
+
+private:
+	static constexpr uint16_t emptySlot{0xffff};
+
+	unsigned slotFor(const K& key) const
+	{
+		uint32_t hash = Hash{}(key);
+		return (hash ^ (hash >> 16)) & (tableSize - 1);
+	}
+
+	void insert(const K& key, unsigned pos) const
+	{
+		auto i = slotFor(key);
+		while(slots[i] != emptySlot) {
+			i = (i + 1) & (tableSize - 1);
+		}
+		slots[i] = pos;
+	}
+
+	template <typename GetKey> bool build(unsigned count, GetKey getKey) const
+	{
+		// Keep table at most half full
+		unsigned size{16};
+		while(size < count * 2) {
+			size <<= 1;
+		}
+		if(size != tableSize) {
+			auto mem = realloc(slots, size * sizeof(uint16_t));
+			if(mem == nullptr) {
+				return false;
+			}
+			slots = static_cast<uint16_t*>(mem);
+			tableSize = size;
+		}
+
+		memset(slots, 0xff, tableSize * sizeof(uint16_t));
+		for(unsigned i = 0; i < count; ++i) {
+			insert(getKey(i), i);
+		}
+		indexed = count;
+		return true;
+	}
+
+	mutable uint16_t* slots{nullptr}; ///< List positions, emptySlot if unused
+	mutable unsigned tableSize{0};	  ///< Number of slots, always a power of 2
+	mutable unsigned indexed{0};	  ///< Number of list entries in table, 0 if invalid
+};
+
+/**
+ * @brief Plain linear search with no additional storage
+ */
+template <typename K> class HashIndex<K, void>
+{
+public:
+	template <typename GetKey, typename Equal>
+	int find(const K& key, unsigned count, GetKey getKey, Equal equal) const
+	{
+		for(unsigned i = 0; i < count; ++i) {
+			if(equal(key, getKey(i))) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	template <typename GetKey> void add(unsigned, GetKey)
+	{
+	}
+
+	void invalidate()
+	{
+	}
+
+	void clear()
+	{
+	}
+};
+
+} // namespace wiring_private
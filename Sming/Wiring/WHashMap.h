@@ -32,13 +32,20 @@
 #include <iterator>
 #include <cstdlib>
 #include "WiringList.h"
+#include "WHashIndex.h"
 #include "Print.h"
 
 /**
  * @brief HashMap class template
+ * @tparam K Key type
+ * @tparam V Value type
+ * @tparam Hash By default keys are located by linear search. Specify a hash function object,
+ * such as `HashMapHash<K>`, to maintain an index for faster lookups in larger maps.
+ * Entries are still stored, and iterated, in insertion order.
+ * If a custom comparator is used then the hash function must be consistent with it.
  * @ingroup wiring
  */
-template <typename K, typename V> class HashMap
+template <typename K, typename V, typename Hash = void> class HashMap : private wiring_private::HashIndex<K, Hash>
 {
 public:
 	template <bool is_const> struct BaseElement {
@@ -157,7 +164,8 @@ public:
 
 		BaseElement<is_const> operator*()
 		{
-			return BaseElement<is_const>{map.keyAt(index), map.valueAt(index)};
+			// Keys are read-only so use const keyAt() to preserve any hash index
+			return BaseElement<is_const>{std::as_const(map).keyAt(index), map.valueAt(index)};
 		}
 
 		ElementConst operator*() const
@@ -232,6 +240,8 @@ public:
 		if(idx >= count()) {
 			abort();
 		}
+		// Key may be modified
+		hashIndex().invalidate();
 		return keys[idx];
 	}
 
@@ -296,11 +306,55 @@ public:
     */
 	V& operator[](const K& key);
 
+	/**
+	 * @brief Access a value by key, moving the key into the map if it is added
+	 */
+	V& operator[](K&& key);
+
+	/**
+	 * @brief Add or replace an entry
+	 * @param key
+	 * @param value
+	 * @retval V& Reference to the stored value
+	 *
+	 * New entries are constructed directly from the arguments rather than copying the nil value
+	 * and then assigning it.
+	 */
+	V& set(K key, V value);
+
+	/**
+	 * @brief Ensure there is space for at least the given number of entries
+	 * @param newSize
+	 * @retval bool false on memory allocation failure
+	 *
+	 * Call before adding a known number of entries to avoid repeated reallocation.
+	 */
 	bool allocate(unsigned int newSize)
 	{
 		return keys.allocate(newSize) && values.allocate(newSize);
 	}
 
+	/**
+	 * @brief Release any unused capacity
+	 */
+	void trimToSize()
+	{
+		if(currentIndex == 0) {
+			clear();
+			return;
+		}
+		keys.trim(currentIndex, true);
+		values.trim(currentIndex, true);
+	}
+
+	/**
+	 * @brief Get the number of entries which may be stored without reallocating
+	 */
+	unsigned int capacity() const
+	{
+		return std::min(keys.size, values.size);
+	}
+
 	/**
 	 * @brief Sort map entries
 	 */
@@ -317,16 +371,9 @@ public:
     */
 	int indexOf(const K& key) const
 	{
-		for(unsigned i = 0; i < currentIndex; i++) {
-			if(cb_comparator) {
-				if(cb_comparator(key, keys[i])) {
-					return i;
-				}
-			} else if(key == keys[i]) {
-				return i;
-			}
-		}
-		return -1;
+		return hashIndex().find(
+			key, currentIndex, [this](unsigned i) -> const K& { return keys[i]; },
+			[this](const K& key1, const K& key2) { return cb_comparator ? cb_comparator(key1, key2) : key1 == key2; });
 	}
 
 	/*
@@ -360,6 +407,7 @@ public:
 		values.remove(index);
 
 		currentIndex--;
+		hashIndex().invalidate();
 	}
 
 	/*
@@ -382,10 +430,12 @@ public:
 		keys.clear();
 		values.clear();
 		currentIndex = 0;
+		hashIndex().clear();
 	}
 
-	void setMultiple(const HashMap<K, V>& map)
+	template <typename H> void setMultiple(const HashMap<K, V, H>& map)
 	{
+		allocate(count() + map.count());
 		for(auto e : map) {
 			(*this)[e.key()] = e.value();
 		}
@@ -417,6 +467,7 @@ public:
 	}
 
 protected:
+	using HashIndex = wiring_private::HashIndex<K, Hash>;
 	using KeyList = wiring_private::List<K>;
 	using ValueList = wiring_private::List<V>;
 
@@ -427,26 +478,66 @@ protected:
 	V nil{};
 
 private:
-	HashMap(const HashMap<K, V>& that);
+	HashIndex& hashIndex()
+	{
+		return *this;
+	}
+
+	const HashIndex& hashIndex() const
+	{
+		return *this;
+	}
+
+	template <typename Key, typename Value> V& addEntry(Key&& key, Value&& value);
+
+	HashMap(const HashMap& that);
 	HashMap& operator=(const HashMap& that);
 };
 
-template <typename K, typename V> V& HashMap<K, V>::operator[](const K& key)
+template <typename K, typename V, typename Hash>
+template <typename Key, typename Value>
+V& HashMap<K, V, Hash>::addEntry(Key&& key, Value&& value)
+{
+	if(currentIndex >= capacity() && !allocate(wiring_private::growCapacity(capacity(), currentIndex + 1, 4))) {
+		return nil;
+	}
+	keys.emplace(currentIndex, std::forward<Key>(key));
+	values.emplace(currentIndex, std::forward<Value>(value));
+	currentIndex++;
+	hashIndex().add(currentIndex - 1, [this](unsigned i) -> const K& { return std::as_const(keys)[i]; });
+	return values[currentIndex - 1];
+}
+
+template <typename K, typename V, typename Hash> V& HashMap<K, V, Hash>::operator[](const K& key)
+{
+	int i = indexOf(key);
+	if(i >= 0) {
+		return values[i];
+	}
+	return addEntry(key, nil);
+}
+
+template <typename K, typename V, typename Hash> V& HashMap<K, V, Hash>::operator[](K&& key)
 {
 	int i = indexOf(key);
 	if(i >= 0) {
 		return values[i];
 	}
-	if(currentIndex >= values.size) {
-		allocate(currentIndex + ((values.size < 16) ? 4 : 16));
+	return addEntry(std::move(key), nil);
+}
+
+template <typename K, typename V, typename Hash> V& HashMap<K, V, Hash>::set(K key, V value)
+{
+	int i = indexOf(key);
+	if(i >= 0) {
+		V& v = values[i];
+		v = std::move(value);
+		return v;
 	}
-	keys[currentIndex] = key;
-	values[currentIndex] = nil;
-	currentIndex++;
-	return values[currentIndex - 1];
+	return addEntry(std::move(key), std::move(value));
 }
 
-template <typename K, typename V> void HashMap<K, V>::sort(SortCompare compare)
+template <typename K, typename V, typename Hash> void HashMap<K, V, Hash>::sort(SortCompare compare)
 {
 	auto n = count();
 	for(unsigned i = 0; i < n - 1; ++i) {
@@ -454,9 +545,10 @@ template <typename K, typename V> void HashMap<K, V>::sort(SortCompare compare)
 			HashMap::ElementConst e1{keys[j + 1], values[j + 1]};
 			HashMap::ElementConst e2{keys[j], values[j]};
 			if(compare(e1, e2)) {
-				std::swap(keys[j], keys[j + 1]);
-				std::swap(values[j], values[j + 1]);
+				keys.swap(j, j + 1);
+				values.swap(j, j + 1);
 			}
 		}
 	}
+	hashIndex().invalidate();
 }
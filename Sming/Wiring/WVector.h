@@ -170,14 +170,35 @@ public:
 		return addElement(obj);
 	}
 
+	bool add(Element&& obj)
+	{
+		return addElement(std::move(obj));
+	}
+
 	bool addElement(const Element& obj);
+	bool addElement(Element&& obj);
 	bool addElement(Element* objp);
 
+	/**
+	 * @brief Construct a new element at the end of the vector
+	 * @param args Arguments for the Element constructor
+	 * @retval bool false on memory allocation failure
+	 */
+	template <typename... Args> bool emplace(Args&&... args);
+
 	void clear()
 	{
 		removeAllElements();
 	}
 
+	/**
+	 * @brief Ensure there is space for at least the given number of elements
+	 * @param minCapacity
+	 * @retval bool false on memory allocation failure
+	 *
+	 * Call before adding a known number of elements to avoid repeated reallocation.
+	 * Capacity otherwise grows by `WIRING_LIST_GROWTH_PERCENT`, or by the capacity increment if larger.
+	 */
 	bool ensureCapacity(size_t minCapacity);
 
 	void removeAllElements()
@@ -363,6 +384,27 @@ template <class Element> bool Vector<Element>::addElement(const Element& obj)
 	return true;
 }
 
+template <class Element> bool Vector<Element>::addElement(Element&& obj)
+{
+	if(!ensureCapacity(_size + 1)) {
+		return false;
+	}
+	_data[_size++] = std::move(obj);
+	return true;
+}
+
+template <class Element> template <typename... Args> bool Vector<Element>::emplace(Args&&... args)
+{
+	if(!ensureCapacity(_size + 1)) {
+		return false;
+	}
+	if(!_data.emplace(_size, std::forward<Args>(args)...)) {
+		return false;
+	}
+	++_size;
+	return true;
+}
+
 template <class Element> bool Vector<Element>::addElement(Element* objp)
 {
 	if(!ensureCapacity(_size + 1)) {
@@ -378,7 +420,7 @@ template <class Element> bool Vector<Element>::ensureCapacity(size_t minCapacity
 		return true;
 	}
 
-	auto newCapacity = std::max(minCapacity, _data.size + _increment);
+	auto newCapacity = wiring_private::growCapacity(_data.size, minCapacity, _increment);
 	return _data.allocate(newCapacity);
 }
 
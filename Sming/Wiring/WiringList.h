@@ -11,9 +11,32 @@
 #pragma once
 
 #include <algorithm>
+#include <utility>
+
+/**
+ * @brief Minimum growth of Vector and HashMap storage, as a percentage of current capacity
+ */
+#ifndef WIRING_LIST_GROWTH_PERCENT
+#define WIRING_LIST_GROWTH_PERCENT 50
+#endif
 
 namespace wiring_private
 {
+/**
+ * @brief Calculate new capacity for a list which must be enlarged
+ * @param capacity Current capacity
+ * @param minCapacity Capacity required
+ * @param increment Minimum number of entries to add
+ * @retval size_t New capacity
+ *
+ * Growing geometrically keeps the number of reallocations logarithmic as a list is filled.
+ */
+inline size_t growCapacity(size_t capacity, size_t minCapacity, size_t increment)
+{
+	auto growth = std::max(increment, capacity * WIRING_LIST_GROWTH_PERCENT / 100);
+	return std::max(minCapacity, capacity + growth);
+}
+
 /**
  * @brief List of scalar values
  */
@@ -44,22 +67,39 @@ template <typename T> struct ScalarList {
 
 	bool insert(unsigned index, T value)
 	{
-		memmove(&values[index + 1], &values[index], size - index - 1);
+		memmove(&values[index + 1], &values[index], (size - index - 1) * sizeof(T));
 		values[index] = value;
 		return true;
 	}
 
+	template <typename... Args> bool emplace(unsigned index, Args&&... args)
+	{
+		values[index] = T(std::forward<Args>(args)...);
+		return true;
+	}
+
 	void remove(unsigned index)
 	{
 		memmove(&values[index], &values[index + 1], (size - index - 1) * sizeof(T));
 	}
 
+	void swap(unsigned index1, unsigned index2)
+	{
+		std::swap(values[index1], values[index2]);
+	}
+
 	void trim(size_t newSize, bool reallocate)
 	{
 		if(!reallocate) {
 			return;
 		}
 
+		// realloc() may free memory and return nullptr for zero size
+		if(newSize == 0) {
+			clear();
+			return;
+		}
+
 		auto newmem = realloc(values, sizeof(T) * newSize);
 		if(newmem == nullptr) {
 			return;
@@ -102,6 +142,13 @@ template <typename T> struct ObjectList : public ScalarList<T*> {
 			return *this;
 		}
 
+		Element& operator=(T&& v)
+		{
+			delete value;
+			value = new T(std::move(v));
+			return *this;
+		}
+
 		operator T&()
 		{
 			return *value;
@@ -138,6 +185,20 @@ template <typename T> struct ObjectList : public ScalarList<T*> {
 		return ScalarList<T*>::insert(index, el);
 	}
 
+	/**
+	 * @brief Construct a new object, replacing any existing one at this position
+	 */
+	template <typename... Args> bool emplace(unsigned index, Args&&... args)
+	{
+		auto el = new T(std::forward<Args>(args)...);
+		if(el == nullptr) {
+			return false;
+		}
+		delete this->values[index];
+		this->values[index] = el;
+		return true;
+	}
+
 	void remove(unsigned index)
 	{
 		delete this->values[index];
@@ -102,11 +102,31 @@ COMPONENT_VARS		+= TASK_QUEUE_LENGTH
 TASK_QUEUE_LENGTH	?= 10
 COMPONENT_CXXFLAGS	+= -DTASK_QUEUE_LENGTH=$(TASK_QUEUE_LENGTH)
 
+# Number of deferred delegates which may be queued without heap allocation
+COMPONENT_VARS			+= TASK_DELEGATE_POOL_SIZE
+TASK_DELEGATE_POOL_SIZE	?= 8
+COMPONENT_CXXFLAGS		+= -DTASK_DELEGATE_POOL_SIZE=$(TASK_DELEGATE_POOL_SIZE)
+
+# Inline storage for Delegate callables, in pointer-sized words
+COMPONENT_VARS			+= DELEGATE_STORAGE_WORDS
+DELEGATE_STORAGE_WORDS	?= 4
+GLOBAL_CFLAGS			+= -DDELEGATE_STORAGE_WORDS=$(DELEGATE_STORAGE_WORDS)
+
+# Allocate Delegate callables which don't fit inline storage on the heap, otherwise fail compilation
+COMPONENT_VARS			+= DELEGATE_HEAP_FALLBACK
+DELEGATE_HEAP_FALLBACK	?= 1
+GLOBAL_CFLAGS			+= -DDELEGATE_HEAP_FALLBACK=$(DELEGATE_HEAP_FALLBACK)
+
 # Size of a String object - change this to increase space for Small String Optimisation (SSO)
 COMPONENT_VARS		+= STRING_OBJECT_SIZE
 STRING_OBJECT_SIZE	?= 12
 GLOBAL_CFLAGS		+= -DSTRING_OBJECT_SIZE=$(STRING_OBJECT_SIZE) 
 
+# Minimum growth of Vector and HashMap storage, as a percentage of current capacity
+COMPONENT_VARS				+= WIRING_LIST_GROWTH_PERCENT
+WIRING_LIST_GROWTH_PERCENT	?= 50
+GLOBAL_CFLAGS				+= -DWIRING_LIST_GROWTH_PERCENT=$(WIRING_LIST_GROWTH_PERCENT)
+
 ##@Flashing
 
 .PHONY: flashinit
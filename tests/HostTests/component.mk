@@ -24,7 +24,8 @@ ifeq ($(SMING_ARCH),Host)
 endif
 
 COMPONENT_DEPENDS := \
-	malloc_count
+	malloc_count \
+	uzlib
 
 ifneq ($(DISABLE_NETWORK),1)
 COMPONENT_SRCDIRS += \
@@ -33,6 +34,8 @@ COMPONENT_SRCDIRS += \
 COMPONENT_DEPENDS += \
 	axtls-8266 \
 	bearssl-esp8266
+# Keep retained connection timeout test short
+TCP_RETAINED_CONNECTION_TIMEOUT := 4
 endif
 
 ifeq ($(UNAME),Windows)
@@ -25,6 +25,7 @@
 	XX(String)                                                                                                         \
 	XX(ArduinoString)                                                                                                  \
 	XX(Wiring)                                                                                                         \
+	XX(Delegate)                                                                                                       \
 	XX_NET(Crypto)                                                                                                     \
 	XX(CStringArray)                                                                                                   \
 	XX(Stream)                                                                                                         \
@@ -37,6 +38,8 @@
 	XX(Uuid)                                                                                                           \
 	XX_NET(Http)                                                                                                       \
 	XX_NET(Url)                                                                                                        \
+	XX_NET(Mqtt)                                                                                                       \
+	XX_NET(Udp)                                                                                                        \
 	XX(ArduinoJson5)                                                                                                   \
 	XX(ArduinoJson6)                                                                                                   \
 	XX(Storage)                                                                                                        \
@@ -0,0 +1,133 @@
+#include <HostTests.h>
+
+#include <Delegate.h>
+#include <malloc_count.h>
+
+namespace
+{
+int add(int a, int b)
+{
+	return a + b;
+}
+
+class Adder
+{
+public:
+	Adder(int base) : base(base)
+	{
+	}
+
+	int add(int a, int b)
+	{
+		return base + a + b;
+	}
+
+private:
+	int base;
+};
+
+} // namespace
+
+class DelegateTest : public TestGroup
+{
+public:
+	DelegateTest() : TestGroup(_F("Delegate"))
+	{
+	}
+
+	void execute() override
+	{
+		using Callback = Delegate<int(int, int)>;
+
+		TEST_CASE("Empty delegates")
+		{
+			Callback d1;
+			REQUIRE(!d1);
+			REQUIRE(d1 == nullptr);
+			Callback d2(nullptr);
+			REQUIRE(!d2);
+			int (*fn)(int, int) = nullptr;
+			Callback d3(fn);
+			REQUIRE(!d3);
+			std::function<int(int, int)> func;
+			Callback d4(func);
+			REQUIRE(!d4);
+		}
+
+		TEST_CASE("Inline storage")
+		{
+			Adder adder(10);
+			int offset = 5;
+
+#if ENABLE_MALLOC_COUNT
+			auto allocCount = MallocCount::getAllocCount();
+#endif
+
+			Callback d1(add);
+			Callback d2(&Adder::add, &adder);
+			Callback d3 = [&adder, offset](int a, int b) { return adder.add(a, b) + offset; };
+			Callback d4 = std::bind(&Adder::add, &adder, _1, _2);
+
+			REQUIRE_EQ(d1(1, 2), 3);
+			REQUIRE_EQ(d2(1, 2), 13);
+			REQUIRE_EQ(d3(1, 2), 18);
+			REQUIRE_EQ(d4(1, 2), 13);
+
+			// Copy, move and re-assign
+			Callback d5 = d3;
+			REQUIRE_EQ(d5(0, 0), 15);
+			Callback d6 = std::move(d5);
+			REQUIRE(!d5);
+			REQUIRE_EQ(d6(0, 0), 15);
+			d6 = d2;
+			REQUIRE_EQ(d6(0, 0), 10);
+			d1.swap(d2);
+			REQUIRE_EQ(d1(0, 0), 10);
+			REQUIRE_EQ(d2(0, 0), 0);
+
+#if ENABLE_MALLOC_COUNT
+			REQUIRE_EQ(MallocCount::getAllocCount(), allocCount);
+#endif
+		}
+
+		TEST_CASE("Heap storage")
+		{
+			String s = F("Captured string which is too long to fit in a String object");
+			char buffer[64]{"test"};
+			auto callback = [s, buffer]() -> String { return s + buffer; };
+			REQUIRE(!Delegate<String()>::isInline<decltype(callback)>());
+
+#if ENABLE_MALLOC_COUNT
+			auto allocCount = MallocCount::getAllocCount();
+			Delegate<String()> d1 = callback;
+			REQUIRE(MallocCount::getAllocCount() > allocCount);
+#else
+			Delegate<String()> d1 = callback;
+#endif
+			auto d2 = d1;
+			REQUIRE(d2() == s + "test");
+			auto d3 = std::move(d1);
+			REQUIRE(!d1);
+			REQUIRE(d3() == d2());
+		}
+
+		TEST_CASE("Return value conversion")
+		{
+			int count{0};
+			// Return value is discarded
+			Delegate<void()> d1 = [&count]() { return ++count; };
+			d1();
+			d1();
+			REQUIRE_EQ(count, 2);
+			// Generic lambda
+			Delegate<void(int&)> d2 = [](auto& value) { value *= 2; };
+			d2(count);
+			REQUIRE_EQ(count, 4);
+		}
+	}
+};
+
+void REGISTER_TEST(Delegate)
+{
+	registerGroup<DelegateTest>();
+}
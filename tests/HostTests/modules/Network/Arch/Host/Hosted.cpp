@@ -17,6 +17,13 @@ static uint32_t plusCommand(uint8_t a, uint16_t b)
 	return a + b;
 };
 
+unsigned countCalls;
+
+static void countCommand(uint8_t)
+{
+	++countCalls;
+}
+
 class TheWire
 {
 public:
@@ -137,7 +144,8 @@ public:
 					makeTuple(&theWire, static_cast<uint8_t(TheWire::*)(uint8_t,uint8_t)>(&TheWire::begin)), "TheWire::begin> Starts two-wire communication. @sda: Data pin. @scl: Clock pin.",
 					// void TheWire::begin()
 					makeTuple(&theWire, static_cast<void(TheWire::*)()>(&TheWire::begin)), "TheWire::begin> Starts two-wire communication.",
-					makeTuple(&theWire, &TheWire::getCalled), "TheWire::getCalled> Gets times called. @return: Result."
+					makeTuple(&theWire, &TheWire::getCalled), "TheWire::getCalled> Gets times called. @return: Result.",
+					countCommand, "countCommand> Count number of calls. @value: Ignored."
 				);
 			// clang-format on
 
@@ -178,6 +186,73 @@ public:
 			REQUIRE_EQ(hostedClient.wait<uint8_t>(), 6);
 		}
 
+		TEST_CASE("Client cached command and futures")
+		{
+			Hosted::Command plus("plusCommand");
+			REQUIRE_EQ(hostedClient.getFunctionId(plus), 2);
+			auto res1 = hostedClient.call<uint32_t>(plus, uint8_t(1), uint16_t(2));
+			auto res2 = hostedClient.call<uint32_t>(plus, uint8_t(3), uint16_t(4));
+			REQUIRE(res1.isValid());
+			REQUIRE_EQ(hostedClient.getPendingCount(), 2U);
+			// Results arrive in order
+			REQUIRE_EQ(res2.get(), 7U);
+			REQUIRE(res1.isReady());
+			REQUIRE_EQ(res1.get(), 3U);
+			REQUIRE_EQ(hostedClient.getPendingCount(), 0U);
+
+			Hosted::Command unknown("unknownCommand");
+			REQUIRE(!hostedClient.call<uint32_t>(unknown).isValid());
+		}
+
+		TEST_CASE("Client benchmark")
+		{
+			constexpr unsigned callCount{200}; // Pipelined results must fit in receive buffer
+			Hosted::Command plus("plusCommand");
+			Hosted::Command count("countCommand");
+
+			auto printRate = [](const String& title, unsigned calls, uint32_t elapsed) {
+				Serial << title << ": " << calls << _F(" calls in ") << elapsed << _F("us, ")
+					   << (elapsed ? uint64_t(calls) * 1000000 / elapsed : 0) << _F(" calls/s") << endl;
+			};
+
+			ElapseTimer timer;
+			for(unsigned i = 0; i < callCount; ++i) {
+				hostedClient.send("plusCommand", uint8_t(i), uint16_t(i));
+				hostedClient.wait<uint32_t>();
+			}
+			printRate(F("Round-trip, by name"), callCount, timer.elapsedTime());
+
+			timer.start();
+			for(unsigned i = 0; i < callCount; ++i) {
+				hostedClient.send(plus, uint8_t(i), uint16_t(i));
+				hostedClient.wait<uint32_t>();
+			}
+			printRate(F("Round-trip, cached ID"), callCount, timer.elapsedTime());
+
+			timer.start();
+			Hosted::Future<uint32_t> results[callCount];
+			for(unsigned i = 0; i < callCount; ++i) {
+				results[i] = hostedClient.call<uint32_t>(plus, uint8_t(i), uint16_t(i));
+			}
+			for(unsigned i = 0; i < callCount; ++i) {
+				REQUIRE_EQ(results[i].get(), uint8_t(i) + uint16_t(i));
+			}
+			printRate(F("Pipelined futures"), callCount, timer.elapsedTime());
+
+			timer.start();
+			countCalls = 0;
+			{
+				Hosted::Client::Batch batch(hostedClient);
+				for(unsigned i = 0; i < callCount; ++i) {
+					hostedClient.send(count, uint8_t(i));
+				}
+			}
+			// Synchronise with server
+			REQUIRE_EQ(hostedClient.call<uint32_t>(plus, uint8_t(0), uint16_t(0)).get(), 0U);
+			printRate(F("Batched void calls"), callCount, timer.elapsedTime());
+			REQUIRE_EQ(countCalls, callCount);
+		}
+
 		server->shutdown();
 	}
 };
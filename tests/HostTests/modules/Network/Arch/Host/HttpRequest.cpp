@@ -26,6 +26,63 @@ TestFile testFiles[]{
 	{"index.js", nullptr, MimeType::JS, ""},
 };
 
+/*
+ * Content of known length which can only be read sequentially
+ */
+class ForwardOnlyStream : public IDataSourceStream
+{
+public:
+	ForwardOnlyStream(const String& content) : content(content)
+	{
+	}
+
+	int available() override
+	{
+		return content.length() - pos;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override
+	{
+		auto len = std::min(size_t(bufSize), content.length() - pos);
+		memcpy(data, content.c_str() + pos, len);
+		return len;
+	}
+
+	int seekFrom(int offset, SeekOrigin origin) override
+	{
+		if(origin != SeekOrigin::Current || offset < 0 || pos + offset > content.length()) {
+			return -1;
+		}
+		pos += offset;
+		return pos;
+	}
+
+	bool isFinished() override
+	{
+		return pos >= content.length();
+	}
+
+private:
+	String content;
+	size_t pos{0};
+};
+
+struct RangeTest {
+	const char* path;
+	const char* range; ///< Omit for no Range header
+	HttpStatus code;
+	size_t length; ///< Expected Content-Length
+};
+
+// Forward-only content must be sent in full, not as a truncated partial response.
+// Content positioned by the handler starts at that position.
+RangeTest rangeTests[]{
+	{"index.html", "bytes=0-9", HTTP_STATUS_PARTIAL_CONTENT, 10},
+	{"forward", "bytes=5-9", HTTP_STATUS_OK, 100},
+	{"offset", nullptr, HTTP_STATUS_OK, 60},
+	{"offset", "bytes=50-", HTTP_STATUS_PARTIAL_CONTENT, 10},
+};
+
 } // namespace
 
 class HttpRequestTest : public TestGroup
@@ -45,6 +102,18 @@ public:
 		REQUIRE(fwfs_mount(Storage::findPartition("fwfs_httprequest")));
 
 		server->listen(80);
+		server->paths.set("/forward", [](HttpRequest&, HttpResponse& response) {
+			String content;
+			content.pad(100, '.');
+			response.sendDataStream(new ForwardOnlyStream(content), MIME_TEXT);
+		});
+		server->paths.set("/offset", [](HttpRequest&, HttpResponse& response) {
+			String content;
+			content.pad(100, '.');
+			auto stream = new MemoryDataStream(std::move(content));
+			stream->seek(40);
+			response.sendDataStream(stream, MIME_TEXT);
+		});
 		server->paths.setDefault([](HttpRequest& request, HttpResponse& response) {
 			auto path = request.uri.getRelativePath();
 			bool ok = response.sendFile(path);
@@ -59,7 +128,7 @@ public:
 	void requestNextFile()
 	{
 		if(fileIndex >= ARRAY_SIZE(testFiles)) {
-			shutdown();
+			requestNextRange();
 			return;
 		}
 
@@ -89,6 +158,40 @@ public:
 		debug_i("Requested '%s': %s", file.name, ok ? "OK" : "FAIL");
 	}
 
+	void requestNextRange()
+	{
+		if(rangeIndex >= ARRAY_SIZE(rangeTests)) {
+			shutdown();
+			return;
+		}
+
+		auto& test = rangeTests[rangeIndex++];
+		Url url;
+		url.Host = WifiStation.getIP().toString();
+		url.Port = 80;
+		url.Path = String('/') + test.path;
+
+		auto req = new HttpRequest(url);
+		if(test.range != nullptr) {
+			req->headers[HTTP_HEADER_RANGE] = test.range;
+		}
+		req->onRequestComplete([this, test](HttpConnection& connection, bool) -> int {
+			auto response = connection.getResponse();
+			debug_i("Client received '%s' for range '%s'", connection.getRequest()->uri.toString().c_str(),
+					test.range ?: "none");
+			Serial.print(response->toString());
+
+			REQUIRE(response->code == test.code);
+			REQUIRE(response->headers[HTTP_HEADER_CONTENT_LENGTH] == String(test.length));
+
+			Serial.println();
+
+			requestNextRange();
+			return 0;
+		});
+		client.send(req);
+	}
+
 	void shutdown()
 	{
 		server->shutdown();
@@ -100,6 +203,7 @@ public:
 private:
 	HttpServer* server{nullptr};
 	unsigned fileIndex{0};
+	unsigned rangeIndex{0};
 	HttpClient client;
 	Timer timer;
 };
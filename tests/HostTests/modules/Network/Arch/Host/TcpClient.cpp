@@ -3,7 +3,47 @@
 #include <Network/TcpClient.h>
 #include <Network/TcpServer.h>
 #include <Data/Stream/MemoryDataStream.h>
+#include <Data/Stream/LimitedMemoryStream.h>
 #include <Platform/Station.h>
+#include <malloc_count.h>
+
+namespace
+{
+/*
+ * Hides peekBuffer() so content is copied through the TCP send buffer
+ */
+class CopyStream : public IDataSourceStream
+{
+public:
+	CopyStream(IDataSourceStream* source) : source(source)
+	{
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override
+	{
+		return source->readMemoryBlock(data, bufSize);
+	}
+
+	bool seek(int len) override
+	{
+		return source->seek(len);
+	}
+
+	bool isFinished() override
+	{
+		return source->isFinished();
+	}
+
+	int available() override
+	{
+		return source->available();
+	}
+
+private:
+	std::unique_ptr<IDataSourceStream> source;
+};
+
+} // namespace
 
 class TcpClientTest : public TestGroup
 {
@@ -96,7 +136,208 @@ private:
 	volatile bool finished = false;
 };
 
+class TcpTransmitBenchmark : public TestGroup
+{
+public:
+	TcpTransmitBenchmark() : TestGroup(_F("TCP transmit benchmark"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		server = new TcpServer([this](TcpClient&, char*, int size) -> bool {
+			received += size;
+			if(received == responseSize) {
+				System.queueCallback([this]() { runComplete(); });
+			}
+			return true;
+		});
+		server->listen(port);
+		server->setTimeOut(USHRT_MAX);
+		server->setKeepAlive(USHRT_MAX);
+
+		startRun();
+		pending();
+	}
+
+	void startRun()
+	{
+		auto buffer = malloc(responseSize);
+		REQUIRE(buffer != nullptr);
+		memset(buffer, 'A' + run, responseSize);
+		IDataSourceStream* stream = new LimitedMemoryStream(buffer, responseSize, responseSize, true);
+		if(run == 0) {
+			stream = new CopyStream(stream);
+		}
+
+		received = 0;
+		client.reset(new TcpClient(false));
+		client->connect(WifiStation.getIP(), port);
+
+		allocCount = MallocCount::getAllocCount();
+		MallocCount::resetTotal();
+		MallocCount::resetPeak();
+		startMem = MallocCount::getCurrent();
+		timer.start();
+		client->send(stream);
+		client->commit();
+	}
+
+	void runComplete()
+	{
+		auto elapsed = timer.elapsedTime();
+		auto bytesPerSec = uint64_t(responseSize) * 1000000U / std::max(uint32_t(elapsed), 1U);
+		Serial << (run == 0 ? _F("Copy") : _F("Reference")) << _F(": ") << responseSize << _F(" bytes in ")
+			   << elapsed.toString() << _F(", ") << bytesPerSec << _F(" bytes/sec") << endl;
+		Serial << _F("  Allocations: ") << MallocCount::getAllocCount() - allocCount << _F(", total ")
+			   << MallocCount::getTotal() << _F(" bytes, peak +") << MallocCount::getPeak() - startMem << endl;
+
+		client.reset();
+		if(++run < 2) {
+			startRun();
+			return;
+		}
+
+		server->shutdown();
+		server = nullptr;
+		complete();
+	}
+
+private:
+	static constexpr int port{9877};
+	static constexpr size_t responseSize{1024 * 1024};
+	TcpServer* server{nullptr};
+	std::unique_ptr<TcpClient> client;
+	OneShotFastUs timer;
+	size_t received{0};
+	size_t allocCount{0};
+	size_t startMem{0};
+	unsigned run{0};
+};
+
+/*
+ * Data written by reference is never acknowledged, so a closed connection
+ * must abort after TCP_RETAINED_CONNECTION_TIMEOUT and release its streams
+ */
+class TcpRetainedTimeoutTest : public TestGroup
+{
+public:
+	TcpRetainedTimeoutTest() : TestGroup(_F("TCP retained connection timeout"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		TEST_CASE("Abort unacknowledged connection")
+		{
+			// Raw listener which never opens its receive window
+			auto pcb = tcp_new();
+			REQUIRE(pcb != nullptr);
+			REQUIRE_EQ(tcp_bind(pcb, IP_ADDR_ANY, port), ERR_OK);
+			listener = tcp_listen(pcb);
+			REQUIRE(listener != nullptr);
+			tcp_arg(listener, this);
+			tcp_accept(listener, [](void* arg, tcp_pcb* newpcb, err_t) -> err_t {
+				auto self = static_cast<TcpRetainedTimeoutTest*>(arg);
+				self->peer = newpcb;
+				tcp_arg(newpcb, self);
+				tcp_recv(newpcb, [](void*, tcp_pcb*, pbuf* p, err_t) -> err_t {
+					// Discard data without calling tcp_recved()
+					if(p != nullptr) {
+						pbuf_free(p);
+					}
+					return ERR_OK;
+				});
+				tcp_err(newpcb, [](void* arg, err_t) { static_cast<TcpRetainedTimeoutTest*>(arg)->peer = nullptr; });
+				return ERR_OK;
+			});
+
+			auto buffer = malloc(contentSize);
+			REQUIRE(buffer != nullptr);
+			memset(buffer, 'A', contentSize);
+			auto stream = new TrackedStream(buffer, destroyed);
+
+			client.reset(new TcpClient(false));
+			REQUIRE(client->connect(WifiStation.getIP(), port));
+			REQUIRE(client->send(stream));
+
+			// Allow send window to fill, then close with data outstanding
+			timer.initializeMs<1000>([this]() {
+				REQUIRE(client->isReferencePending());
+				client->close();
+				client.reset();
+				REQUIRE(!destroyed);
+				checkTimer.initializeMs<500>([this]() { checkDestroyed(); }).start();
+			});
+			timer.startOnce();
+
+			pending();
+		}
+	}
+
+	void checkDestroyed()
+	{
+		++checkCount;
+		if(!destroyed) {
+			// Retained connection is polled every 2 seconds
+			REQUIRE(checkCount < 4 * (TCP_RETAINED_CONNECTION_TIMEOUT + 2));
+			return;
+		}
+
+		checkTimer.stop();
+		debug_i("Retained streams released after %u checks", checkCount);
+		if(peer != nullptr) {
+			tcp_arg(peer, nullptr);
+			tcp_abort(peer);
+			peer = nullptr;
+		}
+		tcp_close(listener);
+		listener = nullptr;
+		complete();
+	}
+
+private:
+	class TrackedStream : public LimitedMemoryStream
+	{
+	public:
+		TrackedStream(void* buffer, bool& destroyed)
+			: LimitedMemoryStream(buffer, contentSize, contentSize, true), destroyed(destroyed)
+		{
+		}
+
+		~TrackedStream()
+		{
+			destroyed = true;
+		}
+
+	private:
+		bool& destroyed;
+	};
+
+	static constexpr int port{9878};
+	static constexpr size_t contentSize{64 * 1024};
+	tcp_pcb* listener{nullptr};
+	tcp_pcb* peer{nullptr};
+	std::unique_ptr<TcpClient> client;
+	Timer timer;
+	Timer checkTimer;
+	unsigned checkCount{0};
+	bool destroyed{false};
+};
+
 void REGISTER_TEST(TcpClient)
 {
 	registerGroup<TcpClientTest>();
+	registerGroup<TcpTransmitBenchmark>();
+	registerGroup<TcpRetainedTimeoutTest>();
 }
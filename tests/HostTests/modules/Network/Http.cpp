@@ -2,8 +2,16 @@
 
 #include "Network/Http/HttpCommon.h"
 #include "Network/Http/HttpHeaders.h"
+#include "Network/Http/HttpResourceTree.h"
+#include "Network/Http/HttpBodyParser.h"
+#include "Network/Http/HttpRange.h"
+#include "Network/Http/HttpEtagCache.h"
+#include "Network/Http/HttpAcceptEncoding.h"
+#include <Data/Stream/ByteRangeStream.h>
+#include <Data/Stream/MemoryDataStream.h>
 #include <Data/WebConstants.h>
 #include <Platform/Timers.h>
+#include <malloc_count.h>
 
 class HttpTest : public TestGroup
 {
@@ -17,6 +25,12 @@ public:
 		testHttpCommon();
 		testHttpHeaders();
 		profileHttpHeaders();
+		testBodyParser();
+		testRanges();
+		testConditional();
+		testAcceptEncoding();
+		testResourceTree();
+		profileResourceTree();
 	}
 
 	void testHttpCommon()
@@ -117,9 +131,551 @@ public:
 		printHeaders(headers);
 		Serial << _F("  Elapsed: ") << timer.elapsedTime().toString() << endl;
 
+		// Serialize as for HTTP response
+		Serial.println(_F("Serialize headers"));
+		timer.start();
+		String s1;
+		for(auto hdr : headers) {
+			s1 += hdr;
+		}
+		auto stringElapsed = timer.elapsedTime();
+		timer.start();
+		String s2;
+		s2.setLength(headers.serialize(nullptr));
+		headers.serialize(s2.begin());
+		auto bufferElapsed = timer.elapsedTime();
+		REQUIRE(s1 == s2);
+		Serial << _F("  Strings: ") << stringElapsed.toString() << _F(", buffer: ") << bufferElapsed.toString() << endl;
+
 		delete headersPtr;
 	}
 
+	void testBodyParser()
+	{
+		DEFINE_FSTR_LOCAL(FS_form, "name=John+Smith&email=john%40example.com&pct=100%25&bad=%zz%4&empty=&flag&a%3Db=c=d&&")
+
+		// Feed content in small chunks to check fields and escapes are split correctly
+		auto parse = [](HttpRequest& request, const String& body, size_t chunkSize,
+						const HttpFormFieldDelegate& callback) {
+			request.headers[HTTP_HEADER_CONTENT_LENGTH] = body.length();
+			formUrlFieldParser(request, nullptr, PARSE_DATASTART, callback);
+			size_t consumed{0};
+			for(size_t pos = 0; pos < body.length(); pos += chunkSize) {
+				auto len = std::min(chunkSize, body.length() - pos);
+				consumed += formUrlFieldParser(request, body.c_str() + pos, len, callback);
+			}
+			formUrlFieldParser(request, nullptr, PARSE_DATAEND, callback);
+			return consumed;
+		};
+
+		TEST_CASE("Form URL parser")
+		{
+			String body(FS_form);
+			for(auto chunkSize : {1U, 2U, 3U, 100U}) {
+				HttpRequest request;
+				REQUIRE_EQ(parse(request, body, chunkSize, nullptr), body.length());
+				auto& params = request.postParams;
+				REQUIRE_EQ(params.count(), 7U);
+				REQUIRE(params["name"] == "John Smith");
+				REQUIRE(params["email"] == "john@example.com");
+				REQUIRE(params["pct"] == "100%");
+				REQUIRE(params["bad"] == "%zz%4");
+				REQUIRE(params["empty"] == "");
+				REQUIRE(params.contains("flag"));
+				REQUIRE(params["a=b"] == "c=d");
+				REQUIRE(request.args == nullptr);
+			}
+		}
+
+		TEST_CASE("Form URL parser callback")
+		{
+			String body(FS_form);
+			HttpRequest request;
+			unsigned fieldCount{0};
+			auto callback = [&](HttpRequest&, const char* name, size_t nameLength, const char* value,
+								size_t valueLength) {
+				REQUIRE_EQ(strlen(name), nameLength);
+				REQUIRE_EQ(strlen(value), valueLength);
+				++fieldCount;
+				return true;
+			};
+			REQUIRE_EQ(parse(request, body, 5, callback), body.length());
+			REQUIRE_EQ(fieldCount, 7U);
+			REQUIRE_EQ(request.postParams.count(), 0U);
+
+			// Callback aborts parsing
+			fieldCount = 0;
+			auto abort = [&](HttpRequest&, const char*, size_t, const char*, size_t) { return ++fieldCount < 2; };
+			REQUIRE(parse(request, body, body.length(), abort) < body.length());
+			REQUIRE_EQ(fieldCount, 2U);
+		}
+
+		TEST_CASE("Form URL parser heap usage")
+		{
+			String body;
+			for(unsigned i = 0; i < 100; ++i) {
+				body += F("field");
+				body += char('A' + i % 26);
+				body += char('A' + i / 26);
+				body += F("=some+value%21&");
+			}
+
+			HttpRequest request;
+#if ENABLE_MALLOC_COUNT
+			auto startMem = MallocCount::getCurrent();
+			MallocCount::resetPeak();
+#endif
+			REQUIRE_EQ(parse(request, body, 64, [](HttpRequest&, const char*, size_t, const char*, size_t) {
+						   return true;
+					   }),
+					   body.length());
+#if ENABLE_MALLOC_COUNT
+			auto peak = MallocCount::getPeak() - startMem;
+			Serial << _F("Form of ") << body.length() << _F(" bytes parsed with peak heap ") << peak << endl;
+			REQUIRE(peak <= HTTP_FORM_BUFFER_SIZE + 256);
+#endif
+
+			// Field too large for buffer
+			String field;
+			field.pad(HTTP_FORM_BUFFER_SIZE, 'x');
+			field = "a=" + field;
+			REQUIRE(parse(request, field, 100, nullptr) < field.length());
+			REQUIRE_EQ(request.postParams.count(), 0U);
+		}
+
+		TEST_CASE("Body to string parser")
+		{
+			auto parse = [&](HttpRequest& request, const String& body, size_t contentLength) {
+				request.headers[HTTP_HEADER_CONTENT_LENGTH] = contentLength;
+				bodyToStringParser(request, nullptr, PARSE_DATASTART);
+				auto stream = static_cast<MemoryDataStream*>(request.args);
+				REQUIRE(stream != nullptr);
+				REQUIRE(stream->getCapacity() <= HTTP_BODY_RESERVE_SIZE);
+				for(size_t pos = 0; pos < body.length(); pos += 100) {
+					auto len = std::min(size_t(100), body.length() - pos);
+					REQUIRE_EQ(bodyToStringParser(request, body.c_str() + pos, len), len);
+				}
+				bodyToStringParser(request, nullptr, PARSE_DATAEND);
+				REQUIRE(request.args == nullptr);
+			};
+
+			// Client claims a huge body
+			HttpRequest request;
+			String body = F("short body");
+			parse(request, body, 0x7fffffff);
+			REQUIRE(request.getBody() == body);
+
+			// Body larger than reservation
+			HttpRequest request2;
+			String largeBody;
+			largeBody.pad(HTTP_BODY_RESERVE_SIZE * 4 + 10, 'x');
+			parse(request2, largeBody, largeBody.length());
+			REQUIRE(request2.getBody() == largeBody);
+		}
+	}
+
+	void testRanges()
+	{
+		using Result = HttpRangeList::Result;
+		HttpRangeList ranges;
+
+		auto checkRange = [&](unsigned index, size_t first, size_t last) {
+			REQUIRE(index < ranges.count());
+			REQUIRE_EQ(ranges[index].first, first);
+			REQUIRE_EQ(ranges[index].last, last);
+		};
+
+		TEST_CASE("Range parsing")
+		{
+			REQUIRE(ranges.parse("bytes=0-499", 1000) == Result::satisfiable);
+			REQUIRE_EQ(ranges.count(), 1U);
+			checkRange(0, 0, 499);
+			REQUIRE_EQ(HttpRangeList::contentRange(ranges[0], 1000), "bytes 0-499/1000");
+
+			REQUIRE(ranges.parse("bytes=500-", 1000) == Result::satisfiable);
+			checkRange(0, 500, 999);
+			REQUIRE(ranges.parse("bytes=-200", 1000) == Result::satisfiable);
+			checkRange(0, 800, 999);
+			REQUIRE(ranges.parse("bytes=-2000", 1000) == Result::satisfiable);
+			checkRange(0, 0, 999);
+			REQUIRE(ranges.parse("bytes=900-2000", 1000) == Result::satisfiable);
+			checkRange(0, 900, 999);
+
+			REQUIRE(ranges.parse("BYTES=0-0, 10-20 ,, 2000-3000,-1", 1000) == Result::satisfiable);
+			REQUIRE_EQ(ranges.count(), 3U);
+			checkRange(0, 0, 0);
+			checkRange(1, 10, 20);
+			checkRange(2, 999, 999);
+			REQUIRE_EQ(ranges.totalLength(), 13U);
+
+			REQUIRE(ranges.parse("bytes=1000-", 1000) == Result::unsatisfiable);
+			REQUIRE(ranges.parse("bytes=-0", 1000) == Result::unsatisfiable);
+			REQUIRE(ranges.parse("bytes=0-", 0) == Result::unsatisfiable);
+			REQUIRE_EQ(ranges.count(), 0U);
+			REQUIRE_EQ(HttpRangeList::contentRange(1000), "bytes */1000");
+
+			REQUIRE(ranges.parse(nullptr, 1000) == Result::ignore);
+			REQUIRE(ranges.parse("items=0-5", 1000) == Result::ignore);
+			REQUIRE(ranges.parse("bytes=", 1000) == Result::ignore);
+			REQUIRE(ranges.parse("bytes=5-4", 1000) == Result::ignore);
+			REQUIRE(ranges.parse("bytes=a-4", 1000) == Result::ignore);
+			REQUIRE(ranges.parse("bytes=0-4;", 1000) == Result::ignore);
+			REQUIRE(ranges.parse("bytes=0-4, 1000-1001, 5-4", 1000) == Result::ignore);
+
+			String many = F("bytes=");
+			for(unsigned i = 0; i <= HTTP_SERVER_MAX_RANGES; ++i) {
+				many += i;
+				many += '-';
+				many += i;
+				many += ',';
+			}
+			REQUIRE(ranges.parse(many.c_str(), 1000) == Result::ignore);
+			REQUIRE_EQ(ranges.count(), 0U);
+		}
+
+		DEFINE_FSTR_LOCAL(FS_content, "0123456789abcdefghijklmnopqrstuvwxyz")
+
+		// Read stream content in the same way as TcpConnection
+		auto readStream = [](IDataSourceStream& stream, size_t chunkSize) {
+			String s;
+			char buffer[64];
+			while(!stream.isFinished()) {
+				auto len = stream.readMemoryBlock(buffer, std::min(chunkSize, sizeof(buffer)));
+				if(len == 0) {
+					break;
+				}
+				s.concat(buffer, len);
+				stream.seek(len);
+			}
+			return s;
+		};
+
+		TEST_CASE("Single byte range stream")
+		{
+			String content(FS_content);
+			REQUIRE(ranges.parse("bytes=10-15", content.length()) == Result::satisfiable);
+			for(auto chunkSize : {1U, 4U, 100U}) {
+				ByteRangeStream stream(new MemoryDataStream(String(content)), ranges, content.length(),
+									   toString(MIME_TEXT));
+				REQUIRE(!stream.isMultipart());
+				REQUIRE_EQ(stream.getContentType(), toString(MIME_TEXT));
+				REQUIRE_EQ(stream.available(), 6);
+				REQUIRE_EQ(readStream(stream, chunkSize), "abcdef");
+				REQUIRE_EQ(stream.available(), 0);
+			}
+		}
+
+		TEST_CASE("Multipart byte range stream")
+		{
+			String content(FS_content);
+			REQUIRE(ranges.parse("bytes=0-1,-2", content.length()) == Result::satisfiable);
+			for(auto chunkSize : {1U, 7U, 100U}) {
+				ByteRangeStream stream(new MemoryDataStream(String(content)), ranges, content.length(),
+									   toString(MIME_TEXT));
+				REQUIRE(stream.isMultipart());
+				String contentType = stream.getContentType();
+				DEFINE_FSTR_LOCAL(FS_multipart, "multipart/byteranges; boundary=")
+				REQUIRE(contentType.startsWith(FS_multipart));
+				String boundary = contentType.substring(FS_multipart.length());
+				REQUIRE_EQ(boundary.length(), 16U);
+
+				String expected;
+				auto addPart = [&](const char* range, const char* data) {
+					expected += "\r\n--";
+					expected += boundary;
+					expected += "\r\nContent-Type: ";
+					expected += toString(MIME_TEXT);
+					expected += "\r\nContent-Range: bytes ";
+					expected += range;
+					expected += "/36\r\n\r\n";
+					expected += data;
+				};
+				addPart("0-1", "01");
+				addPart("34-35", "yz");
+				expected += "\r\n--";
+				expected += boundary;
+				expected += "--\r\n";
+
+				REQUIRE_EQ(size_t(stream.available()), expected.length());
+				REQUIRE_EQ(readStream(stream, chunkSize), expected);
+			}
+		}
+	}
+
+	void testConditional()
+	{
+		TEST_CASE("If-None-Match comparison")
+		{
+			const String etag = F("\"00a-1f\"");
+			REQUIRE(HttpEtagCache::etagListContains(etag, etag));
+			REQUIRE(HttpEtagCache::etagListContains(F("W/\"00a-1f\""), etag));
+			REQUIRE(HttpEtagCache::etagListContains(F("\"xyz\" , W/\"00a-1f\""), etag));
+			REQUIRE(HttpEtagCache::etagListContains(F("*"), etag));
+			REQUIRE(HttpEtagCache::etagListContains(F("*"), nullptr));
+			REQUIRE(!HttpEtagCache::etagListContains(F("*"), etag, false));
+			REQUIRE(!HttpEtagCache::etagListContains(F("\"00a-1\", \"00a-1f0\""), etag));
+			REQUIRE(!HttpEtagCache::etagListContains(nullptr, etag));
+			REQUIRE(!HttpEtagCache::etagListContains(F("W/, \"\""), nullptr));
+		}
+
+		TEST_CASE("Conditional request evaluation")
+		{
+			const String etag = F("\"1234\"");
+			const String date = F("Sat, 01 May 2021 12:00:00 GMT");
+			time_t mtime;
+			REQUIRE(DateTime::fromHttpDate(date, mtime));
+
+			HttpHeaders headers;
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, mtime));
+
+			headers[HTTP_HEADER_IF_MODIFIED_SINCE] = date;
+			REQUIRE(HttpEtagCache::isNotModified(headers, etag, mtime));
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, mtime + 1));
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, 0));
+			headers[HTTP_HEADER_IF_MODIFIED_SINCE] = F("garbage");
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, mtime));
+
+			// If-None-Match takes precedence
+			headers[HTTP_HEADER_IF_MODIFIED_SINCE] = date;
+			headers[HTTP_HEADER_IF_NONE_MATCH] = F("\"5678\"");
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, mtime));
+			headers[HTTP_HEADER_IF_NONE_MATCH] = etag;
+			REQUIRE(HttpEtagCache::isNotModified(headers, etag, mtime + 1));
+
+			// Wildcard only matches if the resource is known to exist
+			headers[HTTP_HEADER_IF_NONE_MATCH] = "*";
+			REQUIRE(HttpEtagCache::isNotModified(headers, etag, mtime));
+			REQUIRE(!HttpEtagCache::isNotModified(headers, etag, mtime, false));
+		}
+
+#if HTTP_SERVER_ETAG_CACHE_SIZE >= 2
+		TEST_CASE("ETag cache")
+		{
+			HttpEtagCache cache;
+			REQUIRE_EQ(cache.count(), 0U);
+			REQUIRE(cache.find("/") == nullptr);
+
+			auto makeTag = [](unsigned i) { return String('"') + i + '"'; };
+			for(unsigned i = 0; i < HTTP_SERVER_ETAG_CACHE_SIZE; ++i) {
+				cache.update(String('/') + i, makeTag(i), i);
+			}
+			REQUIRE_EQ(cache.count(), unsigned(HTTP_SERVER_ETAG_CACHE_SIZE));
+
+			// Touch first entry so second becomes least recently used
+			auto entry = cache.find("/0");
+			REQUIRE(entry != nullptr);
+			REQUIRE_EQ(entry->etag, makeTag(0));
+			cache.update("/new", makeTag(100), 100);
+			REQUIRE_EQ(cache.count(), unsigned(HTTP_SERVER_ETAG_CACHE_SIZE));
+			REQUIRE(cache.find("/0") != nullptr);
+			REQUIRE(cache.find("/1") == nullptr);
+			REQUIRE(cache.find("/new") != nullptr);
+
+			// Replace existing entry
+			cache.update("/0", makeTag(200), 200);
+			entry = cache.find("/0");
+			REQUIRE(entry != nullptr);
+			REQUIRE_EQ(entry->etag, makeTag(200));
+			REQUIRE_EQ(entry->lastModified, time_t(200));
+			REQUIRE_EQ(cache.count(), unsigned(HTTP_SERVER_ETAG_CACHE_SIZE));
+
+			REQUIRE(cache.invalidate("/0"));
+			REQUIRE(!cache.invalidate("/0"));
+			REQUIRE(cache.find("/0") == nullptr);
+			REQUIRE_EQ(cache.count(), unsigned(HTTP_SERVER_ETAG_CACHE_SIZE - 1));
+
+			// Variants selected by Accept-Encoding are held separately
+			cache.update("/0", makeTag(300), 300, F("gzip"));
+			cache.update("/0", makeTag(301), 301, F("br"));
+			REQUIRE(cache.find("/0") == nullptr);
+			entry = cache.find("/0", F("gzip"));
+			REQUIRE(entry != nullptr);
+			REQUIRE_EQ(entry->etag, makeTag(300));
+			entry = cache.find("/0", F("br"));
+			REQUIRE(entry != nullptr);
+			REQUIRE_EQ(entry->etag, makeTag(301));
+			REQUIRE(cache.invalidate("/0"));
+			REQUIRE(cache.find("/0", F("gzip")) == nullptr);
+			REQUIRE(cache.find("/0", F("br")) == nullptr);
+
+			cache.clear();
+			REQUIRE_EQ(cache.count(), 0U);
+		}
+#endif
+	}
+
+	void testAcceptEncoding()
+	{
+		using Coding = HttpContentCoding;
+		constexpr unsigned precompressed{HttpAcceptEncoding::mask(Coding::br) | HttpAcceptEncoding::mask(Coding::gzip) |
+										 HttpAcceptEncoding::mask(Coding::identity)};
+
+		auto selectFrom = [](const HttpAcceptEncoding& accept, unsigned available) {
+			Coding coding;
+			return accept.select(available, coding) ? toString(coding) : String("none");
+		};
+
+		TEST_CASE("Accept-Encoding parsing")
+		{
+			HttpAcceptEncoding accept;
+			// No header: anything goes
+			REQUIRE(accept.accepts(Coding::br));
+			REQUIRE_EQ(selectFrom(accept, precompressed), "br");
+
+			accept.parse(F("gzip, deflate, br"));
+			REQUIRE_EQ(accept.quality(Coding::gzip), 1000U);
+			REQUIRE_EQ(accept.quality(Coding::identity), 1000U);
+			REQUIRE_EQ(selectFrom(accept, precompressed), "br");
+			REQUIRE_EQ(selectFrom(accept, HttpAcceptEncoding::mask(Coding::gzip)), "gzip");
+
+			accept.parse(F("br;q=0.5, GZIP ; q=0.8,identity;q=0.25"));
+			REQUIRE_EQ(accept.quality(Coding::br), 500U);
+			REQUIRE_EQ(accept.quality(Coding::gzip), 800U);
+			REQUIRE_EQ(accept.quality(Coding::identity), 250U);
+			REQUIRE_EQ(accept.quality(Coding::deflate), 0U);
+			REQUIRE_EQ(selectFrom(accept, precompressed), "gzip");
+
+			accept.parse(F("x-gzip"));
+			REQUIRE(accept.accepts(Coding::gzip));
+			REQUIRE(!accept.accepts(Coding::br));
+			REQUIRE_EQ(selectFrom(accept, precompressed), "gzip");
+
+			accept.parse(nullptr);
+			REQUIRE_EQ(selectFrom(accept, precompressed), "identity");
+
+			accept.parse(F("*;q=0.1, gzip;q=0"));
+			REQUIRE_EQ(accept.quality(Coding::br), 100U);
+			REQUIRE(!accept.accepts(Coding::gzip));
+			REQUIRE_EQ(selectFrom(accept, precompressed), "br");
+
+			accept.parse(F("identity;q=0, *;q=0"));
+			REQUIRE_EQ(selectFrom(accept, precompressed), "none");
+		}
+	}
+
+	void testResourceTree()
+	{
+		HttpResourceTree tree;
+		auto add = [&](const char* path) {
+			auto res = new HttpResource;
+			tree.set(path, res);
+			return res;
+		};
+		auto root = add("/");
+		auto list = add("/api/device/list");
+		auto state = add("/api/device/:id/state");
+		auto config = add("/api/device/:id/config/:item");
+		auto files = add("/files/*path");
+		tree.setDefault(new HttpResource);
+
+		HttpPathParameters params;
+
+		TEST_CASE("Match literal paths")
+		{
+			REQUIRE(tree.match("/", params) == root);
+			REQUIRE(tree.match("/api/device/list", params) == list);
+			REQUIRE(params.count() == 0);
+			REQUIRE(tree.match("/api/device", params) == nullptr);
+			REQUIRE(tree.match("/api/device/list/", params) == nullptr);
+			REQUIRE(tree.match("/unknown", params) == nullptr);
+		}
+
+		TEST_CASE("Match path parameters")
+		{
+			String path = "/api/device/12/state";
+			REQUIRE(tree.match(path, params) == state);
+			REQUIRE(params.count() == 1);
+			REQUIRE(strcmp(params[0].name, "id") == 0);
+			REQUIRE(params.getValue(path, 0) == "12");
+
+			path = "/api/device/lamp/config/brightness";
+			REQUIRE(tree.match(path, params) == config);
+			REQUIRE(params.count() == 2);
+			REQUIRE(params.getValue(path, params.indexOf("id")) == "lamp");
+			REQUIRE(params.getValue(path, params.indexOf("item")) == "brightness");
+
+			// Literal takes precedence, but falls back to parameter
+			path = "/api/device/list/state";
+			REQUIRE(tree.match(path, params) == state);
+			REQUIRE(params.getValue(path, 0) == "list");
+
+			REQUIRE(tree.match("/api/device//state", params) == nullptr);
+			REQUIRE(tree.match("/api/device/12", params) == nullptr);
+			REQUIRE(params.count() == 0);
+		}
+
+		TEST_CASE("Match wildcard")
+		{
+			String path = "/files/www/index.html";
+			REQUIRE(tree.match(path, params) == files);
+			REQUIRE(params.count() == 1);
+			REQUIRE(strcmp(params[0].name, "path") == 0);
+			REQUIRE(params.getValue(path, 0) == "www/index.html");
+			REQUIRE(tree.match("/files", params) == nullptr);
+		}
+
+		TEST_CASE("Modify resource tree")
+		{
+			REQUIRE(tree.remove("/api/device/list"));
+			String path = "/api/device/list/state";
+			REQUIRE(tree.match("/api/device/list", params) == nullptr);
+			REQUIRE(tree.match(path, params) == state);
+			auto info = add("/api/device/:id/info");
+			tree["/api/version"] = new HttpResource;
+			REQUIRE(tree.match("/api/device/7/info", params) == info);
+			REQUIRE(tree.match("/api/version", params) != nullptr);
+			REQUIRE(tree.match(path, params) == state);
+
+			// Remove and re-add via Value, leaving count unchanged but re-ordering entries
+			auto count = tree.count();
+			REQUIRE(tree["/"].remove());
+			auto version = new HttpResource;
+			tree["/api/v2/version"] = version;
+			REQUIRE_EQ(tree.count(), count);
+			REQUIRE(tree.match("/", params) == nullptr);
+			REQUIRE(tree.match("/api/v2/version", params) == version);
+			REQUIRE(tree.match("/api/device/7/info", params) == info);
+			REQUIRE(tree.match("/files/x", params) == files);
+		}
+	}
+
+	void profileResourceTree()
+	{
+		HttpResourceTree tree;
+		const unsigned routeCount{60};
+		for(unsigned i = 0; i < routeCount; ++i) {
+			tree.set("/api/group" + String(i) + "/:id/state", new HttpResource);
+			tree.set("/api/group" + String(i) + "/status", new HttpResource);
+		}
+
+		HttpPathParameters params;
+		String path = "/api/group" + String(routeCount - 1) + "/status";
+		String paramPath = "/api/group" + String(routeCount - 1) + "/1234/state";
+		tree.match(path, params); // Compile tree
+
+		const unsigned matchCount{1000};
+		ElapseTimer timer;
+		for(unsigned i = 0; i < matchCount; ++i) {
+			tree.find(path);
+		}
+		auto findElapsed = timer.elapsedTime();
+		timer.start();
+		for(unsigned i = 0; i < matchCount; ++i) {
+			tree.match(path, params);
+		}
+		auto matchElapsed = timer.elapsedTime();
+		timer.start();
+		for(unsigned i = 0; i < matchCount; ++i) {
+			tree.match(paramPath, params);
+		}
+		auto paramElapsed = timer.elapsedTime();
+
+		Serial << _F("Resource tree, ") << tree.count() << _F(" paths, ") << matchCount << _F(" lookups") << endl;
+		Serial << _F("  Linear find: ") << findElapsed.toString() << endl;
+		Serial << _F("  Tree match: ") << matchElapsed.toString() << endl;
+		Serial << _F("  Tree match with parameter: ") << paramElapsed.toString() << endl;
+	}
+
 	void testHttpHeaders()
 	{
 		HttpHeaders headers;
@@ -181,12 +737,21 @@ public:
 			return s;
 		};
 
+		auto serializeBuffer = [this](const HttpHeaders& h) {
+			String s;
+			auto length = h.serialize(nullptr);
+			REQUIRE(s.setLength(length));
+			REQUIRE_EQ(h.serialize(s.begin()), length);
+			return s;
+		};
+
 		TEST_CASE("Serialisation")
 		{
 			headers["Mary"] = "Had a little lamb";
 			headers[HTTP_HEADER_CONTENT_LENGTH] = "12345";
 			headers["George"] = "Was an idiot";
 			REQUIRE(serialize(headers) == FS_serialized);
+			REQUIRE(serializeBuffer(headers) == FS_serialized);
 			printHeaders(headers);
 		}
 
@@ -209,6 +774,7 @@ public:
 			printHeaders(headers2);
 			REQUIRE(headers2.count() == 1);
 			REQUIRE(serialize(headers2) == FS_cookies);
+			REQUIRE(serializeBuffer(headers2) == FS_cookies);
 
 			// Append should work if field not already set
 			REQUIRE(headers2.append(HTTP_HEADER_CONTENT_LENGTH, "0") == true);
@@ -0,0 +1,622 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/MqttTopicTree.h>
+#include <Network/Mqtt/MqttSpool.h>
+#include <Network/MqttClient.h>
+#include <Network/TcpServer.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <Storage/Device.h>
+#include <Platform/Station.h>
+
+namespace
+{
+/*
+ * RAM-backed device with flash semantics: writes may only clear bits, erase sets them
+ */
+class FlashMemDevice : public Storage::Device
+{
+public:
+	FlashMemDevice(size_t size) : data(new uint8_t[size]), size(size)
+	{
+		memset(data.get(), 0xff, size);
+	}
+
+	String getName() const override
+	{
+		return F("flashMem");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return 256;
+	}
+
+	storage_size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::unknown;
+	}
+
+	bool read(storage_size_t address, void* dst, size_t count) override
+	{
+		memcpy(dst, &data[address], count);
+		return true;
+	}
+
+	bool write(storage_size_t address, const void* src, size_t count) override
+	{
+		// Simulate power loss
+		if(writeLimit == 0) {
+			return false;
+		}
+		--writeLimit;
+
+		auto bytes = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < count; ++i) {
+			data[address + i] &= bytes[i];
+		}
+		return true;
+	}
+
+	bool erase_range(storage_size_t address, storage_size_t count) override
+	{
+		memset(&data[address], 0xff, count);
+		++eraseCount;
+		return true;
+	}
+
+	Storage::Partition createPartition()
+	{
+		return editablePartitions().add(F("mqttSpool"), {Storage::Partition::Type::userMin, 0}, 0U, size);
+	}
+
+	unsigned eraseCount{0};
+	unsigned writeLimit{UINT_MAX}; ///< Number of further writes which succeed
+
+private:
+	std::unique_ptr<uint8_t[]> data;
+	size_t size;
+};
+
+/*
+ * Describe spool content as "id/flags:topic=content" entries, with '*' marking released messages
+ */
+String loadSpool(MqttSpool& spool, unsigned& count)
+{
+	String s;
+	count = spool.load([&](uint16_t id, uint8_t flags, String& topic, String& content, bool released) {
+		s += id;
+		s += '/';
+		s += flags;
+		s += ':';
+		s += topic;
+		s += '=';
+		s += content;
+		if(released) {
+			s += '*';
+		}
+		s += ';';
+	});
+	return s;
+}
+
+} // namespace
+
+class MqttTest : public TestGroup
+{
+public:
+	MqttTest() : TestGroup(_F("MQTT"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Topic filter validation")
+		{
+			REQUIRE(MqttTopicTree::isValidFilter("sport/tennis/player1"));
+			REQUIRE(MqttTopicTree::isValidFilter("#"));
+			REQUIRE(MqttTopicTree::isValidFilter("+/+/#"));
+			REQUIRE(MqttTopicTree::isValidFilter("sport/"));
+			REQUIRE(!MqttTopicTree::isValidFilter(""));
+			REQUIRE(!MqttTopicTree::isValidFilter("sport/#/player1"));
+			REQUIRE(!MqttTopicTree::isValidFilter("sport+/tennis"));
+			REQUIRE(!MqttTopicTree::isValidFilter("sport/tennis#"));
+		}
+
+		auto handler = [](MqttClient&, mqtt_message_t*) -> int { return 0; };
+
+		MqttTopicTree tree;
+
+		auto check = [&](const char* topic, std::initializer_list<const char*> expected) {
+			MqttTopicTree::MatchList list;
+			tree.match(topic, strlen(topic), list);
+			Serial << '"' << topic << _F("\" matched ") << list.count() << _F(" filters") << endl;
+			REQUIRE_EQ(list.count(), expected.size());
+			for(auto filter : expected) {
+				REQUIRE(list.contains(tree.find(filter)));
+			}
+		};
+
+		TEST_CASE("Topic matching")
+		{
+			const char* filters[]{
+				"sport/tennis/player1", "sport/tennis/+", "sport/#", "+/tennis/#", "#", "+", "$SYS/#", "sport/+/player1/#",
+			};
+			for(auto filter : filters) {
+				REQUIRE(tree.add(filter, handler));
+			}
+			REQUIRE(!tree.add("sport/#/player1", handler));
+			REQUIRE_EQ(tree.count(), ARRAY_SIZE(filters));
+
+			check("sport/tennis/player1",
+				  {"sport/tennis/player1", "sport/tennis/+", "sport/#", "+/tennis/#", "#", "sport/+/player1/#"});
+			check("sport/tennis/player2", {"sport/tennis/+", "sport/#", "+/tennis/#", "#"});
+			check("sport", {"sport/#", "#", "+"});
+			check("sport/", {"sport/#", "#"});
+			check("news", {"#", "+"});
+			check("$SYS/broker/uptime", {"$SYS/#"});
+		}
+
+		TEST_CASE("Topic removal")
+		{
+			REQUIRE(tree.remove("#"));
+			REQUIRE(!tree.remove("#"));
+			check("news", {"+"});
+
+			// Removed entries must remain valid until unlocked
+			MqttTopicTree::MatchList list;
+			auto sub = tree.find("sport/tennis/player1");
+			tree.lock();
+			tree.match("sport/tennis/player1", 20, list);
+			REQUIRE_EQ(list.count(), 5U);
+			REQUIRE(tree.remove("sport/tennis/player1"));
+			REQUIRE(tree.find("sport/tennis/player1") == nullptr);
+			check("sport/tennis/player1", {"sport/tennis/+", "sport/#", "+/tennis/#", "sport/+/player1/#"});
+			REQUIRE(list.contains(sub));
+			REQUIRE(sub->removed);
+			tree.unlock();
+
+			REQUIRE_EQ(tree.count(), 6U);
+			tree.clear();
+			REQUIRE_EQ(tree.count(), 0U);
+			check("sport/tennis/player1", {});
+		}
+
+		auto qos1 = MqttClient::getFlags(MQTT_QOS_AT_LEAST_ONCE);
+		auto qos2 = MqttClient::getFlags(MQTT_QOS_EXACTLY_ONCE);
+
+		TEST_CASE("Spool round-trip")
+		{
+			FlashMemDevice dev(1024);
+			auto part = dev.createPartition();
+			REQUIRE(part);
+
+			MqttPartitionSpool spool(part);
+			REQUIRE_EQ(spool.load(nullptr), 0U);
+			REQUIRE(spool.store(1, qos1, F("a/b"), F("one")));
+			REQUIRE(spool.store(2, qos2, F("a/c"), F("two")));
+			REQUIRE(spool.store(3, qos1, F("a/d"), ""));
+			REQUIRE(spool.store(4, qos2, F("a/e"), F("four")));
+			spool.release(2);
+			spool.remove(1);
+			REQUIRE_EQ(spool.count(), 3U);
+
+			// Reload as after a restart: messages come back in the order they were sent
+			auto entry = [](uint16_t id, uint8_t flags, const char* text) {
+				String s;
+				s += id;
+				s += '/';
+				s += flags;
+				s += ':';
+				s += text;
+				s += ';';
+				return s;
+			};
+			String expected = entry(2, qos2, "a/c=two*") + entry(3, qos1, "a/d=") + entry(4, qos2, "a/e=four");
+			MqttPartitionSpool spool2(part);
+			unsigned count;
+			String content = loadSpool(spool2, count);
+			REQUIRE_EQ(count, 3U);
+			REQUIRE_EQ(content, expected);
+
+			// Identifiers may be re-used once acknowledged
+			REQUIRE(spool2.store(1, qos1, F("a/f"), F("five")));
+			spool2.remove(3);
+			expected = entry(2, qos2, "a/c=two*") + entry(4, qos2, "a/e=four") + entry(1, qos1, "a/f=five");
+			MqttPartitionSpool spool3(part);
+			content = loadSpool(spool3, count);
+			REQUIRE_EQ(count, 3U);
+			REQUIRE_EQ(content, expected);
+			REQUIRE_EQ(dev.eraseCount, 0U);
+
+			// Client restores the in-flight window from the spool
+			MqttClient client;
+			REQUIRE_EQ(client.setSpool(&spool3), 3U);
+			REQUIRE_EQ(client.getInflightCount(), 3U);
+		}
+
+		TEST_CASE("Spool interrupted write")
+		{
+			FlashMemDevice dev(1024);
+			auto part = dev.createPartition();
+			MqttPartitionSpool spool(part);
+			spool.load(nullptr);
+			REQUIRE(spool.store(1, qos1, F("a/b"), F("one")));
+
+			// Power fails part-way through writing the next record
+			dev.writeLimit = 2;
+			REQUIRE(!spool.store(2, qos1, F("a/c"), F("two")));
+			dev.writeLimit = UINT_MAX;
+
+			// Incomplete record is neither restored nor written over
+			MqttPartitionSpool spool2(part);
+			unsigned count;
+			REQUIRE_EQ(loadSpool(spool2, count), "1/2:a/b=one;");
+			REQUIRE_EQ(count, 1U);
+			REQUIRE(spool2.store(3, qos1, F("a/d"), F("three")));
+
+			MqttPartitionSpool spool3(part);
+			REQUIRE_EQ(loadSpool(spool3, count), "1/2:a/b=one;3/2:a/d=three;");
+			REQUIRE_EQ(count, 2U);
+			REQUIRE_EQ(dev.eraseCount, 0U);
+		}
+
+		TEST_CASE("Spool full")
+		{
+			FlashMemDevice dev(256);
+			auto part = dev.createPartition();
+			MqttPartitionSpool spool(part);
+			spool.load(nullptr);
+
+			// Partition is only erased once every message has been acknowledged
+			String text(F("0123456789"));
+			for(unsigned id = 1; id <= 30; ++id) {
+				REQUIRE(spool.store(id, qos1, text, text));
+				spool.remove(id);
+			}
+			REQUIRE(dev.eraseCount != 0);
+			REQUIRE_EQ(spool.count(), 0U);
+
+			unsigned id{1};
+			while(spool.store(id, qos1, text, text)) {
+				++id;
+			}
+			REQUIRE(id > 1);
+			REQUIRE_EQ(spool.count(), id - 1);
+			auto eraseCount = dev.eraseCount;
+			spool.remove(1);
+			REQUIRE(!spool.store(id, qos1, text, text));
+			REQUIRE_EQ(dev.eraseCount, eraseCount);
+
+			unsigned count;
+			MqttPartitionSpool spool2(part);
+			loadSpool(spool2, count);
+			REQUIRE_EQ(count, id - 2);
+		}
+	}
+};
+
+/*
+ * Exercise the QoS 1/2 in-flight window against a minimal broker.
+ * The broker records what it receives, and acknowledges only when told to.
+ */
+class MqttQosTest : public TestGroup
+{
+public:
+	MqttQosTest() : TestGroup(_F("MQTT QoS"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println(_F("No network, skipping tests"));
+			return;
+		}
+
+		// Messages left over from a previous session
+		REQUIRE(spool.load(nullptr) == 0);
+		REQUIRE(spool.store(100, MqttClient::getFlags(MQTT_QOS_AT_LEAST_ONCE), F("spooled"), F("100")));
+		REQUIRE(spool.store(101, MqttClient::getFlags(MQTT_QOS_EXACTLY_ONCE), F("spooled"), F("101")));
+		spool.release(101);
+		REQUIRE_EQ(client.setSpool(&spool), 2U);
+
+		server = new TcpServer(TcpClientDataDelegate(&MqttQosTest::onBrokerReceive, this));
+		REQUIRE(server->listen(port));
+		server->setTimeOut(USHRT_MAX);
+
+		client.setMaxInflight(2);
+		client.setRetryInterval(0);
+		String url = F("mqtt://") + WifiStation.getIP().toString() + ':' + port;
+		REQUIRE(client.connect(Url(url), F("qos-test")));
+
+		timer.initializeMs<250>(TimerDelegate(&MqttQosTest::step, this)).start();
+		pending();
+	}
+
+private:
+	enum class Stage {
+		restore,
+		window,
+		slide,
+		drain,
+		drained,
+		qos2,
+		retry,
+		stream,
+		done,
+	};
+
+	struct Packet {
+		uint8_t header;
+		uint16_t id{0};
+		String content;
+
+		uint8_t type() const
+		{
+			return header >> 4;
+		}
+
+		uint8_t qos() const
+		{
+			return (header >> 1) & 0x03;
+		}
+
+		bool dup() const
+		{
+			return header & 0x08;
+		}
+	};
+
+	void setStage(Stage newStage)
+	{
+		stage = newStage;
+		ticks = 0;
+	}
+
+	void publish(const String& content, mqtt_qos_t qos)
+	{
+		REQUIRE(client.publish(F("test"), content, MqttClient::getFlags(qos)));
+	}
+
+	void step()
+	{
+		// No stage should take longer than the retry interval plus a few poll cycles
+		REQUIRE(++ticks < 40);
+
+		switch(stage) {
+		case Stage::restore:
+			// Spooled PUBLISH is re-sent as a duplicate, released message as PUBREL
+			if(client.getInflightCount() != 0) {
+				break;
+			}
+			REQUIRE_EQ(packets.count(), 2U);
+			REQUIRE_EQ(packets[0].type(), MQTT_TYPE_PUBLISH);
+			REQUIRE_EQ(packets[0].id, 100);
+			REQUIRE(packets[0].dup());
+			REQUIRE_EQ(packets[0].content, "100");
+			REQUIRE_EQ(packets[1].type(), MQTT_TYPE_PUBREL);
+			REQUIRE_EQ(packets[1].id, 101);
+			REQUIRE_EQ(spool.count(), 0U);
+			packets.clear();
+
+			for(unsigned i = 1; i <= 4; ++i) {
+				publish(String(i), MQTT_QOS_AT_LEAST_ONCE);
+			}
+			setStage(Stage::window);
+			break;
+
+		case Stage::window:
+			// Give client a chance to exceed the window
+			if(packets.count() < 2 || ticks < 4) {
+				break;
+			}
+			REQUIRE_EQ(packets.count(), 2U);
+			REQUIRE_EQ(client.getInflightCount(), 2U);
+			REQUIRE_EQ(spool.count(), 2U);
+			acknowledge(0);
+			setStage(Stage::slide);
+			break;
+
+		case Stage::slide:
+			if(packets.count() < 3) {
+				break;
+			}
+			for(unsigned i = 0; i < 3; ++i) {
+				REQUIRE_EQ(packets[i].type(), MQTT_TYPE_PUBLISH);
+				REQUIRE_EQ(packets[i].qos(), MQTT_QOS_AT_LEAST_ONCE);
+				REQUIRE(!packets[i].dup());
+				REQUIRE_EQ(packets[i].content, String(i + 1));
+			}
+			REQUIRE(packets[0].id != packets[1].id);
+			REQUIRE(packets[1].id != packets[2].id);
+			acknowledge(1);
+			acknowledge(2);
+			setStage(Stage::drain);
+			break;
+
+		case Stage::drain:
+			if(packets.count() < 4) {
+				break;
+			}
+			REQUIRE_EQ(packets[3].content, "4");
+			acknowledge(3);
+			setStage(Stage::drained);
+			break;
+
+		case Stage::drained:
+			if(client.getInflightCount() != 0) {
+				break;
+			}
+			REQUIRE_EQ(spool.count(), 0U);
+			packets.clear();
+			publish(F("5"), MQTT_QOS_EXACTLY_ONCE);
+			setStage(Stage::qos2);
+			break;
+
+		case Stage::qos2:
+			// Broker answers PUBLISH with PUBREC, and PUBREL with PUBCOMP
+			if(client.getInflightCount() != 0) {
+				break;
+			}
+			REQUIRE_EQ(packets.count(), 2U);
+			REQUIRE_EQ(packets[0].type(), MQTT_TYPE_PUBLISH);
+			REQUIRE_EQ(packets[0].qos(), MQTT_QOS_EXACTLY_ONCE);
+			REQUIRE_EQ(packets[0].content, "5");
+			REQUIRE_EQ(packets[1].type(), MQTT_TYPE_PUBREL);
+			REQUIRE_EQ(packets[1].id, packets[0].id);
+			REQUIRE_EQ(spool.count(), 0U);
+			packets.clear();
+			client.setRetryInterval(1);
+			publish(F("6"), MQTT_QOS_AT_LEAST_ONCE);
+			setStage(Stage::retry);
+			break;
+
+		case Stage::retry:
+			// Broker ignores the first PUBLISH and acknowledges the duplicate
+			if(client.getInflightCount() != 0) {
+				break;
+			}
+			REQUIRE_EQ(packets.count(), 2U);
+			REQUIRE(!packets[0].dup());
+			REQUIRE(packets[1].dup());
+			REQUIRE_EQ(packets[1].id, packets[0].id);
+			REQUIRE_EQ(packets[1].content, "6");
+			packets.clear();
+			client.setRetryInterval(0);
+			REQUIRE(client.publish(F("test"), new MemoryDataStream(F("7")),
+								   MqttClient::getFlags(MQTT_QOS_EXACTLY_ONCE)));
+			setStage(Stage::stream);
+			break;
+
+		case Stage::stream:
+			// Stream content isn't retained, but the exchange must still complete
+			if(packets.count() < 2 || client.getInflightCount() != 0) {
+				break;
+			}
+			REQUIRE_EQ(packets.count(), 2U);
+			REQUIRE_EQ(packets[0].type(), MQTT_TYPE_PUBLISH);
+			REQUIRE_EQ(packets[0].content, "7");
+			REQUIRE_EQ(packets[1].type(), MQTT_TYPE_PUBREL);
+			REQUIRE_EQ(packets[1].id, packets[0].id);
+			server->shutdown();
+			server = nullptr;
+			setStage(Stage::done);
+			break;
+
+		case Stage::done:
+			timer.stop();
+			complete();
+			break;
+		}
+	}
+
+	bool onBrokerReceive(TcpClient& connection, char* data, int size)
+	{
+		broker = &connection;
+		if(!input.concat(data, size)) {
+			return false;
+		}
+
+		// Fixed header is type/flags followed by variable-length 'remaining length'
+		for(;;) {
+			auto buf = reinterpret_cast<const uint8_t*>(input.c_str());
+			size_t pos{1};
+			size_t length{0};
+			unsigned shift{0};
+			do {
+				if(pos >= input.length()) {
+					return true;
+				}
+				length |= (buf[pos] & 0x7f) << shift;
+				shift += 7;
+			} while(buf[pos++] & 0x80);
+			if(pos + length > input.length()) {
+				return true;
+			}
+			handlePacket(buf[0], &buf[pos], length);
+			input.remove(0, pos + length);
+		}
+	}
+
+	void handlePacket(uint8_t header, const uint8_t* body, size_t length)
+	{
+		Packet packet{header};
+		switch(packet.type()) {
+		case MQTT_TYPE_CONNECT:
+			reply(MQTT_TYPE_CONNACK, 0);
+			return;
+
+		case MQTT_TYPE_PINGREQ: {
+			const uint8_t pingResponse[]{MQTT_TYPE_PINGRESP << 4, 0};
+			broker->send(reinterpret_cast<const char*>(pingResponse), sizeof(pingResponse));
+			broker->commit();
+			return;
+		}
+
+		case MQTT_TYPE_PUBLISH: {
+			size_t pos = 2 + (body[0] << 8 | body[1]);
+			if(packet.qos() != MQTT_QOS_AT_MOST_ONCE) {
+				packet.id = body[pos] << 8 | body[pos + 1];
+				pos += 2;
+			}
+			packet.content.setString(reinterpret_cast<const char*>(&body[pos]), length - pos);
+			if(stage == Stage::restore) {
+				reply(MQTT_TYPE_PUBACK, packet.id);
+			} else if(packet.qos() == MQTT_QOS_EXACTLY_ONCE) {
+				reply(MQTT_TYPE_PUBREC, packet.id);
+			} else if(stage == Stage::retry && packet.dup()) {
+				reply(MQTT_TYPE_PUBACK, packet.id);
+			}
+			break;
+		}
+
+		case MQTT_TYPE_PUBREL:
+			REQUIRE_EQ(header & 0x0f, 0x02);
+			packet.id = body[0] << 8 | body[1];
+			reply(MQTT_TYPE_PUBCOMP, packet.id);
+			break;
+
+		default:
+			return;
+		}
+
+		debug_i("[BROKER] type %u, id %u, dup %u", packet.type(), packet.id, packet.dup());
+		packets.add(packet);
+	}
+
+	void reply(uint8_t type, uint16_t id)
+	{
+		const uint8_t packet[]{uint8_t(type << 4), 2, uint8_t(id >> 8), uint8_t(id)};
+		broker->send(reinterpret_cast<const char*>(packet), sizeof(packet));
+		broker->commit();
+	}
+
+	void acknowledge(unsigned index)
+	{
+		reply(MQTT_TYPE_PUBACK, packets[index].id);
+	}
+
+	static constexpr uint16_t port{9879};
+	FlashMemDevice spoolDevice{4096};
+	Storage::Partition spoolPart{spoolDevice.createPartition()};
+	MqttPartitionSpool spool{spoolPart};
+	MqttClient client;
+	TcpServer* server{nullptr};
+	TcpClient* broker{nullptr};
+	String input;
+	Vector<Packet> packets;
+	Stage stage{Stage::restore};
+	unsigned ticks{0};
+	Timer timer;
+};
+
+void REGISTER_TEST(Mqtt)
+{
+	registerGroup<MqttTest>();
+	registerGroup<MqttQosTest>();
+}
@@ -0,0 +1,284 @@
+#include <HostTests.h>
+
+#include <Network/UdpConnection.h>
+#include <Platform/Station.h>
+#include <malloc_count.h>
+
+namespace
+{
+/*
+ * Feeds datagrams directly into the receive path
+ */
+class TestUdpConnection : public UdpConnection
+{
+public:
+	using UdpConnection::UdpConnection;
+
+	void receive(pbuf* buf)
+	{
+		onReceive(buf, IpAddress(192, 168, 1, 10), 5353);
+	}
+};
+
+pbuf* createPbuf(const char* data, size_t length)
+{
+	auto p = pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
+	if(p != nullptr) {
+		pbuf_take(p, data, length);
+	}
+	return p;
+}
+
+} // namespace
+
+class UdpTest : public TestGroup
+{
+public:
+	UdpTest() : TestGroup(_F("UDP"))
+	{
+	}
+
+	void execute() override
+	{
+		String text1 = F("The quick brown fox ");
+		String text2 = F("jumps over the lazy dog");
+		String text = text1 + text2;
+
+		TEST_CASE("Contiguous datagram")
+		{
+			auto buf = createPbuf(text.c_str(), text.length());
+			REQUIRE(buf != nullptr);
+
+			unsigned callCount{0};
+			TestUdpConnection udp([&](UdpConnection&, UdpPacket& packet) {
+				++callCount;
+				REQUIRE_EQ(packet.length(), text.length());
+				REQUIRE(packet.isContiguous());
+				REQUIRE(packet.getRemoteIP() == IpAddress(192, 168, 1, 10));
+				REQUIRE_EQ(packet.getRemotePort(), 5353);
+				REQUIRE_EQ(packet[4], 'q');
+
+				// No copy required
+#if ENABLE_MALLOC_COUNT
+				auto allocCount = MallocCount::getAllocCount();
+#endif
+				REQUIRE(packet.getPayload() == buf->payload);
+				REQUIRE(packet.getData() == buf->payload);
+#if ENABLE_MALLOC_COUNT
+				REQUIRE_EQ(MallocCount::getAllocCount(), allocCount);
+#endif
+			});
+			udp.receive(buf);
+			REQUIRE_EQ(callCount, 1);
+			pbuf_free(buf);
+		}
+
+		TEST_CASE("Chained datagram")
+		{
+			auto buf = createPbuf(text1.c_str(), text1.length());
+			REQUIRE(buf != nullptr);
+			auto buf2 = createPbuf(text2.c_str(), text2.length());
+			REQUIRE(buf2 != nullptr);
+			pbuf_cat(buf, buf2);
+
+			TestUdpConnection udp;
+			String content;
+			REQUIRE(content.reserve(text.length()));
+			udp.setPacketCallback([&](UdpConnection&, UdpPacket& packet) {
+				REQUIRE_EQ(packet.length(), text.length());
+				REQUIRE(!packet.isContiguous());
+				REQUIRE(packet.getPayload() == nullptr);
+
+				content.setLength(0);
+				unsigned segmentCount{0};
+				for(auto segment : packet) {
+					content.concat(segment.data, segment.length);
+					++segmentCount;
+				}
+				REQUIRE_EQ(segmentCount, 2);
+				REQUIRE(content == text);
+
+				char word[5]{};
+				REQUIRE_EQ(packet.read(text1.length(), word, 5), 5);
+				REQUIRE(memcmp(word, "jumps", 5) == 0);
+				REQUIRE_EQ(packet[text1.length()], 'j');
+
+				auto data = packet.getData();
+				REQUIRE(data != nullptr);
+				REQUIRE(memcmp(data, text.c_str(), text.length()) == 0);
+			});
+
+			// Receive buffer is allocated once then re-used
+			udp.receive(buf);
+#if ENABLE_MALLOC_COUNT
+			auto allocCount = MallocCount::getAllocCount();
+#endif
+			udp.receive(buf);
+			REQUIRE(content == text);
+#if ENABLE_MALLOC_COUNT
+			REQUIRE_EQ(MallocCount::getAllocCount(), allocCount);
+#endif
+			pbuf_free(buf);
+		}
+
+		TEST_CASE("Data delegate")
+		{
+			auto buf = createPbuf(text.c_str(), text.length());
+			REQUIRE(buf != nullptr);
+
+			String received;
+			TestUdpConnection udp([&](UdpConnection&, char* data, int size, IpAddress, uint16_t) {
+				REQUIRE_EQ(size_t(size), strlen(data));
+				received.setString(data, size);
+			});
+
+			udp.receive(buf);
+			REQUIRE(received == text);
+#if ENABLE_MALLOC_COUNT
+			auto allocCount = MallocCount::getAllocCount();
+#endif
+			received = nullptr;
+			udp.receive(buf);
+			REQUIRE(received == text);
+#if ENABLE_MALLOC_COUNT
+			// Only the String allocates
+			REQUIRE_EQ(MallocCount::getAllocCount(), allocCount + 1);
+#endif
+			pbuf_free(buf);
+		}
+
+		TEST_CASE("Close from data delegate")
+		{
+			auto buf = createPbuf(text1.c_str(), text1.length());
+			REQUIRE(buf != nullptr);
+			auto buf2 = createPbuf(text2.c_str(), text2.length());
+			REQUIRE(buf2 != nullptr);
+			pbuf_cat(buf, buf2);
+
+			// Data is in the connection's receive buffer, which must outlive close()
+			String received;
+			TestUdpConnection udp([&](UdpConnection& connection, char* data, int size, IpAddress, uint16_t) {
+				connection.close();
+				received.setString(data, size);
+			});
+
+			udp.receive(buf);
+			REQUIRE(received == text);
+			pbuf_free(buf);
+		}
+
+		TEST_CASE("UdpPacketBuilder")
+		{
+			UdpPacketBuilder packet(32);
+			REQUIRE_EQ(packet.capacity(), 32);
+			REQUIRE_EQ(packet.length(), 0);
+
+			packet.print(_F("Temp: "));
+			packet.print(21.5, 1);
+			REQUIRE_EQ(packet.length(), 10);
+			REQUIRE(!packet.isOverflow());
+			REQUIRE(memcmp(packet.getBuffer(), "Temp: 21.5", 10) == 0);
+
+			// Content beyond capacity is discarded
+			REQUIRE_EQ(packet.print(text), 22);
+			REQUIRE_EQ(packet.length(), 32);
+			REQUIRE(packet.isOverflow());
+
+			// Buffer is retained when cleared
+			auto buffer = packet.getBuffer();
+			packet.clear();
+			REQUIRE_EQ(packet.length(), 0);
+			REQUIRE(!packet.isOverflow());
+			REQUIRE(packet.getBuffer() == buffer);
+
+			// Write directly
+			memcpy(buffer, "ABCD", 4);
+			REQUIRE(packet.setLength(4));
+			REQUIRE_EQ(packet.length(), 4);
+			REQUIRE(!packet.setLength(33));
+		}
+
+		if(!WifiStation.isConnected()) {
+			Serial.println(_F("No network, skipping send tests"));
+			return;
+		}
+
+		TEST_CASE("sendToMany")
+		{
+			server.setPacketCallback([this](UdpConnection&, UdpPacket& packet) {
+				auto data = packet.getData();
+				REQUIRE(data != nullptr);
+				REQUIRE_EQ(packet.length(), sizeof(sample));
+				REQUIRE(memcmp(data, sample, sizeof(sample)) == 0);
+				if(++receiveCount == destinationCount) {
+					System.queueCallback([this]() { resendBuilder(); });
+				}
+			});
+			REQUIRE(server.listen(port));
+
+			UdpDestination destinations[destinationCount];
+			for(auto& dest : destinations) {
+				dest = UdpDestination{WifiStation.getIP(), port};
+			}
+			for(unsigned i = 0; i < sizeof(sample); ++i) {
+				sample[i] = i;
+			}
+			REQUIRE_EQ(client.sendToMany(destinations, destinationCount, sample, sizeof(sample)), destinationCount);
+
+			pending();
+		}
+	}
+
+	/*
+	 * Send the same builder twice: headers prepended by lwIP must be dropped before the buffer is re-used
+	 */
+	void resendBuilder()
+	{
+		receiveCount = 0;
+		server.setPacketCallback([this](UdpConnection&, UdpPacket& packet) {
+			String expected = F("Packet ");
+			expected += receiveCount;
+			REQUIRE_EQ(packet.length(), expected.length());
+			REQUIRE(memcmp(packet.getData(), expected.c_str(), expected.length()) == 0);
+			if(++receiveCount == 2) {
+				complete();
+			}
+		});
+
+		UdpPacketBuilder packet(32);
+		for(unsigned i = 0; i < 2; ++i) {
+			packet.print(_F("Packet "));
+			packet.print(i);
+			REQUIRE(client.sendPacketTo(WifiStation.getIP(), port, packet));
+			REQUIRE_EQ(packet.length(), 0);
+		}
+
+#ifdef ARCH_HOST
+		/*
+		 * Nothing should be at this local address, so lwIP queues the buffer by reference pending ARP resolution.
+		 * The builder must then leave it alone and allocate another.
+		 */
+		IpAddress unresolved = WifiStation.getIP();
+		unresolved[3] = (unresolved[3] == 253) ? 252 : 253;
+		auto buffer = packet.getBuffer();
+		REQUIRE(buffer != nullptr);
+		packet.print(_F("Queued"));
+		REQUIRE(client.sendPacketTo(unresolved, port, packet));
+		REQUIRE_EQ(packet.length(), 0);
+		REQUIRE(packet.getBuffer() != buffer);
+#endif
+	}
+
+private:
+	static constexpr uint16_t port{9877};
+	static constexpr unsigned destinationCount{4};
+	UdpConnection server;
+	UdpConnection client;
+	uint8_t sample[200];
+	unsigned receiveCount{0};
+};
+
+void REGISTER_TEST(Udp)
+{
+	registerGroup<UdpTest>();
+}
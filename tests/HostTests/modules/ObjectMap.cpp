@@ -19,6 +19,32 @@ public:
 };
 
 using TestMap = ObjectMap<String, TestClass>;
+using HashedTestMap = ObjectMap<String, TestClass, HashMapHash<String>>;
+
+template <typename Map> void benchmarkLookup(const String& description, unsigned entryCount)
+{
+	Map map;
+	Vector<String> keys(entryCount);
+	for(unsigned i = 0; i < entryCount; ++i) {
+		String key = "Object " + String(i);
+		map[key] = new TestClass;
+		keys.add(key);
+	}
+
+	const unsigned lookupCount{4096};
+	unsigned found{0};
+	CpuCycleTimer timer;
+	for(unsigned n = 0; n < lookupCount; ++n) {
+		if(map.find(keys[n % entryCount]) != nullptr) {
+			++found;
+		}
+	}
+	auto elapsed = timer.elapsedTime();
+	REQUIRE_EQ(found, lookupCount);
+
+	Serial << description << ", " << entryCount << " entries: " << lookupCount << " lookups took "
+		   << elapsed.toString() << endl;
+}
 
 class ObjectMapTest : public TestGroup
 {
@@ -89,6 +115,39 @@ public:
 			REQUIRE(map.count() == 0);
 			REQUIRE(objectCount == 0);
 		}
+
+		TEST_CASE("Hashed map")
+		{
+			HashedTestMap hashedMap;
+			for(unsigned i = 0; i < 20; ++i) {
+				hashedMap["Object " + String(i)] = new TestClass;
+			}
+			REQUIRE(hashedMap.count() == 20);
+			REQUIRE(objectCount == 20);
+			REQUIRE(hashedMap.indexOf("Object 19") == 19);
+
+			delete hashedMap.extract("Object 4");
+			REQUIRE(hashedMap["Object 4"] == nullptr);
+			REQUIRE(hashedMap.indexOf("Object 19") == 18);
+			REQUIRE(hashedMap.remove("Object 19"));
+			REQUIRE(!hashedMap.contains("Object 19"));
+			REQUIRE(hashedMap.count() == 18);
+			REQUIRE(objectCount == 18);
+
+			hashedMap["Object 4"] = new TestClass;
+			REQUIRE(hashedMap.indexOf("Object 4") == 18);
+
+			hashedMap.clear();
+			REQUIRE(objectCount == 0);
+		}
+
+		TEST_CASE("Lookup performance")
+		{
+			for(auto entryCount : {8, 32, 256}) {
+				benchmarkLookup<TestMap>(F("Linear"), entryCount);
+				benchmarkLookup<HashedTestMap>(F("Hashed"), entryCount);
+			}
+		}
 	}
 };
 
@@ -25,6 +25,71 @@ public:
 		{
 			cycleFlash();
 		}
+
+		TEST_CASE("Path lookup benchmark")
+		{
+			benchmarkLookup();
+		}
+	}
+
+	/*
+	 * Time stat() and open() for a set of files, as when serving web assets.
+	 * The first pass includes building the path index.
+	 */
+	void benchmarkLookup()
+	{
+		constexpr unsigned fileCount{32};
+		constexpr unsigned passCount{5};
+
+		auto getName = [](unsigned i) -> String {
+			String name = F("asset");
+			name += i;
+			return name;
+		};
+
+		for(unsigned i = 0; i < fileCount; ++i) {
+			auto name = getName(i);
+			REQUIRE_EQ(fileSetContent(name, name), int(name.length()));
+		}
+
+		for(unsigned pass = 0; pass < passCount; ++pass) {
+			ElapseTimer timer;
+			for(unsigned i = 0; i < fileCount; ++i) {
+				auto name = getName(i);
+				FileStat stat;
+				REQUIRE_EQ(fileStats(name, stat), FS_OK);
+				REQUIRE_EQ(stat.size, name.length());
+			}
+			auto statTime = timer.elapsedTime();
+
+			timer.start();
+			for(unsigned i = 0; i < fileCount; ++i) {
+				auto f = fileOpen(getName(i));
+				REQUIRE(f >= 0);
+				fileClose(f);
+			}
+			auto openTime = timer.elapsedTime();
+
+			Serial << _F("Pass #") << pass << _F(": stat ") << statTime / fileCount << _F("us, open ")
+				   << openTime / fileCount << _F("us per file") << endl;
+		}
+
+		FileStat stat;
+		REQUIRE(fileStats(F("missing"), stat) < 0);
+
+		// Index must track changes
+		REQUIRE_EQ(fileRename(getName(0), F("renamed")), FS_OK);
+		REQUIRE(fileStats(getName(0), stat) < 0);
+		REQUIRE_EQ(fileStats(F("renamed"), stat), FS_OK);
+		REQUIRE_EQ(fileSetContent(F("renamed"), F("longer content")), 14);
+		REQUIRE_EQ(fileStats(F("renamed"), stat), FS_OK);
+		REQUIRE_EQ(stat.size, 14U);
+		REQUIRE_EQ(fileDelete(F("renamed")), FS_OK);
+		REQUIRE(fileStats(F("renamed"), stat) < 0);
+
+		for(unsigned i = 1; i < fileCount; ++i) {
+			fileDelete(getName(i));
+		}
 	}
 
 	/*
@@ -4,8 +4,10 @@
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/XorOutputStream.h>
 #include <Data/Stream/SharedMemoryStream.h>
+#include <Data/Stream/DeflateStream.h>
 #include <Data/WebHelpers/base64.h>
 #include <malloc_count.h>
+#include <uzlib.h>
 
 #ifndef DISABLE_NETWORK
 #include <Data/Stream/ChunkedStream.h>
@@ -177,6 +179,33 @@ public:
 			SharedMemoryStream stream(data, 18);
 		}
 
+		TEST_CASE("DeflateStream")
+		{
+			String content;
+			for(unsigned i = 0; i < 200; ++i) {
+				content += F("{\"sensor\":\"temp");
+				content += i % 7;
+				content += F("\",\"value\":");
+				content += (i * 37) % 1000;
+				content += F(",\"time\":");
+				content += 1600000000 + i * 60;
+				content += F("},");
+			}
+
+			for(auto format : {DeflateStream::Format::zlib, DeflateStream::Format::gzip}) {
+				DeflateStream stream(new MemoryDataStream(String(content)), format);
+				MemoryDataStream mem;
+				mem.copyFrom(&stream, 256);
+				String compressed;
+				REQUIRE(mem.moveString(compressed));
+				debug_i("Compressed %u bytes to %u", content.length(), compressed.length());
+				REQUIRE_EQ(stream.getInputLength(), content.length());
+				REQUIRE_EQ(stream.getOutputLength(), compressed.length());
+				REQUIRE(compressed.length() * 2 < content.length());
+				REQUIRE(inflate(compressed, format) == content);
+			}
+		}
+
 		auto memStart = MallocCount::getCurrent();
 		// auto memStart = system_get_free_heap_size();
 
@@ -219,6 +248,32 @@ public:
 	}
 
 private:
+	String inflate(const String& data, DeflateStream::Format format)
+	{
+		// Back-references never exceed history plus one window
+		std::unique_ptr<uint8_t[]> dict(new uint8_t[2 * DEFLATE_STREAM_WINDOW_SIZE]);
+		uzlib_uncomp d{};
+		uzlib_init();
+		uzlib_uncompress_init(&d, dict.get(), 2 * DEFLATE_STREAM_WINDOW_SIZE);
+		d.source = reinterpret_cast<const uint8_t*>(data.c_str());
+		d.source_limit = d.source + data.length();
+		int res = (format == DeflateStream::Format::gzip) ? uzlib_gzip_parse_header(&d) : uzlib_zlib_parse_header(&d);
+		if(res < 0) {
+			return nullptr;
+		}
+
+		String s;
+		uint8_t buffer[256];
+		do {
+			d.dest = buffer;
+			d.dest_limit = buffer + sizeof(buffer);
+			res = uzlib_uncompress_chksum(&d);
+			s.concat(reinterpret_cast<const char*>(buffer), d.dest - buffer);
+		} while(res == TINF_OK);
+
+		return (res == TINF_DONE) ? s : nullptr;
+	}
+
 	void check(TemplateStream& stream, const FlashString& ref)
 	{
 		MemoryDataStream mem;
@@ -1,5 +1,11 @@
 #include <HostTests.h>
 #include <esp_spi_flash.h>
+#include <malloc_count.h>
+
+#if defined(ARCH_HOST) && defined(__linux__)
+#include <hostlib/reactor.h>
+#include <unistd.h>
+#endif
 
 /*
  * Various system functions must be available for all architectures.
@@ -18,6 +24,39 @@ public:
 			REQUIRE_NEQ(system_get_free_heap_size(), 0);
 		}
 
+#if ENABLE_MALLOC_COUNT
+		TEST_CASE("Heap tags")
+		{
+			auto tag = MallocCount::registerTag("test");
+			REQUIRE_NEQ(tag, MallocCount::Tags::untagged);
+			REQUIRE_EQ(MallocCount::registerTag("test"), tag);
+			REQUIRE(strcmp(MallocCount::getTagName(tag), "test") == 0);
+
+			auto& stats = MallocCount::getTagStats(tag);
+			auto count = stats.count;
+			void* ptr;
+			{
+				MallocCount::TagScope scope(tag);
+				REQUIRE_EQ(MallocCount::getTag(), tag);
+				ptr = malloc(100);
+				REQUIRE_EQ(stats.current, 100U);
+				{
+					MallocCount::TagScope nested(MallocCount::Tags::http);
+					delete new char[50];
+				}
+				ptr = realloc(ptr, 200);
+			}
+			REQUIRE_EQ(MallocCount::getTag(), MallocCount::Tags::untagged);
+			REQUIRE_EQ(stats.current, 200U);
+			REQUIRE(stats.peak >= 200U);
+			REQUIRE_EQ(stats.count, count + 2);
+			free(ptr);
+			REQUIRE_EQ(stats.current, 0U);
+
+			MallocCount::printTagStats(Serial);
+		}
+#endif
+
 		TEST_CASE("Identification")
 		{
 			REQUIRE_NEQ(String(system_get_sdk_version()), nullptr);
@@ -39,6 +78,98 @@ public:
 			system_soft_wdt_feed();
 		}
 
+#ifdef ARCH_HOST
+		TEST_CASE("Task queue overflow")
+		{
+			auto dropped = System.getDroppedTaskCount();
+			auto callback = [](void* param) { ++static_cast<SystemTest*>(param)->taskCallbackCount; };
+			while(System.queueCallback(callback, this)) {
+				++tasksPosted;
+				REQUIRE(tasksPosted <= 256);
+			}
+			debug_i("Posted %u, max %u", tasksPosted, System.getMaxTaskCount());
+			REQUIRE_EQ(System.getDroppedTaskCount(), dropped + 1);
+
+			host_task_queue_stats_t stats;
+			REQUIRE(host_get_task_queue_stats(USER_TASK_PRIO_1, &stats));
+			REQUIRE_EQ(stats.count, stats.length);
+			REQUIRE(System.getMaxTaskCount() >= stats.length);
+		}
+#endif
+
+#if defined(ARCH_HOST) && defined(__linux__)
+		TEST_CASE("I/O reactor")
+		{
+			auto reactor = CReactor::instance();
+			REQUIRE(reactor != nullptr);
+
+			int fds[2];
+			REQUIRE_EQ(pipe(fds), 0);
+			CSemaphore sem;
+			unsigned readCount{0};
+			// Level-triggered, so called once for each byte
+			REQUIRE(reactor->add(fds[0], REACTOR_EVENT_READ, [&](unsigned events) {
+				char c;
+				if((events & REACTOR_EVENT_READ) && read(fds[0], &c, 1) == 1) {
+					++readCount;
+				}
+				sem.post();
+			}));
+
+			REQUIRE_EQ(write(fds[1], "abc", 3), 3);
+			for(unsigned i = 0; i < 3; ++i) {
+				REQUIRE(sem.timedwait(1000000));
+			}
+			REQUIRE_EQ(readCount, 3);
+
+			// Disabled descriptor must not be reported
+			REQUIRE(reactor->modify(fds[0], 0));
+			REQUIRE_EQ(write(fds[1], "d", 1), 1);
+			REQUIRE(!sem.timedwait(50000));
+			REQUIRE(reactor->modify(fds[0], REACTOR_EVENT_READ));
+			REQUIRE(sem.timedwait(1000000));
+			REQUIRE_EQ(readCount, 4);
+
+			reactor->remove(fds[0]);
+			close(fds[0]);
+			close(fds[1]);
+		}
+#endif
+
+		TEST_CASE("Deferred delegates")
+		{
+			// On Host the task queue is full at this point, so callbacks get spilled
+			const unsigned delegateCount{40};
+			auto spilled = System.getTaskDelegateStats().spilled;
+			for(unsigned i = 0; i < delegateCount; ++i) {
+				bool ok = System.queueCallback([this, i]() {
+					// Must be called in order
+					REQUIRE_EQ(delegateCallbackCount, i);
+					++delegateCallbackCount;
+				});
+				REQUIRE(ok);
+			}
+
+			auto stats = System.getTaskDelegateStats();
+			Serial << _F("Delegate pool capacity ") << stats.capacity << _F(", max used ") << stats.maxUsed
+				   << _F(", spilled ") << stats.spilled << endl;
+			REQUIRE(stats.maxUsed <= stats.capacity);
+			REQUIRE(stats.spilled > spilled);
+
+			// All queued callbacks must still run
+			auto timer = new AutoDeleteTimer;
+			timer->initializeMs<100>([this]() {
+				REQUIRE_EQ(taskCallbackCount, tasksPosted);
+				REQUIRE_EQ(delegateCallbackCount, delegateCount);
+				auto stats = System.getTaskDelegateStats();
+				REQUIRE_EQ(stats.used, 0);
+				REQUIRE_EQ(stats.spillCount, 0);
+				complete();
+			});
+			timer->startOnce();
+			pending();
+		}
+
 #ifndef ARCH_HOST
 		TEST_CASE("System restart")
 		{
@@ -70,6 +201,11 @@ public:
 		}
 #endif
 	}
+
+private:
+	unsigned tasksPosted{0};
+	unsigned taskCallbackCount{0};
+	unsigned delegateCallbackCount{0};
 };
 
 void REGISTER_TEST(System)
@@ -3,6 +3,7 @@
 #include <Data/Stream/MemoryDataStream.h>
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/SectionTemplate.h>
+#include <Data/Stream/CompiledTemplateStream.h>
 
 #ifdef ARCH_HOST
 #include <IFS/Host/FileSystem.h>
@@ -22,6 +23,9 @@ DEFINE_FSTR_LOCAL(template3_1, "<html><head><title>Document Title</title><style>
 DEFINE_FSTR_LOCAL(template4, "{\"value\":12,\"var1\":\"{var1}\"}")
 DEFINE_FSTR_LOCAL(template4_1, "{\"value\":12,\"var1\":\"quoted variable\"}")
 
+DEFINE_FSTR_LOCAL(template5, "{Name} and {name} differ, {NAME} is unset")
+DEFINE_FSTR_LOCAL(template5_1, "upper and lower differ, {NAME} is unset")
+
 class TemplateStreamTest : public TestGroup
 {
 public:
@@ -134,6 +138,118 @@ public:
 			check(tmpl, Resource::ut_template1_out1_rst);
 		}
 
+		TEST_CASE("Compiled template")
+		{
+			CompiledTemplate compiled;
+			{
+				FlashMemoryStream src(template1);
+				REQUIRE(compiled.compile(src));
+			}
+			REQUIRE_EQ(compiled.variables().count(), 3U);
+			REQUIRE_EQ(compiled.sourceLength(), template1.length());
+			REQUIRE_EQ(compiled.getVariableId("var3"), 2);
+			REQUIRE_EQ(compiled.getVariableId("var4"), -1);
+
+			auto getValue = [](unsigned id) -> String {
+				switch(id) {
+				case 0:
+					return F("value #1");
+				case 1:
+					return F("value #2");
+				default:
+					return nullptr;
+				}
+			};
+
+			{
+				CompiledTemplateStream tmpl(compiled, new FlashMemoryStream(template1));
+				tmpl.onGetValue(getValue);
+				check(tmpl, template1, template1_1);
+			}
+
+			MemoryDataStream mem;
+			REQUIRE(compiled.saveTo(mem));
+			CompiledTemplate loaded;
+			REQUIRE(loaded.loadFrom(mem));
+			REQUIRE_EQ(loaded.count(), compiled.count());
+
+			CompiledTemplateStream tmpl(loaded, new FlashMemoryStream(template1));
+			tmpl.setVar("var3", "[value #3]");
+			tmpl.onGetValue(getValue);
+			check(tmpl, template1, template1_2);
+
+			// Render again in small fragments
+			tmpl.seekFrom(0, SeekOrigin::Start);
+			String s;
+			char buf[7];
+			while(!tmpl.isFinished()) {
+				auto count = tmpl.readMemoryBlock(buf, sizeof(buf));
+				s.concat(buf, count);
+				tmpl.seek(count);
+			}
+			REQUIRE(template1_2 == s);
+		}
+
+		TEST_CASE("Compiled template (HTML, JSON)")
+		{
+			CompiledTemplate compiled;
+			FlashMemoryStream src3(template3);
+			REQUIRE(compiled.compile(src3));
+			{
+				CompiledTemplateStream tmpl(compiled, new FlashMemoryStream(template3));
+				tmpl.setVar("title", "Document Title");
+				check(tmpl, template3, template3_1);
+			}
+
+			FlashMemoryStream src4(template4);
+			REQUIRE(compiled.compile(src4));
+			{
+				CompiledTemplateStream tmpl(compiled, new FlashMemoryStream(template4));
+				tmpl.setVar("var1", "quoted variable");
+				check(tmpl, template4, template4_1);
+			}
+		}
+
+		TEST_CASE("Compiled template variable names")
+		{
+			CompiledTemplate compiled;
+			FlashMemoryStream src(template5);
+			REQUIRE(compiled.compile(src));
+			REQUIRE_EQ(compiled.variables().count(), 2U);
+			REQUIRE_EQ(compiled.getVariableId("Name"), 0);
+			REQUIRE_EQ(compiled.getVariableId("name"), 1);
+			REQUIRE_EQ(compiled.getVariableId("NAME"), -1);
+
+			CompiledTemplateStream tmpl(compiled, new FlashMemoryStream(template5));
+			tmpl.setVar("Name", "upper");
+			tmpl.setVar("name", "lower");
+			check(tmpl, template5, template5_1);
+		}
+
+		TEST_CASE("Compiled template validation")
+		{
+			CompiledTemplate compiled;
+			FlashMemoryStream src(template1);
+			REQUIRE(compiled.compile(src));
+			MemoryDataStream mem;
+			REQUIRE(compiled.saveTo(mem));
+
+			// Header claims more operations than are present
+			String data;
+			REQUIRE(data.setLength(mem.available()));
+			mem.readBytes(data.begin(), data.length());
+			CompiledTemplate loaded;
+			auto load = [&](uint32_t opCount) {
+				memcpy(&data[8], &opCount, sizeof(opCount));
+				LimitedMemoryStream stream(data.begin(), data.length(), data.length(), false);
+				return loaded.loadFrom(stream);
+			};
+			REQUIRE(!load(compiled.count() + 1));
+			REQUIRE(!load(0x10000000));
+			REQUIRE(load(compiled.count()));
+			REQUIRE_EQ(loaded.count(), compiled.count());
+		}
+
 		auto addChar = [](String& s, char c, size_t count) {
 			auto len = s.length();
 			s.setLength(len + count);
@@ -185,7 +301,7 @@ public:
 	}
 
 private:
-	void check(TemplateStream& stream, const FlashString& tmpl, const FlashString& ref)
+	void check(IDataSourceStream& stream, const FlashString& tmpl, const FlashString& ref)
 	{
 		constexpr size_t maxLen{256};
 		String s = stream.readString(maxLen);
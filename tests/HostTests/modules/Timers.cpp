@@ -371,6 +371,91 @@ public:
 	}
 };
 
+/*
+ * Arm, re-arm and disarm large numbers of timers to check timer queue scalability
+ */
+class TimerStressTest : public TestGroup
+{
+public:
+#ifdef ARCH_HOST
+	static constexpr unsigned timerCount{5000};
+#else
+	static constexpr unsigned timerCount{200};
+#endif
+	static constexpr unsigned rearmCount{10};
+	static constexpr unsigned checkCount{100};
+
+	TimerStressTest() : TestGroup(_F("Timer stress"))
+	{
+	}
+
+	void execute() override
+	{
+		timers.reset(new SimpleTimer[timerCount]);
+
+		// Intervals long enough that none fire during profiling
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].initializeMs(60000 + os_random() % 60000, timerIdle);
+		}
+
+		ElapseTimer timer;
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].startOnce();
+		}
+		auto armTime = timer.elapsedTime();
+
+		timer.start();
+		for(unsigned n = 0; n < rearmCount; ++n) {
+			for(unsigned i = 0; i < timerCount; ++i) {
+				timers[i].startOnce();
+			}
+		}
+		auto rearmTime = timer.elapsedTime();
+
+		timer.start();
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].stop();
+		}
+		auto disarmTime = timer.elapsedTime();
+
+		Serial << timerCount << _F(" timers") << endl;
+		Serial << _F("  arm: ") << armTime.toString() << endl;
+		Serial << _F("  re-arm x") << rearmCount << _F(": ") << rearmTime.toString() << endl;
+		Serial << _F("  disarm: ") << disarmTime.toString() << endl;
+
+		// Timers must still expire correctly amongst a large queue
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].initializeMs(60000 + os_random() % 60000, timerIdle).startOnce();
+		}
+		for(unsigned i = 0; i < checkCount; ++i) {
+			timers[i].initializeMs(10 + os_random() % 200, timerExpired, this).startOnce();
+		}
+
+		Serial << _F("Waiting for ") << checkCount << _F(" timers to expire") << endl;
+		pending();
+	}
+
+	static void timerIdle(void*)
+	{
+	}
+
+	static void timerExpired(void* arg)
+	{
+		auto self = static_cast<TimerStressTest*>(arg);
+		++self->expiredCount;
+		if(self->expiredCount == checkCount) {
+			System.queueCallback([self]() {
+				self->timers.reset();
+				self->complete();
+			});
+		}
+	}
+
+private:
+	std::unique_ptr<SimpleTimer[]> timers;
+	unsigned expiredCount{0};
+};
+
 void REGISTER_TEST(Timers)
 {
 	registerGroup<CallbackTimerApiTest<Timer1TestApi>>();
@@ -382,4 +467,5 @@ void REGISTER_TEST(Timers)
 	registerGroup<CallbackTimerSpeedTest<Timer>>();
 
 	registerGroup<CallbackTimerTest>();
+	registerGroup<TimerStressTest>();
 }
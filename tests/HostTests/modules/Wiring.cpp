@@ -42,6 +42,50 @@ template <typename T> void fillMap(T& map)
 	Serial << "fillMap heap " << MallocCount::getCurrent() - startMem << endl;
 }
 
+template <typename Map> void benchmarkLookup(const String& description, unsigned entryCount)
+{
+	auto startMem = MallocCount::getCurrent();
+	Map map;
+	for(unsigned i = 0; i < entryCount; ++i) {
+		map["Key " + String(i)] = String(i);
+	}
+
+	// Build keys in advance so only lookup time is measured
+	Vector<String> keys(entryCount);
+	for(unsigned i = 0; i < entryCount; ++i) {
+		keys.add("Key " + String(i));
+	}
+
+	const unsigned lookupCount{4096};
+	unsigned found{0};
+	CpuCycleTimer timer;
+	for(unsigned n = 0; n < lookupCount; ++n) {
+		auto i = n % entryCount;
+		if(map.indexOf(keys[i]) == int(i)) {
+			++found;
+		}
+	}
+	auto elapsed = timer.elapsedTime();
+	REQUIRE_EQ(found, lookupCount);
+
+	Serial << description << ", " << entryCount << " entries: " << lookupCount << " lookups took "
+		   << elapsed.toString() << ", heap " << MallocCount::getCurrent() - startMem << endl;
+}
+
+/*
+ * Build a container using `fill`, reporting number of heap allocations and time taken
+ */
+template <typename Fill> size_t measureFill(const String& description, Fill fill)
+{
+	auto startCount = MallocCount::getAllocCount();
+	CpuCycleTimer timer;
+	fill();
+	auto elapsed = timer.elapsedTime();
+	auto allocCount = MallocCount::getAllocCount() - startCount;
+	Serial << description << ": " << allocCount << " allocations, " << elapsed.toString() << endl;
+	return allocCount;
+}
+
 } // namespace
 
 class WiringTest : public TestGroup
@@ -115,6 +159,51 @@ public:
 				 [](auto& map) { map.sort([](const auto& e1, const auto& e2) { return e1.value() < e2.value(); }); });
 		}
 
+		TEST_CASE("Hashed HashMap<String, unsigned>")
+		{
+			HashMap<String, unsigned, HashMapHash<String>> map;
+			for(unsigned i = 0; i < 32; ++i) {
+				map[String(i)] = i;
+			}
+			REQUIRE_EQ(map.count(), 32);
+
+			// Iteration order is preserved
+			unsigned i = 0;
+			for(auto e : map) {
+				REQUIRE_EQ(e.key(), String(i));
+				REQUIRE_EQ(e.value(), i);
+				++i;
+			}
+
+			map.remove("3");
+			map.removeAt(0);
+			REQUIRE_EQ(map.count(), 30);
+			REQUIRE(!map.contains("0"));
+			REQUIRE(!map.contains("3"));
+			REQUIRE_EQ(map.indexOf("31"), 29);
+			REQUIRE_EQ(map["20"], 20U);
+
+			map.sort([](const auto& e1, const auto& e2) { return e1.value() > e2.value(); });
+			REQUIRE_EQ(map.indexOf("31"), 0);
+			REQUIRE_EQ(map.indexOf("1"), 29);
+
+			map.keyAt(0) = "thirty-one";
+			REQUIRE(!map.contains("31"));
+			REQUIRE_EQ(map.indexOf("thirty-one"), 0);
+
+			map.clear();
+			REQUIRE(!map.contains("1"));
+			REQUIRE_EQ(map.count(), 0);
+		}
+
+		TEST_CASE("HashMap lookup performance")
+		{
+			for(auto entryCount : {8, 32, 256}) {
+				benchmarkLookup<HashMap<String, String>>(F("Linear"), entryCount);
+				benchmarkLookup<HashMap<String, String, HashMapHash<String>>>(F("Hashed"), entryCount);
+			}
+		}
+
 		TEST_CASE("std::map<MimeType, size_t>")
 		{
 			std::map<MimeType, uint16_t> map;
@@ -229,11 +318,11 @@ public:
 			REQUIRE(!vector.insertElementAt(99, 35));
 			REQUIRE(vector.insertElementAt(99, 32));
 			REQUIRE(vector[32] == 99);
-			REQUIRE_EQ(vector.capacity(), 42);
+			REQUIRE_EQ(vector.capacity(), 48);
 
 			REQUIRE(vector.setSize(3));
 			REQUIRE_EQ(vector.count(), 3);
-			REQUIRE_EQ(vector.capacity(), 42);
+			REQUIRE_EQ(vector.capacity(), 48);
 
 			vector.trimToSize();
 			REQUIRE_EQ(vector.capacity(), 3);
@@ -271,6 +360,82 @@ public:
 			Serial.println();
 		}
 
+		TEST_CASE("Container growth")
+		{
+			const unsigned elementCount{100};
+			char buf[32];
+			auto makeValue = [&](unsigned i) { return m_snprintf(buf, sizeof(buf), "Element value %u", i); };
+
+			unsigned reallocCount{0};
+			auto vectorCopy = measureFill(F("Vector<String>, add copy"), [&]() {
+				Vector<String> vector;
+				for(unsigned i = 0; i < elementCount; ++i) {
+					String value(buf, makeValue(i));
+					auto capacity = vector.capacity();
+					vector.add(value);
+					if(vector.capacity() != capacity) {
+						++reallocCount;
+					}
+				}
+				REQUIRE_EQ(vector.count(), elementCount);
+			});
+			auto vectorMove = measureFill(F("Vector<String>, add move"), [&]() {
+				Vector<String> vector;
+				for(unsigned i = 0; i < elementCount; ++i) {
+					vector.add(String(buf, makeValue(i)));
+				}
+				REQUIRE_EQ(vector.count(), elementCount);
+			});
+			auto vectorEmplace = measureFill(F("Vector<String>, reserved + emplace"), [&]() {
+				Vector<String> vector(elementCount);
+				for(unsigned i = 0; i < elementCount; ++i) {
+					vector.emplace(buf, makeValue(i));
+				}
+				REQUIRE_EQ(vector.count(), elementCount);
+				REQUIRE(vector[elementCount - 1].startsWith("Element value"));
+			});
+
+			// A fixed increment of 10 would require 9 reallocations
+			Serial << "Vector reallocations: " << reallocCount << endl;
+			REQUIRE(reallocCount < (elementCount - 10) / 10);
+
+			auto mapAssign = measureFill(F("HashMap<String, String>, operator[] copy"), [&]() {
+				HashMap<String, String> map;
+				for(unsigned i = 0; i < elementCount; ++i) {
+					String key(buf, makeValue(i));
+					String value(buf, makeValue(elementCount - i));
+					map[key] = value;
+				}
+				REQUIRE_EQ(map.count(), elementCount);
+			});
+			auto mapSet = measureFill(F("HashMap<String, String>, allocate + set move"), [&]() {
+				HashMap<String, String> map;
+				REQUIRE(map.allocate(elementCount));
+				for(unsigned i = 0; i < elementCount; ++i) {
+					String key(buf, makeValue(i));
+					String value(buf, makeValue(elementCount - i));
+					map.set(std::move(key), std::move(value));
+				}
+				REQUIRE_EQ(map.count(), elementCount);
+				REQUIRE_EQ(map.capacity(), elementCount);
+				map.removeAt(0);
+				map.trimToSize();
+				REQUIRE_EQ(map.capacity(), elementCount - 1);
+			});
+
+#if ENABLE_MALLOC_COUNT
+			REQUIRE(vectorMove < vectorCopy);
+			REQUIRE(vectorEmplace < vectorMove);
+			REQUIRE(mapSet < mapAssign);
+#else
+			(void)vectorCopy;
+			(void)vectorMove;
+			(void)vectorEmplace;
+			(void)mapAssign;
+			(void)mapSet;
+#endif
+		}
+
 		TEST_CASE("MacAddress")
 		{
 			const uint8_t refOctets[]{0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};